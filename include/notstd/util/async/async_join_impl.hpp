@@ -1,7 +1,9 @@
 #pragma once
-#include <mutex>
+#include <boost/mp11/algorithm.hpp>
 #include <optional>
 #include <notstd/util/async/cheap_work_guard.hpp>
+#include <notstd/util/async/detail/event_state.hpp>
+#include <notstd/util/async/executor_traits.hpp>
 #include <notstd/util/async/poly_handler.hpp>
 #include <tuple>
 
@@ -17,9 +19,19 @@ namespace notstd::util::async
         }
     };
 
+    /// Completes a single waiter once every one of Events has been set, or
+    /// with an error once cancelled.
+    ///
+    /// If the executor is single-threaded (a strand, or an io_context with a
+    /// concurrency hint of 1), all calls must be made from handlers running
+    /// on it and the state is updated without synchronisation. Otherwise any
+    /// member may be called from any thread, and signalling costs a few
+    /// atomic operations.
     template < class Executor = net::executor, class... Events >
     struct async_join_impl : async_join_impl_base
     {
+        static_assert(sizeof...(Events) <= 28, "too many events");
+
         using executor_type = Executor;
 
         template < class OtherExecutor >
@@ -64,6 +76,30 @@ namespace notstd::util::async
       private:
         using event_tuple = std::tuple< std::optional< Events >... >;
 
+        enum : detail::event_state::value_type
+        {
+            waiting_bit      = 1,
+            complete_bit     = 2,
+            cancel_claim_bit = 4,   // a cancel is writing error_
+            error_bit        = 8,   // error_ is valid
+            first_event_bit  = 16
+        };
+
+        static constexpr auto all_events =
+            ((detail::event_state::value_type(1) << sizeof...(Events)) - 1) *
+            first_event_bit;
+
+        template < class Event >
+        static constexpr auto event_bit =
+            detail::event_state::value_type(first_event_bit)
+            << boost::mp11::mp_find< boost::mp11::mp_list< Events... >,
+                                     Event >::value;
+
+        static auto all_set(detail::event_state::value_type s) -> bool
+        {
+            return (s & all_events) == all_events;
+        }
+
         template < class Handler, class... Guards >
         struct wait_op_model
         {
@@ -99,19 +135,14 @@ namespace notstd::util::async
       private:
         Executor exec_;
 
-        std::mutex                               mutex_;
+        detail::event_state                      state_;
         std::tuple< std::optional< Events >... > events_;
-        poly_handler< void(error_code) >         handler_;
-        error_code                               error_;
-        enum state_code
-        {
-            not_waiting,
-            waiting,
-            complete,
-            error
-        } state_ = not_waiting;
+        poly_handler< void(error_code) >         handler_;   // if waiting_bit
+        error_code                               error_;     // if error_bit
     };
 
+    /// A single event which completes one waiter, with the same threading
+    /// rules as async_join_impl
     template < class Executor = net::io_executor >
     struct async_event
     {
@@ -127,6 +158,7 @@ namespace notstd::util::async
 
         async_event(executor_type exec)
         : exec_(exec)
+        , state_(executor_traits< Executor >::is_single_threaded(exec_))
         {
         }
 
@@ -140,25 +172,9 @@ namespace notstd::util::async
 
         /// Cancel any outstanding wait operation and move the impl to the error
         /// state
-        auto cancel(error_code ec = net::error::operation_aborted) -> void
-        {
-            auto l = std::unique_lock(mutex_);
-            error_ = ec;
-            if (handler_.has_value())
-                handler_.post_completion(error_);
-        }
+        auto cancel(error_code ec = net::error::operation_aborted) -> void;
 
-        auto set_event() -> void
-        {
-            auto l = std::unique_lock(mutex_);
-            assert(not event_set_);
-            event_set_ = true;
-            if (handler_.has_value())
-            {
-                assert(not error_);
-                handler_.post_completion(error_);
-            }
-        }
+        auto set_event() -> void;
 
       private:
         template < class Handler, class... Guards >
@@ -194,12 +210,19 @@ namespace notstd::util::async
         }
 
       private:
+        enum : detail::event_state::value_type
+        {
+            waiting_bit      = 1,
+            set_bit          = 2,
+            cancel_claim_bit = 4,   // a cancel is writing error_
+            error_bit        = 8    // error_ is valid
+        };
+
         Executor exec_;
 
-        std::mutex                       mutex_;
-        bool                             event_set_ = false;
-        poly_handler< void(error_code) > handler_;
-        error_code                       error_;
+        detail::event_state              state_;
+        poly_handler< void(error_code) > handler_;   // if waiting_bit
+        error_code                       error_;     // if error_bit
     };
 
 }   // namespace notstd::util::async
@@ -212,6 +235,7 @@ namespace notstd::util::async
     template < class Executor, class... Events >
     async_join_impl< Executor, Events... >::async_join_impl(executor_type exec)
     : exec_(std::move(exec))
+    , state_(executor_traits< Executor >::is_single_threaded(exec_))
     , events_()
     {
     }
@@ -224,66 +248,59 @@ namespace notstd::util::async
         -> BOOST_ASIO_INITFN_RESULT_TYPE(CompletionHandler, void(error_code))
     {
         auto initiate = [this](auto &&handler) {
-            assert(not handler_.has_value());
-
             auto exec = net::get_associated_executor(handler, get_executor());
 
-            auto l = std::unique_lock(mutex_);
-            switch (state_)
+            auto s = state_.load();
+            if (s & waiting_bit)
             {
-            case waiting:
                 assert(!"logic error");
-                l.unlock();
                 net::post(exec, [handler = std::move(handler)]() mutable {
                     handler(net::error::operation_not_supported);
                 });
-                break;
-
-            case not_waiting:
-                if (triggered())
-                {
-                    l.unlock();
-                    net::post(exec, [handler = std::move(handler)]() mutable {
-                        handler(error_code());
-                    });
-                }
-                else
-                {
-                    if (exec == get_executor())
-                    {
-                        // only need a work guard on one executor
-                        if constexpr (detail::has_get_executor_v< decltype(
-                                          handler) >)
-                            handler_ =
-                                construct_wait_op(std::move(handler),
-                                                  make_cheap_work_guard(exec));
-                        else
-                            handler_ = construct_wait_op(
-                                net::bind_executor(exec, std::move(handler)),
-                                make_cheap_work_guard(exec));
-                    }
-                    else
-                    {
-                        handler_ = construct_wait_op(
-                            std::move(handler),
-                            make_cheap_work_guard(exec),
-                            make_cheap_work_guard(get_executor()));
-                    }
-                    state_ = waiting;
-                }
-                break;
-            case complete:
-                l.unlock();
+                return;
+            }
+            if (s & error_bit)
+            {
+                net::post(exec,
+                          [handler = std::move(handler),
+                           ec      = error_]() mutable { handler(ec); });
+                return;
+            }
+            if (s & complete_bit or all_set(s))
+            {
                 net::post(exec, [handler = std::move(handler)]() mutable {
                     handler(error_code());
                 });
-                break;
+                return;
+            }
 
-            case error:
-                net::post(exec,
-                          [handler = std::move(handler),
-                           ec      = error_]() mutable { handler(ec); });
-                break;
+            if (exec == get_executor())
+            {
+                // only need a work guard on one executor
+                if constexpr (detail::has_get_executor_v< decltype(handler) >)
+                    handler_ = construct_wait_op(std::move(handler),
+                                                 make_cheap_work_guard(exec));
+                else
+                    handler_ = construct_wait_op(
+                        net::bind_executor(exec, std::move(handler)),
+                        make_cheap_work_guard(exec));
+            }
+            else
+            {
+                handler_ =
+                    construct_wait_op(std::move(handler),
+                                      make_cheap_work_guard(exec),
+                                      make_cheap_work_guard(get_executor()));
+            }
+
+            // publish the handler, unless an event or cancel got in first
+            s = state_.transition([](auto s) {
+                return (s & error_bit or all_set(s)) ? s : s | waiting_bit;
+            });
+            if (s & error_bit or all_set(s))
+            {
+                auto h = std::move(handler_);
+                h.post_completion((s & error_bit) ? error_ : error_code());
             }
         };
 
@@ -294,42 +311,23 @@ namespace notstd::util::async
     template < class Executor, class... Events >
     auto async_join_impl< Executor, Events... >::triggered() const -> bool
     {
-//        assert(net::is_correct_thread(get_executor()));
-        bool r = true;
-        boost::mp11::tuple_for_each(events_,
-                                    [&](auto &&e) { r = r && e.has_value(); });
-        return r;
+        return all_set(state_.load());
     }
 
     template < class Executor, class... Events >
     auto async_join_impl< Executor, Events... >::cancel(error_code ec) -> void
     {
-        auto lock = std::unique_lock(mutex_);
-        switch (state_)
+        // the first cancel wins
+        if (state_.set(cancel_claim_bit) & cancel_claim_bit)
+            return;
+
+        error_ = ec;
+        auto s = state_.transition(
+            [](auto s) { return (s | error_bit) & ~waiting_bit; });
+        if (s & waiting_bit)
         {
-        case not_waiting:
-            assert(not handler_.has_value());
-            error_ = ec;
-            state_ = error;
-            break;
-
-        case waiting:
-            assert(handler_.has_value());
-            error_ = ec;
-            state_ = error;
-            [this] {
-                auto h = std::move(handler_);
-                h.post_completion(error_);
-            }();
-            break;
-
-        case error:
-            break;
-
-        case complete:
-            error_ = ec;
-            state_ = error;
-            break;
+            auto h = std::move(handler_);
+            h.post_completion(error_);
         }
     }
 
@@ -337,13 +335,19 @@ namespace notstd::util::async
     template < class Event >
     auto async_join_impl< Executor, Events... >::set_event(Event e) -> void
     {
-        auto  lock = std::unique_lock(mutex_);
-        auto &opt  = get< std::optional< Event > >(events_);
+        auto &opt = get< std::optional< Event > >(events_);
         assert(not opt.has_value());
         opt = std::move(e);
-        if (state_ == waiting and triggered())
+
+        auto completes = [](auto s) {
+            return s & waiting_bit and all_set(s | event_bit< Event >);
+        };
+        auto s = state_.transition([&](auto s) {
+            s |= event_bit< Event >;
+            return completes(s) ? (s & ~waiting_bit) | complete_bit : s;
+        });
+        if (completes(s))
         {
-            state_ = complete;
             auto h = std::move(handler_);
             h.post_completion(error_code());
         }
@@ -353,10 +357,10 @@ namespace notstd::util::async
     template < class Event >
     auto async_join_impl< Executor, Events... >::unset_event() -> void
     {
-        auto  lock = std::unique_lock(mutex_);
-        auto &opt  = get< std::optional< Event > >(events_);
-        assert(opt.has_value());
-        opt.reset();
+        auto s =
+            state_.transition([](auto s) { return s & ~event_bit< Event >; });
+        assert(s & event_bit< Event >);
+        get< std::optional< Event > >(events_).reset();
     }
 
     //
@@ -370,50 +374,54 @@ namespace notstd::util::async
         -> BOOST_ASIO_INITFN_RESULT_TYPE(CompletionHandler, void(error_code))
     {
         auto initiate = [this](auto &&handler) {
-            assert(not handler_.has_value());
-
             auto exec = net::get_associated_executor(handler, get_executor());
 
-            auto l = std::unique_lock(mutex_);
-            if (handler_.has_value())
+            auto s = state_.load();
+            if (s & waiting_bit)
             {
                 assert(!"logic error");
-                l.unlock();
                 net::post(exec, [handler = std::move(handler)]() mutable {
                     handler(net::error::operation_not_supported);
                 });
+                return;
             }
-            else if (error_)
+            if (s & error_bit)
             {
-                auto err = error_;
-                l.unlock();
-                net::post(exec, [handler = std::move(handler), err]() mutable {
-                    handler(err);
-                });
+                net::post(exec,
+                          [handler = std::move(handler),
+                           ec      = error_]() mutable { handler(ec); });
+                return;
             }
-            else if (event_set_)
+            if (s & set_bit)
             {
-                l.unlock();
                 net::post(exec, [handler = std::move(handler)]() mutable {
                     handler(error_code());
                 });
+                return;
             }
-            else
-            {
-                if (exec == get_executor())
-                    if constexpr (detail::has_get_executor_v< decltype(
-                                      handler) >)
-                        handler_ = construct_wait_op(
-                            std::move(handler), make_cheap_work_guard(exec));
-                    else
-                        handler_ = construct_wait_op(
-                            net::bind_executor(exec, std::move(handler)),
-                            make_cheap_work_guard(exec));
+
+            if (exec == get_executor())
+                if constexpr (detail::has_get_executor_v< decltype(handler) >)
+                    handler_ = construct_wait_op(std::move(handler),
+                                                 make_cheap_work_guard(exec));
                 else
                     handler_ = construct_wait_op(
-                        std::move(handler),
-                        make_cheap_work_guard(exec),
-                        make_cheap_work_guard(get_executor()));
+                        net::bind_executor(exec, std::move(handler)),
+                        make_cheap_work_guard(exec));
+            else
+                handler_ =
+                    construct_wait_op(std::move(handler),
+                                      make_cheap_work_guard(exec),
+                                      make_cheap_work_guard(get_executor()));
+
+            // publish the handler, unless the event or a cancel got in first
+            s = state_.transition([](auto s) {
+                return (s & (error_bit | set_bit)) ? s : s | waiting_bit;
+            });
+            if (s & (error_bit | set_bit))
+            {
+                auto h = std::move(handler_);
+                h.post_completion((s & error_bit) ? error_ : error_code());
             }
         };
 
@@ -421,4 +429,34 @@ namespace notstd::util::async
             initiate, token);
     }
 
+    template < class Executor >
+    auto async_event< Executor >::cancel(error_code ec) -> void
+    {
+        // the first cancel wins
+        if (state_.set(cancel_claim_bit) & cancel_claim_bit)
+            return;
+
+        error_ = ec;
+        auto s = state_.transition(
+            [](auto s) { return (s | error_bit) & ~waiting_bit; });
+        if (s & waiting_bit)
+        {
+            auto h = std::move(handler_);
+            h.post_completion(error_);
+        }
+    }
+
+    template < class Executor >
+    auto async_event< Executor >::set_event() -> void
+    {
+        auto s = state_.transition(
+            [](auto s) { return (s | set_bit) & ~waiting_bit; });
+        assert(not(s & set_bit));
+        if (s & waiting_bit)
+        {
+            auto h = std::move(handler_);
+            h.post_completion(error_code());
+        }
+    }
+
 }   // namespace notstd::util::async
\ No newline at end of file
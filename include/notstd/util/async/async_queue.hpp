@@ -1,10 +1,31 @@
 #pragma once
 #include <notstd/util/async/detail/async_queue_impl.hpp>
+#include <notstd/util/async/detail/mpmc_async_queue_impl.hpp>
+#include <notstd/util/async/detail/mpsc_async_queue_impl.hpp>
 #include <notstd/util/net.hpp>
+#include <vector>
 
 namespace notstd::util::async
 {
-    template < class T, class Executor >
+    /// An asynchronous queue of T.
+    /// @tparam T the type of value carried by the queue
+    /// @tparam Executor the queue's default executor
+    /// @tparam Impl the implementation strategy:
+    /// - detail::async_queue_impl (default) serialises every operation on
+    ///   the default executor.
+    /// - detail::mpsc_async_queue_impl links values into a lock-free queue on
+    ///   the pushing thread and only touches the default executor to wake a
+    ///   parked consumer. Prefer it when several threads push to one queue.
+    /// - detail::mpmc_async_queue_impl allows any number of concurrent
+    ///   async_pop operations, from any thread. Each value is handed to the
+    ///   longest waiting consumer on that consumer's own executor. Use it to
+    ///   distribute work from one queue across a pool of consumers.
+    ///
+    /// Except in the mpmc mode, at most one async_pop or async_pop_some may be
+    /// outstanding at a time.
+    template < class T,
+               class Executor,
+               template < class... > class Impl = detail::async_queue_impl >
     struct basic_async_queue
     {
         using executor_type = Executor;
@@ -12,11 +33,14 @@ namespace notstd::util::async
         template < class OtherExec >
         struct rebind_executor
         {
-            using other = basic_async_queue< T, OtherExec >;
+            using other = basic_async_queue< T, OtherExec, Impl >;
         };
 
         using value_type = T;
 
+        /// The type delivered by async_pop_some
+        using batch_type = std::vector< T >;
+
         basic_async_queue(executor_type exec);
         basic_async_queue(basic_async_queue &&other);
         basic_async_queue &operator=(basic_async_queue &&other);
@@ -41,18 +65,43 @@ namespace notstd::util::async
         async_pop(WaitHandler &&handler
                       BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
 
+        /// Initiate an asynchronous wait for a batch of values.
+        ///
+        /// As async_pop, except that the handler receives every value which is
+        /// ready at the time of delivery, up to a maximum of `max`, in a single
+        /// completion. Use this to amortise the cost of waking the consumer
+        /// when values arrive in bursts.
+        ///
+        /// @param max the maximum number of values to deliver. Must be greater
+        /// than zero
+        /// @param handler A completion token or handler whose signature matches
+        /// void(error_code, std::vector<T>)
+        /// @return DEDUCED
+        template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, batch_type))
+                       WaitHandler BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(
+                           executor_type) >
+        BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler,
+                                           void(error_code, batch_type))
+        async_pop_some(std::size_t max,
+                       WaitHandler &&handler
+                           BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+
         /// Push an item onto the queue.
         /// This function will return quickly, and delivery of the payload is
         /// not guaranteed to have heppened before the function returns. \param
         /// arg the value to push onto the queue.
         void push(T arg);
 
+        /// Push a number of items onto the queue at the cost of one push.
+        /// \param args the values to push, in order.
+        void push_range(batch_type args);
+
         /// Put the queue into an error state, clear data from the queue and
         /// cause all subsequent async_wait operations to fail
         void stop();
 
       private:
-        using impl_class          = detail::async_queue_impl< T, Executor >;
+        using impl_class          = Impl< T, Executor >;
         using implementation_type = typename impl_class::ptr;
 
       private:
@@ -62,57 +111,88 @@ namespace notstd::util::async
     template < class T >
     using async_queue = basic_async_queue< T, net::executor >;
 
+    template < class T, class Executor >
+    using basic_mpsc_async_queue =
+        basic_async_queue< T, Executor, detail::mpsc_async_queue_impl >;
+
+    template < class T >
+    using mpsc_async_queue = basic_mpsc_async_queue< T, net::executor >;
+
+    template < class T, class Executor >
+    using basic_mpmc_async_queue =
+        basic_async_queue< T, Executor, detail::mpmc_async_queue_impl >;
+
+    template < class T >
+    using mpmc_async_queue = basic_mpmc_async_queue< T, net::executor >;
+
 }   // namespace notstd::util::async
 
 namespace notstd::util::async
 {
-    template < class T, class Executor >
-    basic_async_queue< T, Executor >::basic_async_queue(Executor exec)
+    template < class T, class Executor, template < class... > class Impl >
+    basic_async_queue< T, Executor, Impl >::basic_async_queue(Executor exec)
     : impl_(impl_class::construct(exec))
     {
     }
 
-    template < class T, class Executor >
-    basic_async_queue< T, Executor >::basic_async_queue(
+    template < class T, class Executor, template < class... > class Impl >
+    basic_async_queue< T, Executor, Impl >::basic_async_queue(
         basic_async_queue &&other)
     : impl_(std::exchange(other.impl_, nullptr))
     {
     }
 
-    template < class T, class Executor >
-    auto basic_async_queue< T, Executor >::operator=(basic_async_queue &&other)
-        -> basic_async_queue &
+    template < class T, class Executor, template < class... > class Impl >
+    auto basic_async_queue< T, Executor, Impl >::operator=(
+        basic_async_queue &&other) -> basic_async_queue &
     {
         auto tmp = std::move(other);
         std::swap(impl_, tmp.impl_);
         return *this;
     }
 
-    template < class T, class Executor >
-    basic_async_queue< T, Executor >::~basic_async_queue()
+    template < class T, class Executor, template < class... > class Impl >
+    basic_async_queue< T, Executor, Impl >::~basic_async_queue()
     {
         if (impl_)
             impl_->stop();
     }
 
-    template < class T, class Executor >
-    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, value_type))
+    template < class T, class Executor, template < class... > class Impl >
+    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, T))
                    WaitHandler >
-    BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler,
-                                       void(error_code, value_type))
-    basic_async_queue< T, Executor >::async_pop(WaitHandler &&handler)
+    BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler, void(error_code, T))
+    basic_async_queue< T, Executor, Impl >::async_pop(WaitHandler &&handler)
     {
         return impl_->async_pop(std::forward< WaitHandler >(handler));
     }
 
-    template < class T, class Executor >
-    void basic_async_queue< T, Executor >::push(value_type v)
+    template < class T, class Executor, template < class... > class Impl >
+    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code,
+                                                    std::vector< T >))
+                   WaitHandler >
+    BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler,
+                                       void(error_code, std::vector< T >))
+    basic_async_queue< T, Executor, Impl >::async_pop_some(
+        std::size_t max, WaitHandler &&handler)
+    {
+        return impl_->async_pop_some(max, std::forward< WaitHandler >(handler));
+    }
+
+    template < class T, class Executor, template < class... > class Impl >
+    void basic_async_queue< T, Executor, Impl >::push(value_type v)
     {
         return impl_->push(std::move(v));
     }
 
-    template < class T, class Executor >
-    void basic_async_queue< T, Executor >::stop()
+    template < class T, class Executor, template < class... > class Impl >
+    void basic_async_queue< T, Executor, Impl >::push_range(batch_type vs)
+    {
+        return impl_->push_range(std::move(vs));
+    }
+
+    template < class T, class Executor, template < class... > class Impl >
+    void basic_async_queue< T, Executor, Impl >::stop()
     {
         return impl_->stop();
     }
@@ -0,0 +1,184 @@
+#pragma once
+#include <notstd/util/async/detail/bounded_async_queue_impl.hpp>
+#include <notstd/util/async/overflow_policy.hpp>
+#include <notstd/util/net.hpp>
+
+namespace notstd::util::async
+{
+    /// An asynchronous queue of T with a single waiting consumer and a fixed
+    /// capacity.
+    ///
+    /// When the queue is full, a pushed value is handled according to the
+    /// queue's overflow_policy. Under overflow_policy::block, async_push
+    /// suspends the producer until the consumer makes room, so a stalled
+    /// consumer applies back-pressure rather than growing the queue without
+    /// limit.
+    /// @tparam T the type of value carried by the queue
+    /// @tparam Executor the queue's default executor
+    template < class T, class Executor >
+    struct basic_bounded_async_queue
+    {
+        using executor_type = Executor;
+
+        template < class OtherExec >
+        struct rebind_executor
+        {
+            using other = basic_bounded_async_queue< T, OtherExec >;
+        };
+
+        using value_type = T;
+
+        /// A predicate which returns true if two values share a key. Used by
+        /// overflow_policy::conflate
+        using key_equal_type = std::function< bool(T const &, T const &) >;
+
+        /// Construct a queue
+        /// @param exec the default executor
+        /// @param capacity the maximum number of queued values. Must be
+        /// greater than zero
+        /// @param policy what to do with a value pushed while the queue is
+        /// full
+        /// @param same_key required when policy is overflow_policy::conflate
+        basic_bounded_async_queue(
+            executor_type   exec,
+            std::size_t     capacity,
+            overflow_policy policy   = overflow_policy::block,
+            key_equal_type  same_key = {});
+        basic_bounded_async_queue(basic_bounded_async_queue &&other);
+        basic_bounded_async_queue &operator=(basic_bounded_async_queue &&other);
+        ~basic_bounded_async_queue();
+
+        /// Initiate an asynchronous wait on the queue.
+        ///
+        /// The function will return immediately. The WaitHandler will be
+        /// invoked, as if by post on its associated executor when an item in
+        /// the queue is ready for delivery
+        ///
+        /// @param handler A completion token or handler whose signature matches
+        /// void(error_code, T)
+        /// @return DEDUCED
+        template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, value_type))
+                       WaitHandler BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(
+                           executor_type) >
+        BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler,
+                                           void(error_code, value_type))
+        async_pop(WaitHandler &&handler
+                      BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+
+        /// Initiate an asynchronous push onto the queue.
+        ///
+        /// The PushHandler will be invoked, as if by post on its associated
+        /// executor, once the value has been accepted into the queue. Any
+        /// number of pushes may be outstanding; they are accepted in the order
+        /// in which they were initiated.
+        ///
+        /// The handler receives:
+        /// - success once the value is queued,
+        /// - net::error::no_buffer_space if the value was discarded under
+        ///   overflow_policy::drop_newest,
+        /// - net::error::operation_aborted if the queue is stopped before the
+        ///   value is accepted.
+        /// @param v the value to push
+        /// @param handler A completion token or handler whose signature matches
+        /// void(error_code)
+        /// @return DEDUCED
+        template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code))
+                       PushHandler BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(
+                           executor_type) >
+        BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(PushHandler, void(error_code))
+        async_push(T v,
+                   PushHandler &&handler
+                       BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+
+        /// Push an item onto the queue without waiting.
+        /// May be called from any thread.
+        /// @return true if the value was queued. false if the queue is
+        /// stopped, or is full and the policy would have made the producer
+        /// wait or discarded the value
+        bool try_push(T v);
+
+        /// Put the queue into an error state, clear data from the queue and
+        /// cause the pending and all subsequent async_pop and async_push
+        /// operations to fail
+        void stop();
+
+      private:
+        using impl_class = detail::bounded_async_queue_impl< T, Executor >;
+        using implementation_type = typename impl_class::ptr;
+
+      private:
+        implementation_type impl_;
+    };
+
+    template < class T >
+    using bounded_async_queue = basic_bounded_async_queue< T, net::executor >;
+
+}   // namespace notstd::util::async
+
+namespace notstd::util::async
+{
+    template < class T, class Executor >
+    basic_bounded_async_queue< T, Executor >::basic_bounded_async_queue(
+        Executor        exec,
+        std::size_t     capacity,
+        overflow_policy policy,
+        key_equal_type  same_key)
+    : impl_(impl_class::construct(exec, capacity, policy, std::move(same_key)))
+    {
+    }
+
+    template < class T, class Executor >
+    basic_bounded_async_queue< T, Executor >::basic_bounded_async_queue(
+        basic_bounded_async_queue &&other)
+    : impl_(std::exchange(other.impl_, nullptr))
+    {
+    }
+
+    template < class T, class Executor >
+    auto basic_bounded_async_queue< T, Executor >::operator=(
+        basic_bounded_async_queue &&other) -> basic_bounded_async_queue &
+    {
+        auto tmp = std::move(other);
+        std::swap(impl_, tmp.impl_);
+        return *this;
+    }
+
+    template < class T, class Executor >
+    basic_bounded_async_queue< T, Executor >::~basic_bounded_async_queue()
+    {
+        if (impl_)
+            impl_->stop();
+    }
+
+    template < class T, class Executor >
+    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, T))
+                   WaitHandler >
+    BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler, void(error_code, T))
+    basic_bounded_async_queue< T, Executor >::async_pop(WaitHandler &&handler)
+    {
+        return impl_->async_pop(std::forward< WaitHandler >(handler));
+    }
+
+    template < class T, class Executor >
+    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code)) PushHandler >
+    BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(PushHandler, void(error_code))
+    basic_bounded_async_queue< T, Executor >::async_push(T v,
+                                                         PushHandler &&handler)
+    {
+        return impl_->async_push(std::move(v),
+                                 std::forward< PushHandler >(handler));
+    }
+
+    template < class T, class Executor >
+    bool basic_bounded_async_queue< T, Executor >::try_push(T v)
+    {
+        return impl_->try_push(std::move(v));
+    }
+
+    template < class T, class Executor >
+    void basic_bounded_async_queue< T, Executor >::stop()
+    {
+        return impl_->stop();
+    }
+
+}   // namespace notstd::util::async
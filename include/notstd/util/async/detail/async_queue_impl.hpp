@@ -1,13 +1,17 @@
 #pragma once
+#include <algorithm>
 #include <boost/mp11/tuple.hpp>
 #include <boost/smart_ptr/intrusive_ptr.hpp>
 #include <boost/smart_ptr/intrusive_ref_counter.hpp>
 #include <deque>
 #include <notstd/util/async/cheap_work_guard.hpp>
 #include <notstd/util/async/detail/has_get_executor.hpp>
+#include <notstd/util/async/executor_traits.hpp>
 #include <notstd/util/async/poly_handler.hpp>
 #include <notstd/util/net.hpp>
+#include <notstd/util/ring_buffer.hpp>
 #include <queue>
+#include <vector>
 
 namespace notstd::util::async::detail
 {
@@ -41,13 +45,48 @@ namespace notstd::util::async::detail
             guards_;
     };
 
-    template < class T, class Executor >
+    /// A poly_handler for signature Sig, sized so that a coroutine awaiting
+    /// from a different executor is held in a guarded_handler without
+    /// allocation
+    template < class Sig, class Executor >
+    using guarded_poly_handler = poly_handler_for<
+        Sig,
+        guarded_handler<
+            typename executor_traits< Executor >::template awaitable_handler<
+                Sig >,
+            Executor > >;
+
+    /// Store a completion handler in target, wrapped in a guarded_handler
+    /// which holds work on the handler's executor and, if different, on the
+    /// queue's default executor. A handler with no associated executor is
+    /// bound to the default executor.
+    template < class PolyHandler, class Handler, class Executor >
+    void emplace_guarded_handler(PolyHandler &   target,
+                                 Handler &&      handler,
+                                 Executor const &default_executor)
+    {
+        if constexpr (has_get_executor_v< Handler >)
+            if (handler.get_executor() == default_executor)
+                target = guarded_handler(std::forward< Handler >(handler));
+            else
+                target = guarded_handler(std::forward< Handler >(handler),
+                                         default_executor);
+        else
+            target = guarded_handler(net::bind_executor(
+                default_executor, std::forward< Handler >(handler)));
+    }
+
+    /// @tparam Container the underlying container of the std::queue which
+    /// holds values not yet delivered
+    template < class T, class Executor, class Container = ring_buffer< T > >
     struct async_queue_impl
-    : boost::intrusive_ref_counter< async_queue_impl< T, Executor > >
+    : boost::intrusive_ref_counter<
+          async_queue_impl< T, Executor, Container > >
     {
         using value_type    = T;
         using executor_type = Executor;
         using ptr           = boost::intrusive_ptr< async_queue_impl >;
+        using batch_type    = std::vector< T >;
 
         enum waiting_state
         {
@@ -58,6 +97,7 @@ namespace notstd::util::async::detail
         async_queue_impl(executor_type exec)
         : state_(not_waiting)
         , handler_()
+        , batch_handler_()
         , values_()
         , default_executor_(exec)
         {
@@ -69,20 +109,35 @@ namespace notstd::util::async::detail
                                            void(error_code, value_type))
         async_pop(WaitHandler &&handler);
 
+        template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, batch_type))
+                       WaitHandler >
+        BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler,
+                                           void(error_code, batch_type))
+        async_pop_some(std::size_t max, WaitHandler &&handler);
+
         static ptr construct(executor_type exec);
 
         void push(value_type v);
 
+        void push_range(batch_type vs);
+
         void stop();
 
       private:
         void maybe_complete();
 
       private:
+        using handler_type =
+            guarded_poly_handler< void(error_code, value_type), Executor >;
+        using batch_handler_type =
+            guarded_poly_handler< void(error_code, batch_type), Executor >;
+
         std::atomic< waiting_state > state_ = not_waiting;
-        util::async::poly_handler< void(error_code, value_type) > handler_;
+        handler_type                 handler_;
+        batch_handler_type           batch_handler_;
+        std::size_t                  batch_max_ = 0;
 
-        using queue_impl = std::queue< T, std::deque< T > >;
+        using queue_impl = std::queue< T, Container >;
         queue_impl values_;
         error_code ec_;   // error state of the queue
 
@@ -93,31 +148,21 @@ namespace notstd::util::async::detail
 
 namespace notstd::util::async::detail
 {
-    template < class T, class Executor >
-    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, value_type))
+    template < class T, class Executor, class Container >
+    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, T))
                    WaitHandler >
-    BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler,
-                                       void(error_code, value_type))
-    async_queue_impl< T, Executor >::async_pop(WaitHandler &&handler)
+    BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler, void(error_code, T))
+    async_queue_impl< T, Executor, Container >::async_pop(WaitHandler &&handler)
     {
         assert(this->state_ == not_waiting);
 
         auto initiate = [this](auto &&deduced_handler) {
             using DeducedHandler = decltype(deduced_handler);
 
-            if constexpr (has_get_executor_v< DeducedHandler >)
-                if (deduced_handler.get_executor() == this->default_executor_)
-                    this->handler_ = guarded_handler(
-                        std::forward< DeducedHandler >(deduced_handler));
-                else
-                    this->handler_ = guarded_handler(
-                        std::forward< DeducedHandler >(deduced_handler),
-                        this->default_executor_);
-
-            else
-                this->handler_ = guarded_handler(net::bind_executor(
-                    this->default_executor_,
-                    std::forward< DeducedHandler >(deduced_handler)));
+            emplace_guarded_handler(
+                this->handler_,
+                std::forward< DeducedHandler >(deduced_handler),
+                this->default_executor_);
 
             this->state_ = waiting;
 
@@ -131,14 +176,49 @@ namespace notstd::util::async::detail
             initiate, handler);
     }
 
-    template < class T, class Executor >
-    auto async_queue_impl< T, Executor >::construct(executor_type exec) -> ptr
+    template < class T, class Executor, class Container >
+    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code,
+                                                    std::vector< T >))
+                   WaitHandler >
+    BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler,
+                                       void(error_code, std::vector< T >))
+    async_queue_impl< T, Executor, Container >::async_pop_some(
+        std::size_t max, WaitHandler &&handler)
+    {
+        assert(this->state_ == not_waiting);
+        assert(max > 0);
+
+        auto initiate = [this, max](auto &&deduced_handler) {
+            using DeducedHandler = decltype(deduced_handler);
+
+            emplace_guarded_handler(
+                this->batch_handler_,
+                std::forward< DeducedHandler >(deduced_handler),
+                this->default_executor_);
+            this->batch_max_ = max;
+
+            this->state_ = waiting;
+
+            net::post(net::bind_executor(this->default_executor_,
+                                         [self = boost::intrusive_ptr(this)]() {
+                                             self->maybe_complete();
+                                         }));
+        };
+
+        return net::async_initiate< WaitHandler, void(error_code, batch_type) >(
+            initiate, handler);
+    }
+
+    template < class T, class Executor, class Container >
+    auto
+    async_queue_impl< T, Executor, Container >::construct(executor_type exec)
+        -> ptr
     {
         return ptr(new async_queue_impl(exec));
     }
 
-    template < class T, class Executor >
-    void async_queue_impl< T, Executor >::push(value_type v)
+    template < class T, class Executor, class Container >
+    void async_queue_impl< T, Executor, Container >::push(value_type v)
     {
         net::post(net::bind_executor(
             this->default_executor_,
@@ -148,8 +228,21 @@ namespace notstd::util::async::detail
             }));
     }
 
-    template < class T, class Executor >
-    void async_queue_impl< T, Executor >::maybe_complete()
+    template < class T, class Executor, class Container >
+    void async_queue_impl< T, Executor, Container >::push_range(batch_type vs)
+    {
+        // one operation on the default executor for the whole range
+        net::post(net::bind_executor(
+            this->default_executor_,
+            [self = boost::intrusive_ptr(this), vs = std::move(vs)]() mutable {
+                for (auto &v : vs)
+                    self->values_.push(std::move(v));
+                self->maybe_complete();
+            }));
+    }
+
+    template < class T, class Executor, class Container >
+    void async_queue_impl< T, Executor, Container >::maybe_complete()
     {
         // running in default executor...
         if (values_.empty() and not ec_)
@@ -157,6 +250,21 @@ namespace notstd::util::async::detail
         if (state_.exchange(not_waiting) != waiting)
             return;
 
+        if (batch_handler_)
+        {
+            auto vs = batch_type();
+            auto ec = std::exchange(ec_, {});
+            if (not ec)
+                vs.reserve(std::min(batch_max_, values_.size()));
+            while (not ec and vs.size() < batch_max_ and not values_.empty())
+            {
+                vs.push_back(std::move(values_.front()));
+                values_.pop();
+            }
+            batch_handler_.dispatch_completion(ec, std::move(vs));
+            return;
+        }
+
         auto e = this->handler_.get_executor();
 
         if (ec_)
@@ -191,8 +299,8 @@ namespace notstd::util::async::detail
         }
     }
 
-    template < class T, class Executor >
-    void async_queue_impl< T, Executor >::stop()
+    template < class T, class Executor, class Container >
+    void async_queue_impl< T, Executor, Container >::stop()
     {
         net::post(
             net::bind_executor(this->default_executor_,
@@ -0,0 +1,277 @@
+#pragma once
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <boost/smart_ptr/intrusive_ref_counter.hpp>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <notstd/util/async/detail/async_queue_impl.hpp>
+#include <notstd/util/async/overflow_policy.hpp>
+#include <notstd/util/net.hpp>
+#include <notstd/util/ring_buffer.hpp>
+
+namespace notstd::util::async::detail
+{
+    /// A capacity-bounded async_queue implementation.
+    ///
+    /// Unlike async_queue_impl, the state is guarded by a mutex rather than
+    /// serialised on the default executor, so that try_push can report its
+    /// outcome synchronously to a producer on any thread. Completions are
+    /// always delivered as if by post on the handler's associated executor.
+    template < class T, class Executor >
+    struct bounded_async_queue_impl
+    : boost::intrusive_ref_counter< bounded_async_queue_impl< T, Executor > >
+    {
+        using value_type     = T;
+        using executor_type  = Executor;
+        using ptr            = boost::intrusive_ptr< bounded_async_queue_impl >;
+        using key_equal_type = std::function< bool(T const &, T const &) >;
+
+        bounded_async_queue_impl(executor_type   exec,
+                                 std::size_t     capacity,
+                                 overflow_policy policy,
+                                 key_equal_type  same_key);
+
+        static ptr construct(executor_type   exec,
+                             std::size_t     capacity,
+                             overflow_policy policy,
+                             key_equal_type  same_key);
+
+        template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, value_type))
+                       WaitHandler >
+        BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler,
+                                           void(error_code, value_type))
+        async_pop(WaitHandler &&handler);
+
+        template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code))
+                       PushHandler >
+        BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(PushHandler, void(error_code))
+        async_push(value_type v, PushHandler &&handler);
+
+        bool try_push(value_type v);
+
+        void stop();
+
+      private:
+        enum admit_result
+        {
+            admitted,
+            dropped,
+            full
+        };
+
+        // place v in the queue according to the overflow policy.
+        // @pre mutex_ is locked
+        admit_result admit(value_type &v);
+
+        // complete the consumer if there is anything to deliver, then fill
+        // any free space from waiting producers.
+        // @pre mutex_ is locked
+        void maybe_complete();
+
+      private:
+        using pop_handler_type =
+            guarded_poly_handler< void(error_code, value_type), Executor >;
+        using push_handler_type =
+            guarded_poly_handler< void(error_code), Executor >;
+
+        struct pending_push
+        {
+            value_type        value;
+            push_handler_type handler;
+        };
+
+        std::mutex                 mutex_;
+        ring_buffer< value_type >  values_;
+        std::deque< pending_push > pending_pushes_;
+        pop_handler_type           consumer_;
+        error_code                 ec_;   // error state of the queue
+
+        std::size_t const     capacity_;
+        overflow_policy const policy_;
+        key_equal_type const  same_key_;
+
+        executor_type default_executor_;
+    };
+}   // namespace notstd::util::async::detail
+
+namespace notstd::util::async::detail
+{
+    template < class T, class Executor >
+    bounded_async_queue_impl< T, Executor >::bounded_async_queue_impl(
+        executor_type   exec,
+        std::size_t     capacity,
+        overflow_policy policy,
+        key_equal_type  same_key)
+    : mutex_()
+    , values_()
+    , pending_pushes_()
+    , consumer_()
+    , ec_()
+    , capacity_(capacity)
+    , policy_(policy)
+    , same_key_(std::move(same_key))
+    , default_executor_(exec)
+    {
+        assert(capacity_ > 0);
+        assert(policy_ != overflow_policy::conflate or same_key_);
+    }
+
+    template < class T, class Executor >
+    auto bounded_async_queue_impl< T, Executor >::construct(
+        executor_type   exec,
+        std::size_t     capacity,
+        overflow_policy policy,
+        key_equal_type  same_key) -> ptr
+    {
+        return ptr(new bounded_async_queue_impl(
+            exec, capacity, policy, std::move(same_key)));
+    }
+
+    template < class T, class Executor >
+    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, T))
+                   WaitHandler >
+    BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler, void(error_code, T))
+    bounded_async_queue_impl< T, Executor >::async_pop(WaitHandler &&handler)
+    {
+        auto initiate = [this](auto &&deduced_handler) {
+            using DeducedHandler = decltype(deduced_handler);
+
+            auto h = pop_handler_type();
+            emplace_guarded_handler(
+                h,
+                std::forward< DeducedHandler >(deduced_handler),
+                this->default_executor_);
+
+            auto lock = std::scoped_lock(mutex_);
+            assert(not consumer_);
+            consumer_ = std::move(h);
+            maybe_complete();
+        };
+
+        return net::async_initiate< WaitHandler, void(error_code, value_type) >(
+            initiate, handler);
+    }
+
+    template < class T, class Executor >
+    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code)) PushHandler >
+    BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(PushHandler, void(error_code))
+    bounded_async_queue_impl< T, Executor >::async_push(value_type    v,
+                                                        PushHandler &&handler)
+    {
+        auto initiate = [this](auto &&deduced_handler, value_type v) {
+            using DeducedHandler = decltype(deduced_handler);
+
+            auto h = push_handler_type();
+            emplace_guarded_handler(
+                h,
+                std::forward< DeducedHandler >(deduced_handler),
+                this->default_executor_);
+
+            auto lock = std::scoped_lock(mutex_);
+            if (ec_)
+                return h.post_completion(ec_);
+
+            switch (admit(v))
+            {
+            case admitted:
+                h.post_completion(error_code());
+                maybe_complete();
+                break;
+            case dropped:
+                h.post_completion(
+                    error_code(net::error::no_buffer_space));
+                break;
+            case full:
+                pending_pushes_.push_back(
+                    pending_push { std::move(v), std::move(h) });
+                break;
+            }
+        };
+
+        return net::async_initiate< PushHandler, void(error_code) >(
+            initiate, handler, std::move(v));
+    }
+
+    template < class T, class Executor >
+    bool bounded_async_queue_impl< T, Executor >::try_push(value_type v)
+    {
+        auto lock = std::scoped_lock(mutex_);
+        if (ec_ or admit(v) != admitted)
+            return false;
+        maybe_complete();
+        return true;
+    }
+
+    template < class T, class Executor >
+    auto bounded_async_queue_impl< T, Executor >::admit(value_type &v)
+        -> admit_result
+    {
+        if (policy_ == overflow_policy::conflate)
+            for (auto &queued : values_)
+                if (same_key_(queued, v))
+                {
+                    queued = std::move(v);
+                    return admitted;
+                }
+
+        // waiting producers are ahead of us
+        if (values_.size() < capacity_ and pending_pushes_.empty())
+        {
+            values_.push_back(std::move(v));
+            return admitted;
+        }
+
+        switch (policy_)
+        {
+        case overflow_policy::drop_oldest:
+            values_.pop_front();
+            values_.push_back(std::move(v));
+            return admitted;
+        case overflow_policy::drop_newest:
+            return dropped;
+        case overflow_policy::block:
+        case overflow_policy::conflate:
+            break;
+        }
+        return full;
+    }
+
+    template < class T, class Executor >
+    void bounded_async_queue_impl< T, Executor >::maybe_complete()
+    {
+        if (consumer_)
+        {
+            if (ec_)
+            {
+                consumer_.post_completion(ec_, value_type());
+            }
+            else if (not values_.empty())
+            {
+                auto v = std::move(values_.front());
+                values_.pop_front();
+                consumer_.post_completion(error_code(), std::move(v));
+            }
+        }
+
+        while (not pending_pushes_.empty() and values_.size() < capacity_)
+        {
+            auto &p = pending_pushes_.front();
+            values_.push_back(std::move(p.value));
+            p.handler.post_completion(error_code());
+            pending_pushes_.pop_front();
+        }
+    }
+
+    template < class T, class Executor >
+    void bounded_async_queue_impl< T, Executor >::stop()
+    {
+        auto lock = std::scoped_lock(mutex_);
+        ec_       = net::error::operation_aborted;
+        values_.clear();
+        for (auto &p : pending_pushes_)
+            p.handler.post_completion(ec_);
+        pending_pushes_.clear();
+        maybe_complete();
+    }
+
+}   // namespace notstd::util::async::detail
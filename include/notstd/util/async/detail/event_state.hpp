@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace notstd::util::async::detail
+{
+    /// The state word of a one-shot signalling object such as async_event.
+    ///
+    /// Every change of state is a single transition of this word, so the
+    /// party which observes a given bit leaving the word (for example,
+    /// "waiting") is the unique owner of whatever that bit guarded.
+    ///
+    /// When the owning object's executor is single-threaded, no two
+    /// transitions can overlap and each is performed as a plain load and
+    /// store. Otherwise they are atomic read-modify-write operations with
+    /// acquire/release ordering.
+    class event_state
+    {
+      public:
+        using value_type = std::uint32_t;
+
+        explicit event_state(bool single_threaded) noexcept
+        : single_threaded_(single_threaded)
+        {
+        }
+
+        event_state(event_state const &) = delete;
+        event_state &operator=(event_state const &) = delete;
+
+        auto load() const noexcept -> value_type
+        {
+            return word_.load(single_threaded_ ? std::memory_order_relaxed
+                                               : std::memory_order_acquire);
+        }
+
+        /// Set bits in the state
+        /// @return the previous state
+        auto set(value_type bits) noexcept -> value_type
+        {
+            if (single_threaded_)
+            {
+                auto prev = word_.load(std::memory_order_relaxed);
+                word_.store(prev | bits, std::memory_order_relaxed);
+                return prev;
+            }
+            return word_.fetch_or(bits, std::memory_order_acq_rel);
+        }
+
+        /// Replace the state s with f(s)
+        /// @return the previous state
+        template < class F >
+        auto transition(F f) noexcept -> value_type
+        {
+            auto prev = word_.load(std::memory_order_relaxed);
+            if (single_threaded_)
+            {
+                word_.store(f(prev), std::memory_order_relaxed);
+                return prev;
+            }
+            while (not word_.compare_exchange_weak(prev,
+                                                   f(prev),
+                                                   std::memory_order_acq_rel,
+                                                   std::memory_order_relaxed))
+                ;
+            return prev;
+        }
+
+      private:
+        std::atomic< value_type > word_ { 0 };
+        bool const                single_threaded_;
+    };
+}   // namespace notstd::util::async::detail
@@ -0,0 +1,101 @@
+#pragma once
+#include <notstd/util/async/frame_fragment.hpp>
+#include <notstd/util/buffer_pool.hpp>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace notstd::util::async::detail
+{
+    /// True if a frame handler is called with a view of the frame, rather
+    /// than a pooled_buffer holding it
+    template < class Handler >
+    constexpr inline bool is_span_frame_handler_v =
+        std::is_invocable_v< Handler &, std::span< char > >;
+
+    /// True if a frame handler takes ownership of each frame as a
+    /// pooled_buffer
+    template < class Handler >
+    constexpr inline bool is_pooled_frame_handler_v =
+        not is_span_frame_handler_v< Handler > and
+        std::is_invocable_v< Handler &, pooled_buffer >;
+
+    /// True if a frame handler is called with each fragment of a message as
+    /// it arrives
+    template < class Handler >
+    constexpr inline bool is_fragment_frame_handler_v =
+        not is_span_frame_handler_v< Handler > and
+        std::is_invocable_v< Handler &, frame_fragment >;
+
+    template < class Handler >
+    constexpr inline bool is_frame_handler_v =
+        is_span_frame_handler_v< Handler > or
+        is_pooled_frame_handler_v< Handler > or
+        is_fragment_frame_handler_v< Handler >;
+
+    /// Pass a frame to whichever of the handlers matches its type.
+    ///
+    /// The handlers are called directly, so each call may be inlined into
+    /// the read loop.
+    template < class OnTextFrame, class OnBinaryFrame >
+    auto dispatch_frame(bool              text,
+                        std::span< char > frame,
+                        OnTextFrame &     on_text,
+                        OnBinaryFrame &   on_binary) -> void
+    {
+        if (text)
+            on_text(frame);
+        else
+            on_binary(frame);
+    }
+
+    /// Pass a pooled frame to whichever of the handlers matches its type,
+    /// as a view if the handler accepts one
+    template < class OnTextFrame, class OnBinaryFrame >
+    auto dispatch_frame(bool            text,
+                        pooled_buffer &&frame,
+                        OnTextFrame &   on_text,
+                        OnBinaryFrame & on_binary) -> void
+    {
+        auto deliver = [&frame](auto &handler) {
+            using handler_type = std::remove_reference_t< decltype(handler) >;
+            if constexpr (is_span_frame_handler_v< handler_type >)
+            {
+                auto buf = frame.buffer().data();
+                handler(std::span< char >(static_cast< char * >(buf.data()),
+                                          buf.size()));
+            }
+            else
+                handler(std::move(frame));
+        };
+        if (text)
+            deliver(on_text);
+        else
+            deliver(on_binary);
+    }
+
+    /// Pass part of a message to whichever of the handlers matches its type.
+    ///
+    /// A handler which does not take fragments is called only with the last
+    /// fragment, whose data shall then hold the whole message.
+    /// @return false if the fragment is to be kept as the start of the
+    /// message, true if it has been delivered and may be discarded
+    template < class OnTextFrame, class OnBinaryFrame >
+    auto dispatch_fragment(bool            text,
+                           frame_fragment  fragment,
+                           OnTextFrame &   on_text,
+                           OnBinaryFrame & on_binary) -> bool
+    {
+        auto deliver = [&fragment](auto &handler) {
+            using handler_type = std::remove_reference_t< decltype(handler) >;
+            if constexpr (is_fragment_frame_handler_v< handler_type >)
+                handler(fragment);
+            else if (fragment.last)
+                handler(fragment.data);
+            else
+                return false;
+            return true;
+        };
+        return text ? deliver(on_text) : deliver(on_binary);
+    }
+}   // namespace notstd::util::async::detail
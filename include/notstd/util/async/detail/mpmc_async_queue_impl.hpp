@@ -0,0 +1,245 @@
+#pragma once
+#include <algorithm>
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <boost/smart_ptr/intrusive_ref_counter.hpp>
+#include <deque>
+#include <mutex>
+#include <notstd/util/async/detail/async_queue_impl.hpp>
+#include <notstd/util/net.hpp>
+#include <notstd/util/ring_buffer.hpp>
+#include <variant>
+#include <vector>
+
+namespace notstd::util::async::detail
+{
+    /// An async_queue implementation which allows any number of pending
+    /// async_pop operations, from any number of threads.
+    ///
+    /// Waiters are held in FIFO order. Each value is handed to exactly one
+    /// waiter, the longest waiting, so a push wakes at most one consumer.
+    /// Every waiter is completed as if by post on its own associated
+    /// executor.
+    template < class T, class Executor >
+    struct mpmc_async_queue_impl
+    : boost::intrusive_ref_counter< mpmc_async_queue_impl< T, Executor > >
+    {
+        using value_type    = T;
+        using executor_type = Executor;
+        using ptr           = boost::intrusive_ptr< mpmc_async_queue_impl >;
+        using batch_type    = std::vector< T >;
+
+        mpmc_async_queue_impl(executor_type exec);
+
+        template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, value_type))
+                       WaitHandler >
+        BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler,
+                                           void(error_code, value_type))
+        async_pop(WaitHandler &&handler);
+
+        template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, batch_type))
+                       WaitHandler >
+        BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler,
+                                           void(error_code, batch_type))
+        async_pop_some(std::size_t max, WaitHandler &&handler);
+
+        static ptr construct(executor_type exec);
+
+        void push(value_type v);
+
+        void push_range(batch_type vs);
+
+        void stop();
+
+      private:
+        using handler_type =
+            guarded_poly_handler< void(error_code, value_type), Executor >;
+        using batch_handler_type =
+            guarded_poly_handler< void(error_code, batch_type), Executor >;
+
+        struct batch_waiter
+        {
+            batch_handler_type handler;
+            std::size_t        max;
+        };
+
+        using waiter = std::variant< handler_type, batch_waiter >;
+
+        // hand queued values to waiters, oldest first, until one or the other
+        // runs out.
+        // @pre mutex_ is locked
+        void maybe_complete();
+
+        // complete w with values from the front of the queue
+        // @pre mutex_ is locked and values_ is not empty
+        void complete(waiter &w);
+
+        // complete w with the error state of the queue
+        // @pre mutex_ is locked
+        void abort(waiter &w);
+
+      private:
+        std::mutex           mutex_;
+        ring_buffer< T >     values_;
+        std::deque< waiter > waiters_;
+        error_code           ec_;   // error state of the queue
+
+        executor_type default_executor_;
+    };
+}   // namespace notstd::util::async::detail
+
+namespace notstd::util::async::detail
+{
+    template < class T, class Executor >
+    mpmc_async_queue_impl< T, Executor >::mpmc_async_queue_impl(
+        executor_type exec)
+    : mutex_()
+    , values_()
+    , waiters_()
+    , ec_()
+    , default_executor_(exec)
+    {
+    }
+
+    template < class T, class Executor >
+    auto mpmc_async_queue_impl< T, Executor >::construct(executor_type exec)
+        -> ptr
+    {
+        return ptr(new mpmc_async_queue_impl(exec));
+    }
+
+    template < class T, class Executor >
+    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, T))
+                   WaitHandler >
+    BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler, void(error_code, T))
+    mpmc_async_queue_impl< T, Executor >::async_pop(WaitHandler &&handler)
+    {
+        auto initiate = [this](auto &&deduced_handler) {
+            using DeducedHandler = decltype(deduced_handler);
+
+            auto w = waiter(std::in_place_type< handler_type >);
+            emplace_guarded_handler(
+                std::get< handler_type >(w),
+                std::forward< DeducedHandler >(deduced_handler),
+                this->default_executor_);
+
+            auto lock = std::scoped_lock(mutex_);
+            waiters_.push_back(std::move(w));
+            maybe_complete();
+        };
+
+        return net::async_initiate< WaitHandler, void(error_code, value_type) >(
+            initiate, handler);
+    }
+
+    template < class T, class Executor >
+    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code,
+                                                    std::vector< T >))
+                   WaitHandler >
+    BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler,
+                                       void(error_code, std::vector< T >))
+    mpmc_async_queue_impl< T, Executor >::async_pop_some(std::size_t   max,
+                                                         WaitHandler &&handler)
+    {
+        assert(max > 0);
+
+        auto initiate = [this, max](auto &&deduced_handler) {
+            using DeducedHandler = decltype(deduced_handler);
+
+            auto w = waiter(std::in_place_type< batch_waiter >,
+                            batch_waiter { batch_handler_type(), max });
+            emplace_guarded_handler(
+                std::get< batch_waiter >(w).handler,
+                std::forward< DeducedHandler >(deduced_handler),
+                this->default_executor_);
+
+            auto lock = std::scoped_lock(mutex_);
+            waiters_.push_back(std::move(w));
+            maybe_complete();
+        };
+
+        return net::async_initiate< WaitHandler, void(error_code, batch_type) >(
+            initiate, handler);
+    }
+
+    template < class T, class Executor >
+    void mpmc_async_queue_impl< T, Executor >::push(value_type v)
+    {
+        auto lock = std::scoped_lock(mutex_);
+        if (ec_)
+            return;
+        values_.push_back(std::move(v));
+        maybe_complete();
+    }
+
+    template < class T, class Executor >
+    void mpmc_async_queue_impl< T, Executor >::push_range(batch_type vs)
+    {
+        auto lock = std::scoped_lock(mutex_);
+        if (ec_)
+            return;
+        for (auto &v : vs)
+            values_.push_back(std::move(v));
+        maybe_complete();
+    }
+
+    template < class T, class Executor >
+    void mpmc_async_queue_impl< T, Executor >::maybe_complete()
+    {
+        if (ec_)
+        {
+            for (auto &w : waiters_)
+                abort(w);
+            waiters_.clear();
+            return;
+        }
+
+        while (not waiters_.empty() and not values_.empty())
+        {
+            complete(waiters_.front());
+            waiters_.pop_front();
+        }
+    }
+
+    template < class T, class Executor >
+    void mpmc_async_queue_impl< T, Executor >::complete(waiter &w)
+    {
+        if (auto h = std::get_if< handler_type >(&w))
+        {
+            auto v = std::move(values_.front());
+            values_.pop_front();
+            h->post_completion(error_code(), std::move(v));
+        }
+        else
+        {
+            auto &bw = std::get< batch_waiter >(w);
+            auto  vs = batch_type();
+            vs.reserve(std::min(bw.max, values_.size()));
+            while (vs.size() < bw.max and not values_.empty())
+            {
+                vs.push_back(std::move(values_.front()));
+                values_.pop_front();
+            }
+            bw.handler.post_completion(error_code(), std::move(vs));
+        }
+    }
+
+    template < class T, class Executor >
+    void mpmc_async_queue_impl< T, Executor >::abort(waiter &w)
+    {
+        if (auto h = std::get_if< handler_type >(&w))
+            h->post_completion(ec_, value_type());
+        else
+            std::get< batch_waiter >(w).handler.post_completion(ec_,
+                                                                batch_type());
+    }
+
+    template < class T, class Executor >
+    void mpmc_async_queue_impl< T, Executor >::stop()
+    {
+        auto lock = std::scoped_lock(mutex_);
+        ec_       = net::error::operation_aborted;
+        values_.clear();
+        maybe_complete();
+    }
+
+}   // namespace notstd::util::async::detail
@@ -0,0 +1,363 @@
+#pragma once
+#include <atomic>
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <boost/smart_ptr/intrusive_ref_counter.hpp>
+#include <notstd/util/async/detail/async_queue_impl.hpp>
+#include <notstd/util/net.hpp>
+#include <vector>
+
+namespace notstd::util::async::detail
+{
+    /// An async_queue implementation for many producer threads and a single
+    /// consumer.
+    ///
+    /// Values are linked into an intrusive lock-free queue (after Vyukov)
+    /// directly by the pushing thread, so producers neither contend on a lock
+    /// nor pass through the default executor. The default executor is only
+    /// involved when a consumer is parked in async_pop, in which case exactly
+    /// one producer wins the right to wake it.
+    template < class T, class Executor >
+    struct mpsc_async_queue_impl
+    : boost::intrusive_ref_counter< mpsc_async_queue_impl< T, Executor > >
+    {
+        using value_type    = T;
+        using executor_type = Executor;
+        using ptr           = boost::intrusive_ptr< mpsc_async_queue_impl >;
+        using batch_type    = std::vector< T >;
+
+        enum waiting_state
+        {
+            not_waiting,
+            waiting
+        };
+
+        mpsc_async_queue_impl(executor_type exec);
+        mpsc_async_queue_impl(mpsc_async_queue_impl const &) = delete;
+        mpsc_async_queue_impl &
+        operator=(mpsc_async_queue_impl const &) = delete;
+        ~mpsc_async_queue_impl();
+
+        /// Initiate the single outstanding wait. Must not be called while
+        /// another async_pop is outstanding
+        template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, value_type))
+                       WaitHandler >
+        BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler,
+                                           void(error_code, value_type))
+        async_pop(WaitHandler &&handler);
+
+        /// As async_pop, but completes with up to `max` values at once
+        template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, batch_type))
+                       WaitHandler >
+        BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler,
+                                           void(error_code, batch_type))
+        async_pop_some(std::size_t max, WaitHandler &&handler);
+
+        static ptr construct(executor_type exec);
+
+        /// Enqueue a value. May be called from any thread concurrently
+        void push(value_type v);
+
+        /// Enqueue a number of values, waking the consumer at most once. May be
+        /// called from any thread concurrently, but values from concurrent
+        /// calls may be interleaved
+        void push_range(batch_type vs);
+
+        /// Cause the pending and all subsequent async_pop operations to fail
+        /// with operation_aborted. May be called from any thread
+        void stop();
+
+      private:
+        struct node_base
+        {
+            std::atomic< node_base * > next { nullptr };
+        };
+
+        struct node : node_base
+        {
+            explicit node(value_type v)
+            : value(std::move(v))
+            {
+            }
+
+            value_type value;
+        };
+
+        // producer side of the link
+        void link(node_base *n) noexcept;
+
+        // consumer side. Returns nullptr if the queue is empty or if a
+        // producer is part way through linking the next node
+        node *unlink() noexcept;
+
+        // true if there is at least one node linked or being linked
+        bool has_nodes() const noexcept;
+
+        // atomically claim the parked consumer. Returns true if the caller is
+        // now responsible for waking it
+        bool claim_waiter() noexcept;
+
+        // wake the consumer on the default executor
+        void wake();
+
+        // park the consumer, then wake it if there is already something to
+        // deliver
+        void park();
+
+        // runs on the default executor once the consumer has been claimed
+        void deliver();
+
+      private:
+        // written by producers
+        std::atomic< node_base * > head_;
+
+        // owned by the consumer
+        node_base *tail_;
+        node_base  stub_;
+
+        std::atomic< waiting_state > state_ = not_waiting;
+        std::atomic< bool >          stopped_ { false };
+
+        using handler_type =
+            guarded_poly_handler< void(error_code, value_type), Executor >;
+        using batch_handler_type =
+            guarded_poly_handler< void(error_code, batch_type), Executor >;
+        handler_type       handler_;
+        batch_handler_type batch_handler_;
+        std::size_t        batch_max_ = 0;
+
+        executor_type default_executor_;
+    };
+}   // namespace notstd::util::async::detail
+
+namespace notstd::util::async::detail
+{
+    template < class T, class Executor >
+    mpsc_async_queue_impl< T, Executor >::mpsc_async_queue_impl(
+        executor_type exec)
+    : head_(&stub_)
+    , tail_(&stub_)
+    , stub_()
+    , handler_()
+    , batch_handler_()
+    , default_executor_(exec)
+    {
+    }
+
+    template < class T, class Executor >
+    mpsc_async_queue_impl< T, Executor >::~mpsc_async_queue_impl()
+    {
+        while (auto n = unlink())
+            delete n;
+    }
+
+    template < class T, class Executor >
+    auto mpsc_async_queue_impl< T, Executor >::construct(executor_type exec)
+        -> ptr
+    {
+        return ptr(new mpsc_async_queue_impl(exec));
+    }
+
+    template < class T, class Executor >
+    void mpsc_async_queue_impl< T, Executor >::link(node_base *n) noexcept
+    {
+        n->next.store(nullptr, std::memory_order_relaxed);
+
+        // seq_cst, as is the load of head_ in has_nodes: with the stores
+        // and loads of state_, this is a store then a load on each side of
+        // the wake-up, and anything weaker may let both miss the other
+        auto prev = head_.exchange(n, std::memory_order_seq_cst);
+        prev->next.store(n, std::memory_order_release);
+    }
+
+    template < class T, class Executor >
+    auto mpsc_async_queue_impl< T, Executor >::unlink() noexcept -> node *
+    {
+        auto tail = tail_;
+        auto next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_)
+        {
+            if (not next)
+                return nullptr;
+            tail_ = tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next)
+        {
+            tail_ = next;
+            return static_cast< node * >(tail);
+        }
+
+        if (tail != head_.load(std::memory_order_acquire))
+            return nullptr;
+
+        // tail is the last node. Put the stub back behind it so that it can
+        // be detached
+        link(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next)
+        {
+            tail_ = next;
+            return static_cast< node * >(tail);
+        }
+        return nullptr;
+    }
+
+    template < class T, class Executor >
+    bool mpsc_async_queue_impl< T, Executor >::has_nodes() const noexcept
+    {
+        return tail_ != &stub_ or
+               head_.load(std::memory_order_seq_cst) != &stub_;
+    }
+
+    template < class T, class Executor >
+    bool mpsc_async_queue_impl< T, Executor >::claim_waiter() noexcept
+    {
+        return state_.load(std::memory_order_seq_cst) == waiting and
+               state_.exchange(not_waiting, std::memory_order_seq_cst) ==
+                   waiting;
+    }
+
+    template < class T, class Executor >
+    void mpsc_async_queue_impl< T, Executor >::park()
+    {
+        // park, then look again: a producer which linked before we parked
+        // will not have seen us waiting
+        state_.store(waiting, std::memory_order_seq_cst);
+        if ((has_nodes() or stopped_.load()) and claim_waiter())
+            wake();
+    }
+
+    template < class T, class Executor >
+    void mpsc_async_queue_impl< T, Executor >::wake()
+    {
+        net::post(net::bind_executor(
+            default_executor_,
+            [self = boost::intrusive_ptr(this)] { self->deliver(); }));
+    }
+
+    template < class T, class Executor >
+    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, T))
+                   WaitHandler >
+    BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler, void(error_code, T))
+    mpsc_async_queue_impl< T, Executor >::async_pop(WaitHandler &&handler)
+    {
+        assert(this->state_ == not_waiting);
+
+        auto initiate = [this](auto &&deduced_handler) {
+            using DeducedHandler = decltype(deduced_handler);
+
+            emplace_guarded_handler(
+                this->handler_,
+                std::forward< DeducedHandler >(deduced_handler),
+                this->default_executor_);
+            park();
+        };
+
+        return net::async_initiate< WaitHandler, void(error_code, value_type) >(
+            initiate, handler);
+    }
+
+    template < class T, class Executor >
+    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code,
+                                                    std::vector< T >))
+                   WaitHandler >
+    BOOST_ASIO_INITFN_AUTO_RESULT_TYPE(WaitHandler,
+                                       void(error_code, std::vector< T >))
+    mpsc_async_queue_impl< T, Executor >::async_pop_some(std::size_t   max,
+                                                         WaitHandler &&handler)
+    {
+        assert(this->state_ == not_waiting);
+        assert(max > 0);
+
+        auto initiate = [this, max](auto &&deduced_handler) {
+            using DeducedHandler = decltype(deduced_handler);
+
+            emplace_guarded_handler(
+                this->batch_handler_,
+                std::forward< DeducedHandler >(deduced_handler),
+                this->default_executor_);
+            this->batch_max_ = max;
+            park();
+        };
+
+        return net::async_initiate< WaitHandler, void(error_code, batch_type) >(
+            initiate, handler);
+    }
+
+    template < class T, class Executor >
+    void mpsc_async_queue_impl< T, Executor >::push(value_type v)
+    {
+        if (stopped_.load(std::memory_order_relaxed))
+            return;
+
+        link(new node(std::move(v)));
+        if (claim_waiter())
+            wake();
+    }
+
+    template < class T, class Executor >
+    void mpsc_async_queue_impl< T, Executor >::push_range(batch_type vs)
+    {
+        if (stopped_.load(std::memory_order_relaxed))
+            return;
+
+        for (auto &v : vs)
+            link(new node(std::move(v)));
+        if (not vs.empty() and claim_waiter())
+            wake();
+    }
+
+    template < class T, class Executor >
+    void mpsc_async_queue_impl< T, Executor >::deliver()
+    {
+        // running in default executor, and the consumer has been claimed
+        if (stopped_.load())
+        {
+            while (auto n = unlink())
+                delete n;
+            auto ec = error_code(net::error::operation_aborted);
+            if (batch_handler_)
+                batch_handler_.dispatch_completion(ec, batch_type());
+            else
+                handler_.dispatch_completion(ec, value_type());
+        }
+        else if (batch_handler_)
+        {
+            auto vs = batch_type();
+            while (vs.size() < batch_max_)
+            {
+                auto n = unlink();
+                if (not n)
+                    break;
+                vs.push_back(std::move(n->value));
+                delete n;
+            }
+            if (vs.empty())
+                park();
+            else
+                batch_handler_.dispatch_completion(error_code(), std::move(vs));
+        }
+        else if (auto n = unlink())
+        {
+            auto v = std::move(n->value);
+            delete n;
+            handler_.dispatch_completion(error_code(), std::move(v));
+        }
+        else
+        {
+            // a producer is part way through linking. Park again; it will
+            // wake us when the link is complete
+            park();
+        }
+    }
+
+    template < class T, class Executor >
+    void mpsc_async_queue_impl< T, Executor >::stop()
+    {
+        stopped_.store(true);
+        if (claim_waiter())
+            wake();
+    }
+
+}   // namespace notstd::util::async::detail
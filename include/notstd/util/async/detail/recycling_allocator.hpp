@@ -0,0 +1,244 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <new>
+
+namespace notstd::util::async::detail
+{
+    /// A per-thread cache of memory blocks, bucketed into power-of-two size
+    /// classes.
+    ///
+    /// Blocks released to the cache are kept for reuse by the next allocation
+    /// of the same size class on the same thread, so that the steady state of
+    /// an allocate/deallocate cycle (such as constructing and invoking a
+    /// completion handler) never reaches the global heap. A block may be
+    /// released on a different thread to the one which allocated it.
+    struct recycling_cache
+    {
+        /// The smallest size class
+        static constexpr std::size_t min_block_size = 64;
+
+        /// The number of size classes. Requests larger than the largest class
+        /// are passed straight to the global heap.
+        static constexpr std::size_t class_count = 6;
+
+        /// The maximum number of blocks retained per size class
+        static constexpr std::size_t max_cached_blocks = 16;
+
+        static constexpr std::size_t max_block_size = min_block_size
+                                                      << (class_count - 1);
+
+        recycling_cache() noexcept = default;
+        recycling_cache(recycling_cache const &) = delete;
+        recycling_cache &operator=(recycling_cache const &) = delete;
+        ~recycling_cache();
+
+        /// Allocate at least `size` bytes aligned to `align`
+        auto allocate(std::size_t size,
+                      std::size_t align = alignof(std::max_align_t)) -> void *;
+
+        /// Release a block previously obtained from any thread's cache.
+        /// `size` and `align` must match the values passed to allocate
+        auto deallocate(void *      p,
+                        std::size_t size,
+                        std::size_t align = alignof(std::max_align_t)) noexcept
+            -> void;
+
+        /// The cache belonging to the calling thread
+        /// @pre the thread's cache has not been destroyed
+        static auto this_thread() noexcept -> recycling_cache &;
+
+        /// True once the calling thread's cache has been destroyed, during
+        /// thread or static teardown
+        static auto this_thread_destroyed() noexcept -> bool
+        {
+            return thread_cache_destroyed_;
+        }
+
+        /// Allocate from the calling thread's cache, or straight from the
+        /// global heap once that cache has been destroyed. Either way, a
+        /// cacheable request gets a whole block of its size class
+        static auto thread_allocate(std::size_t size, std::size_t align)
+            -> void *;
+
+        /// Release to the calling thread's cache, or straight to the global
+        /// heap once that cache has been destroyed
+        static auto thread_deallocate(void *      p,
+                                      std::size_t size,
+                                      std::size_t align) noexcept -> void;
+
+        /// @return the index of the size class which will hold `size` bytes,
+        /// or class_count if the request is too large to be cached
+        static constexpr auto size_class(std::size_t size) noexcept
+            -> std::size_t
+        {
+            auto cls   = std::size_t(0);
+            auto block = min_block_size;
+            while (cls < class_count and block < size)
+            {
+                ++cls;
+                block <<= 1;
+            }
+            return cls;
+        }
+
+        static constexpr auto block_size(std::size_t cls) noexcept
+            -> std::size_t
+        {
+            return min_block_size << cls;
+        }
+
+      private:
+        static constexpr bool is_over_aligned(std::size_t align) noexcept
+        {
+            return align > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+        }
+
+        struct free_block
+        {
+            free_block *next;
+        };
+
+        std::array< free_block *, class_count > heads_ {};
+        std::array< std::size_t, class_count >  counts_ {};
+
+        // trivially destructible, so still readable after the cache itself
+        // is gone
+        static inline thread_local bool thread_cache_destroyed_ = false;
+    };
+
+    /// A standard allocator which draws memory from the calling thread's
+    /// recycling_cache. Used as the default allocator for handler storage
+    /// when the handler has no associated allocator of its own.
+    template < class T >
+    struct recycling_allocator
+    {
+        using value_type = T;
+
+        template < class U >
+        struct rebind
+        {
+            using other = recycling_allocator< U >;
+        };
+
+        constexpr recycling_allocator() noexcept = default;
+
+        template < class U >
+        constexpr recycling_allocator(recycling_allocator< U > const &) noexcept
+        {
+        }
+
+        auto allocate(std::size_t n) -> T *
+        {
+            return static_cast< T * >(recycling_cache::thread_allocate(
+                sizeof(T) * n, alignof(T)));
+        }
+
+        auto deallocate(T *p, std::size_t n) noexcept -> void
+        {
+            recycling_cache::thread_deallocate(p, sizeof(T) * n, alignof(T));
+        }
+
+        template < class U >
+        friend constexpr bool operator==(recycling_allocator const &,
+                                         recycling_allocator< U > const &)
+        {
+            return true;
+        }
+
+        template < class U >
+        friend constexpr bool operator!=(recycling_allocator const &,
+                                         recycling_allocator< U > const &)
+        {
+            return false;
+        }
+    };
+
+}   // namespace notstd::util::async::detail
+
+namespace notstd::util::async::detail
+{
+    inline recycling_cache::~recycling_cache()
+    {
+        for (auto cls = std::size_t(0); cls < class_count; ++cls)
+            while (auto block = heads_[cls])
+            {
+                heads_[cls] = block->next;
+                ::operator delete(block);
+            }
+    }
+
+    inline auto recycling_cache::allocate(std::size_t size, std::size_t align)
+        -> void *
+    {
+        if (is_over_aligned(align))
+            return ::operator new(size, std::align_val_t(align));
+
+        auto cls = size_class(size);
+        if (cls == class_count)
+            return ::operator new(size);
+
+        if (auto block = heads_[cls])
+        {
+            heads_[cls] = block->next;
+            --counts_[cls];
+            return block;
+        }
+
+        return ::operator new(block_size(cls));
+    }
+
+    inline auto recycling_cache::deallocate(void *      p,
+                                            std::size_t size,
+                                            std::size_t align) noexcept -> void
+    {
+        if (is_over_aligned(align))
+            return ::operator delete(p, std::align_val_t(align));
+
+        auto cls = size_class(size);
+        if (cls == class_count or counts_[cls] == max_cached_blocks)
+            return ::operator delete(p);
+
+        heads_[cls] = new (p) free_block { heads_[cls] };
+        ++counts_[cls];
+    }
+
+    inline auto recycling_cache::this_thread() noexcept -> recycling_cache &
+    {
+        // marks the cache destroyed before its blocks are freed
+        struct owner
+        {
+            ~owner() { thread_cache_destroyed_ = true; }
+
+            recycling_cache cache;
+        };
+        static thread_local owner o;
+        return o.cache;
+    }
+
+    inline auto recycling_cache::thread_allocate(std::size_t size,
+                                                 std::size_t align) -> void *
+    {
+        if (not thread_cache_destroyed_)
+            return this_thread().allocate(size, align);
+        if (is_over_aligned(align))
+            return ::operator new(size, std::align_val_t(align));
+
+        // a whole block, as the block may be released to a live thread's
+        // cache and handed out again as one
+        auto cls = size_class(size);
+        return ::operator new(cls == class_count ? size : block_size(cls));
+    }
+
+    inline auto recycling_cache::thread_deallocate(void *      p,
+                                                   std::size_t size,
+                                                   std::size_t align) noexcept
+        -> void
+    {
+        if (not thread_cache_destroyed_)
+            return this_thread().deallocate(p, size, align);
+        if (is_over_aligned(align))
+            return ::operator delete(p, std::align_val_t(align));
+        ::operator delete(p);
+    }
+}   // namespace notstd::util::async::detail
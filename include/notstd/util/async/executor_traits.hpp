@@ -1,9 +1,26 @@
 #pragma once
 
+#include <boost/asio/detail/concurrency_hint.hpp>
 #include <notstd/util/net.hpp>
 
 namespace notstd::util::async
 {
+    namespace detail
+    {
+        /// True if the context is an io_context (or thread pool) which was
+        /// told, via its concurrency hint, that only one thread will run it
+        inline auto is_single_threaded_context(net::execution_context &ctx)
+            -> bool
+        {
+            using impl_type = net::detail::io_context_impl;
+            if (not net::has_service< impl_type >(ctx))
+                return false;
+            auto hint = net::use_service< impl_type >(ctx).concurrency_hint();
+            return hint == 1 or
+                   not BOOST_ASIO_CONCURRENCY_HINT_IS_LOCKING(SCHEDULER, hint);
+        }
+    }   // namespace detail
+
     template < class Executor >
     struct executor_traits_base
     {
@@ -15,6 +32,12 @@ namespace notstd::util::async
         using use_awaitable_t = net::use_awaitable_t< executor_type >;
 
         constexpr static auto use_awaitable = use_awaitable_t();
+
+        /// The concrete handler type produced when use_awaitable is passed as
+        /// the completion token to an operation with signature Sig
+        template < class Sig >
+        using awaitable_handler =
+            typename net::async_result< use_awaitable_t, Sig >::handler_type;
     };
 
     template < class Executor >
@@ -29,6 +52,13 @@ namespace notstd::util::async
         {
             return exec;
         }
+
+        /// True if handlers submitted to exec can never run concurrently with
+        /// each other
+        static auto is_single_threaded(executor_type const &exec) -> bool
+        {
+            return detail::is_single_threaded_context(exec.context());
+        }
     };
 
     template < class InnerExecutor >
@@ -53,6 +83,11 @@ namespace notstd::util::async
         {
             return exec.get_inner_executor();
         }
+
+        static constexpr auto is_single_threaded(executor_type const &) -> bool
+        {
+            return true;
+        }
     };
 
 }   // namespace notstd::util::async
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+#include <span>
+
+namespace notstd::util::async
+{
+    /// A piece of a websocket message, delivered to a streaming frame
+    /// handler as it arrives
+    struct frame_fragment
+    {
+        /// The bytes received since the previous fragment. Valid only for
+        /// the duration of the call
+        std::span< char > data;
+
+        /// This is the start of a new message
+        bool first = false;
+
+        /// This completes the message
+        bool last = false;
+    };
+
+}   // namespace notstd::util::async
@@ -0,0 +1,22 @@
+#pragma once
+
+namespace notstd::util::async
+{
+    /// What a bounded queue does with a value pushed while it is at capacity
+    enum class overflow_policy
+    {
+        /// The producer waits for space (async_push) or fails (try_push)
+        block,
+
+        /// The oldest queued value is discarded to make room
+        drop_oldest,
+
+        /// The pushed value is discarded
+        drop_newest,
+
+        /// A queued value with the same key as the pushed value is replaced
+        /// in place. If no queued value shares its key, behaves as block
+        conflate
+    };
+
+}   // namespace notstd::util::async
@@ -1,89 +1,194 @@
 #pragma once
+#include <algorithm>
 #include <memory>
 #include <notstd/util/async/detail/has_get_executor.hpp>
+#include <notstd/util/async/detail/recycling_allocator.hpp>
 #include <notstd/util/async/wrap_work_guard.hpp>
 #include <notstd/util/net.hpp>
+#include <tuple>
 #include <type_traits>
 
 namespace notstd::util::async
 {
     namespace detail
     {
+        /// Default inline capacity of a poly_handler, in bytes
+        constexpr std::size_t default_inline_bytes = sizeof(void *) * 6;
+
+        /// Default alignment of a poly_handler's inline buffer
+        constexpr std::size_t default_inline_align = alignof(void *);
+
+        template < std::size_t InlineBytes, std::size_t Align >
         union sbo_storage
         {
+            static_assert(InlineBytes >= sizeof(void *));
+            static_assert(Align >= alignof(void *) and
+                          (Align & (Align - 1)) == 0);
+
             sbo_storage() noexcept {}
 
             ~sbo_storage() {}
 
-            void *                             short_[6];
-            std::unique_ptr< unsigned char[] > long_;
+            alignas(Align) unsigned char short_[InlineBytes];
+            void *long_;
+        };
+
+        /// True if a handler of type Actual will be stored in an inline buffer
+        /// of the given size and alignment, rather than on the heap
+        template < class Actual, std::size_t InlineBytes, std::size_t Align >
+        constexpr bool fits_inline =
+            sizeof(Actual) <= InlineBytes and alignof(Actual) <= Align;
+
+        /// How a completion is delivered to its handler's executor
+        enum class schedule_mode
+        {
+            /// never run inline; as if by net::post
+            post,
+            /// run inline if already on the handler's executor; as if by
+            /// net::dispatch
+            dispatch
         };
 
-        template < class Ret, class... Args >
+        template < class Storage, class Ret, class... Args >
         struct poly_handler_vtable
         {
             // move-construct from value - may throw
-            void (*const move_construct_from_actual)(sbo_storage &storage,
+            void (*const move_construct_from_actual)(Storage &storage,
                                                      void *actual) noexcept;
 
             // move construct from other SBO. May not throw
-            void (*const move_construct)(sbo_storage &storage,
-                                         sbo_storage &source) noexcept;
+            void (*const move_construct)(Storage &storage,
+                                         Storage &source) noexcept;
+
+            Ret (*const invoke)(Storage &storage, Args... args);
 
-            Ret (*const invoke)(sbo_storage &storage, Args... args);
+            // move the handler out of storage and schedule its invocation
+            // with the given arguments on its associated executor
+            void (*const schedule)(
+                Storage &                             storage,
+                std::tuple< std::decay_t< Args >... > &&args,
+                schedule_mode                          mode);
 
-            void (*const destroy)(sbo_storage &storage) noexcept;
+            void (*const destroy)(Storage &storage) noexcept;
 
             net::executor (*const get_executor)(
-                sbo_storage const &storage) noexcept;
+                Storage const &storage) noexcept;
         };
 
-        template < class Actual, class Ret, class... Args >
-        static auto make_small_poly_handler_vtable()
+        /// A handler bound to the arguments of its completion, scheduled by
+        /// poly_handler::post_completion. The operation is allocated with the
+        /// handler's associated allocator, or the thread's recycling cache if
+        /// it has none, and executed on the handler's associated executor.
+        template < class Handler, class ArgTuple >
+        struct bound_completion
         {
-            static_assert(sizeof(Actual) <= sizeof(sbo_storage));
+            using executor_type = net::associated_executor_t< Handler >;
+            using allocator_type =
+                net::associated_allocator_t< Handler,
+                                             recycling_allocator< void > >;
 
-            static const struct mine : poly_handler_vtable< Ret, Args... >
+            auto get_executor() const noexcept -> executor_type
             {
-                static Actual &realise(sbo_storage &storage) noexcept
+                return net::get_associated_executor(handler_);
+            }
+
+            auto get_allocator() const noexcept -> allocator_type
+            {
+                return net::get_associated_allocator(
+                    handler_, recycling_allocator< void >());
+            }
+
+            void operator()() { std::apply(handler_, std::move(args_)); }
+
+            Handler  handler_;
+            ArgTuple args_;
+        };
+
+        /// True if a completion with signature void(Args...) may be posted,
+        /// i.e. invoked later with decayed copies of its arguments
+        template < class... Args >
+        constexpr bool is_postable_v =
+            std::is_invocable_v< void (*)(Args...), std::decay_t< Args >... >;
+
+        template < class Handler, class ArgTuple >
+        void schedule_bound_completion(Handler &&    handler,
+                                       ArgTuple &&   args,
+                                       schedule_mode mode)
+        {
+            auto op = bound_completion< std::decay_t< Handler >,
+                                        std::decay_t< ArgTuple > > {
+                std::forward< Handler >(handler),
+                std::forward< ArgTuple >(args)
+            };
+            if (mode == schedule_mode::dispatch)
+                net::dispatch(std::move(op));
+            else
+                net::post(std::move(op));
+        }
+
+        template < class Actual, class Storage, class Ret, class... Args >
+        auto make_small_poly_handler_vtable()
+        {
+            static_assert(fits_inline< Actual,
+                                       sizeof(Storage::short_),
+                                       alignof(Storage) >);
+
+            static const struct mine
+            : poly_handler_vtable< Storage, Ret, Args... >
+            {
+                static Actual &realise(Storage &storage) noexcept
                 {
                     return *reinterpret_cast< Actual * >(&storage.short_[0]);
                 }
 
                 static Actual const &
-                realise(sbo_storage const &storage) noexcept
+                realise(Storage const &storage) noexcept
                 {
                     return *reinterpret_cast< Actual const * >(
                         &storage.short_[0]);
                 }
 
-                static void move_construct_from_actual_(sbo_storage &storage,
+                static void move_construct_from_actual_(Storage &storage,
                                                         void *source) noexcept
                 {
                     new (&realise(storage)) Actual(
                         std::move(*reinterpret_cast< Actual * >(source)));
                 }
 
-                static void move_construct_(sbo_storage &storage,
-                                            sbo_storage &source) noexcept
+                static void move_construct_(Storage &storage,
+                                            Storage &source) noexcept
                 {
                     new (&realise(storage)) Actual(std::move(realise(source)));
                 }
 
-                static Ret invoke_(sbo_storage &storage, Args... args)
+                static Ret invoke_(Storage &storage, Args... args)
                 {
                     auto act = std::move(realise(storage));
                     destroy_(storage);
-                    return act(std::move(args)...);
+                    return act(std::forward< Args >(args)...);
                 }
 
-                static void destroy_(sbo_storage &storage) noexcept
+                static void
+                schedule_(Storage &                             storage,
+                          std::tuple< std::decay_t< Args >... > &&args,
+                          schedule_mode                          mode)
+                {
+                    if constexpr (is_postable_v< Args... >)
+                    {
+                        auto act = std::move(realise(storage));
+                        destroy_(storage);
+                        schedule_bound_completion(
+                            std::move(act), std::move(args), mode);
+                    }
+                }
+
+                static void destroy_(Storage &storage) noexcept
                 {
                     realise(storage).~Actual();
                 }
 
                 static net::executor
-                get_executor_(sbo_storage const &storage) noexcept
+                get_executor_(Storage const &storage) noexcept
                 {
                     return net::get_associated_executor(realise(storage));
                 }
@@ -91,63 +196,105 @@ namespace notstd::util::async
                         &mine::move_construct_from_actual_,
                     .move_construct = &mine::move_construct_,
                     .invoke         = &mine::invoke_,
+                    .schedule       = &mine::schedule_,
                     .destroy        = &mine::destroy_,
                     .get_executor   = &mine::get_executor_ } };
             return &x;
         }
 
-        template < class Actual, class Ret, class... Args >
+        template < class Actual, class Storage, class Ret, class... Args >
         auto make_big_poly_handler_vtable()
         {
-            static_assert(sizeof(Actual) > sizeof(sbo_storage));
+            static_assert(not fits_inline< Actual,
+                                           sizeof(Storage::short_),
+                                           alignof(Storage) >);
 
-            static const struct mine : poly_handler_vtable< Ret, Args... >
+            static const struct mine
+            : poly_handler_vtable< Storage, Ret, Args... >
             {
-                static void move_construct_from_actual(sbo_storage &storage,
+                // storage for the handler comes from the handler's associated
+                // allocator, or the thread's recycling cache if it has none
+                using allocator_type = typename std::allocator_traits<
+                    net::associated_allocator_t<
+                        Actual,
+                        recycling_allocator< void > > >::
+                    template rebind_alloc< Actual >;
+                using alloc_traits = std::allocator_traits< allocator_type >;
+
+                static Actual &realise(Storage const &storage) noexcept
+                {
+                    return *static_cast< Actual * >(storage.long_);
+                }
+
+                static allocator_type get_allocator(Actual const &actual)
+                {
+                    return allocator_type(net::get_associated_allocator(
+                        actual, recycling_allocator< void >()));
+                }
+
+                static void move_construct_from_actual(Storage &storage,
                                                        void *source) noexcept
                 {
-                    constexpr auto size = sizeof(Actual);
-                    new (&storage.long_) std::unique_ptr< unsigned char[] >();
-                    storage.long_.reset(new unsigned char[size]);
-                    new (storage.long_.get()) Actual(
-                        std::move(*reinterpret_cast< Actual * >(source)));
+                    auto &src   = *reinterpret_cast< Actual * >(source);
+                    auto  alloc = get_allocator(src);
+                    auto  p     = alloc_traits::allocate(alloc, 1);
+                    storage.long_ = new (p) Actual(std::move(src));
                 }
 
-                static void move_construct(sbo_storage &storage,
-                                           sbo_storage &source) noexcept
+                static void move_construct(Storage &storage,
+                                           Storage &source) noexcept
                 {
-                    new (&storage.long_) std::unique_ptr< unsigned char[] >(
-                        std::move(source.long_));
+                    storage.long_ = std::exchange(source.long_, nullptr);
                 }
 
-                static Ret invoke(sbo_storage &storage, Args... args)
+                static Ret invoke(Storage &storage, Args... args)
                 {
-                    auto act = std::move(
-                        *reinterpret_cast< Actual * >(storage.long_.get()));
-                    storage.long_.reset();
+                    // move the handler out and release its memory before the
+                    // upcall, so that any operation it initiates may reuse the
+                    // block
+                    auto act = std::move(realise(storage));
                     destroy(storage);
-                    return act(std::move(args)...);
+                    return act(std::forward< Args >(args)...);
                 }
 
-                static void destroy(sbo_storage &storage) noexcept
+                static void
+                schedule(Storage &                             storage,
+                         std::tuple< std::decay_t< Args >... > &&args,
+                         schedule_mode                          mode)
                 {
-                    if (storage.long_)
-                        reinterpret_cast< Actual * >(storage.long_.get())
-                            ->~Actual();
-                    storage.long_.~unique_ptr< unsigned char[] >();
+                    if constexpr (is_postable_v< Args... >)
+                    {
+                        // the handler's memory is released before the
+                        // operation is allocated, so the operation may reuse
+                        // the block
+                        auto act = std::move(realise(storage));
+                        destroy(storage);
+                        schedule_bound_completion(
+                            std::move(act), std::move(args), mode);
+                    }
+                }
+
+                static void destroy(Storage &storage) noexcept
+                {
+                    if (auto p = static_cast< Actual * >(
+                            std::exchange(storage.long_, nullptr)))
+                    {
+                        auto alloc = get_allocator(*p);
+                        p->~Actual();
+                        alloc_traits::deallocate(alloc, p, 1);
+                    }
                 }
 
                 static net::executor
-                get_executor(sbo_storage const &storage) noexcept
+                get_executor(Storage const &storage) noexcept
                 {
-                    auto &actual =
-                        *reinterpret_cast< Actual * >(storage.long_.get());
-                    return net::get_associated_executor(actual);
+                    return net::get_associated_executor(realise(storage));
                 }
             } x { { .move_construct_from_actual =
                         &mine::move_construct_from_actual,
                     .move_construct = &mine::move_construct,
                     .invoke         = &mine::invoke,
+                    .schedule       = &mine::schedule,
                     .destroy        = &mine::destroy,
                     .get_executor   = &mine::get_executor } };
             return &x;
@@ -156,9 +303,55 @@ namespace notstd::util::async
     }   // namespace detail
     /// A polymorphic completion handler
     /// \tparam Sig
-    template < class Sig >
+    /// \tparam InlineBytes The capacity of the inline buffer. Handlers which
+    /// do not fit are stored in memory obtained from their associated
+    /// allocator
+    /// \tparam Align The alignment of the inline buffer. Handlers with a
+    /// stricter alignment requirement are stored out of line
+    template < class Sig,
+               std::size_t InlineBytes = detail::default_inline_bytes,
+               std::size_t Align       = detail::default_inline_align >
     class poly_handler;
 
+    /// Reports whether a Handler will be stored in the inline buffer of
+    /// the poly_handler type PolyHandler, i.e. whether constructing the
+    /// PolyHandler from a Handler is free of allocations. Intended for use
+    /// in static_assert at call sites which must not allocate.
+    template < class PolyHandler, class Handler >
+    struct is_stored_inline;
+
+    template < class Sig,
+               std::size_t InlineBytes,
+               std::size_t Align,
+               class Handler >
+    struct is_stored_inline< poly_handler< Sig, InlineBytes, Align >, Handler >
+    : std::bool_constant<
+          detail::fits_inline< std::decay_t< Handler >, InlineBytes, Align > >
+    {
+    };
+
+    template < class PolyHandler, class Handler >
+    constexpr bool is_stored_inline_v =
+        is_stored_inline< PolyHandler, Handler >::value;
+
+    /// A poly_handler whose inline buffer is large enough, and sufficiently
+    /// aligned, to hold any of Handlers (and never smaller than the default)
+    template < class Sig, class... Handlers >
+    using poly_handler_for =
+        poly_handler< Sig,
+                      std::max({ detail::default_inline_bytes,
+                                 sizeof(Handlers)... }),
+                      std::max({ detail::default_inline_align,
+                                 alignof(Handlers)... }) >;
+
+    /// The type of handler stored by poly_handler::emplace_with_guards when
+    /// given a Handler whose executor differs from the default executor
+    template < class Handler, class DefaultExecutor >
+    using guarded_handler_t =
+        basic_handler_with_work_guard< std::decay_t< Handler >,
+                                       net::associated_executor_t< Handler >,
+                                       DefaultExecutor >;
+
     template < class T, class U >
     concept ConvertibleTo = requires
     {
@@ -175,11 +368,18 @@ namespace notstd::util::async
         ->ConvertibleTo< Ret >;
     };
 
-    template < class Ret, class... Args >
-    class poly_handler< Ret(Args...) >
+    template < class Ret,
+               class... Args,
+               std::size_t InlineBytes,
+               std::size_t Align >
+    class poly_handler< Ret(Args...), InlineBytes, Align >
     {
-        detail::sbo_storage                                storage_;
-        detail::poly_handler_vtable< Ret, Args... > const *kind_;
+        using storage_type = detail::sbo_storage< InlineBytes, Align >;
+        using vtable_type =
+            detail::poly_handler_vtable< storage_type, Ret, Args... >;
+
+        storage_type       storage_;
+        vtable_type const *kind_;
 
       public:
         using executor_type = net::executor;
@@ -222,14 +422,21 @@ namespace notstd::util::async
             return *this;
         }
 
-        poly_handler &operator=(nullptr_t) noexcept { destroy(); }
+        poly_handler &operator=(nullptr_t) noexcept
+        {
+            destroy();
+            return *this;
+        }
 
         poly_handler &operator=(poly_handler &&other) noexcept
         {
             destroy();
             kind_ = std::exchange(other.kind_, nullptr);
-            kind_->move_construct(storage_, other.storage_);
-            kind_->destroy(other.storage_);
+            if (kind_)
+            {
+                kind_->move_construct(storage_, other.storage_);
+                kind_->destroy(other.storage_);
+            }
             return *this;
         }
 
@@ -243,7 +450,7 @@ namespace notstd::util::async
             auto k = std::exchange(kind_, nullptr);
             if (k)
                 // invoke implies destroy
-                return k->invoke(storage_, std::move(args)...);
+                return k->invoke(storage_, std::forward< Args >(args)...);
             else
                 throw std::bad_function_call();
         }
@@ -251,7 +458,12 @@ namespace notstd::util::async
         /// Post the execution of the completion handler to the captured
         /// executor. The completion handler shall not execute until after this
         /// function has returned Once this function has returned, the handler
-        /// shall be empty
+        /// shall be empty.
+        ///
+        /// The handler is posted to its own (concrete) associated executor
+        /// rather than through the polymorphic executor_type, so the only
+        /// allocation is of the operation itself, which comes from the
+        /// handler's associated allocator or the thread's recycling cache.
         /// @tparam CallArgs
         /// @param args
         /// @pre has_value() == true
@@ -259,17 +471,32 @@ namespace notstd::util::async
         template < class... CallArgs >
         void post_completion(CallArgs &&... args)
         {
+            static_assert(detail::is_postable_v< Args... >,
+                          "arguments must be deliverable by value");
             assert(has_value());
-            if (has_value())
-            {
-                auto e = get_executor();
-                net::post(e,
-                          [handler = std::move(*this),
-                           targs   = std::make_tuple(
-                               std::forward< CallArgs >(args)...)]() mutable {
-                              std::apply(handler, std::move(targs));
-                          });
-            }
+            if (auto k = std::exchange(kind_, nullptr))
+                k->schedule(storage_,
+                            std::tuple< std::decay_t< Args >... >(
+                                std::forward< CallArgs >(args)...),
+                            detail::schedule_mode::post);
+        }
+
+        /// As post_completion, except that the handler is invoked before this
+        /// function returns if the caller is already running on the handler's
+        /// associated executor.
+        /// @pre has_value() == true
+        /// @post has_value() == false
+        template < class... CallArgs >
+        void dispatch_completion(CallArgs &&... args)
+        {
+            static_assert(detail::is_postable_v< Args... >,
+                          "arguments must be deliverable by value");
+            assert(has_value());
+            if (auto k = std::exchange(kind_, nullptr))
+                k->schedule(storage_,
+                            std::tuple< std::decay_t< Args >... >(
+                                std::forward< CallArgs >(args)...),
+                            detail::schedule_mode::dispatch);
         }
 
         bool has_value() const { return kind_ != nullptr; }
@@ -286,7 +513,7 @@ namespace notstd::util::async
                                  DefaultExecutor default_exec)
         {
             assert(not has_value());
-            if (detail::has_get_executor_v< Handler >)
+            if constexpr (detail::has_get_executor_v< Handler >)
             {
                 auto he = handler.get_executor();
                 if (he == default_exec)
@@ -313,13 +540,16 @@ namespace notstd::util::async
         template < class Actual >
         void construct(Actual &&actual)
         {
-            constexpr auto size  = sizeof(Actual);
-            constexpr auto limit = sizeof(storage_.short_);
-            if constexpr (size > limit)
+            using actual_type = std::decay_t< Actual >;
+            if constexpr (not detail::fits_inline< actual_type,
+                                                   InlineBytes,
+                                                   Align >)
             {
                 // non-sbo
-                auto kind = detail::
-                    make_big_poly_handler_vtable< Actual, Ret, Args... >();
+                auto kind = detail::make_big_poly_handler_vtable< actual_type,
+                                                                  storage_type,
+                                                                  Ret,
+                                                                  Args... >();
                 kind->move_construct_from_actual(storage_,
                                                  std::addressof(actual));
                 kind_ = kind;
@@ -327,8 +557,11 @@ namespace notstd::util::async
             else
             {
                 // sbo
-                auto kind = detail::
-                    make_small_poly_handler_vtable< Actual, Ret, Args... >();
+                auto kind =
+                    detail::make_small_poly_handler_vtable< actual_type,
+                                                            storage_type,
+                                                            Ret,
+                                                            Args... >();
                 kind->move_construct_from_actual(storage_,
                                                  std::addressof(actual));
                 kind_ = kind;
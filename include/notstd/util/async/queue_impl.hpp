@@ -1,20 +1,49 @@
 #pragma once
 
-#include <deque>
+#include <algorithm>
+#include <notstd/util/async/executor_traits.hpp>
 #include <notstd/util/async/poly_handler.hpp>
 #include <notstd/util/net.hpp>
+#include <notstd/util/ring_buffer.hpp>
+#include <vector>
 
 namespace notstd::util::async
 {
-    template < class Type, class Executor >
+    /// @tparam Container the FIFO storage for values which have not yet been
+    /// popped. Must provide empty, size, front, push_back and pop_front
+    template < class Type,
+               class Executor,
+               class Container = ring_buffer< Type > >
     struct queue_impl
     {
         using executor_type = Executor;
 
+        /// The type delivered by async_pop_some
+        using batch_type = std::vector< Type >;
+
+        /// Storage for a waiting pop handler, sized so that a coroutine
+        /// awaiting async_pop from another executor is held without
+        /// allocation
+        using handler_type = poly_handler_for<
+            void(error_code, Type),
+            guarded_handler_t< typename executor_traits< Executor >::
+                                   template awaitable_handler< void(error_code,
+                                                                    Type) >,
+                               Executor > >;
+
+        /// Storage for a waiting async_pop_some handler
+        using batch_handler_type = poly_handler_for<
+            void(error_code, batch_type),
+            guarded_handler_t<
+                typename executor_traits< Executor >::
+                    template awaitable_handler< void(error_code, batch_type) >,
+                Executor > >;
+
         queue_impl(executor_type exec)
         : exec_(exec)
         , queue_()
         , handler_()
+        , batch_handler_()
         {
         }
 
@@ -22,29 +51,55 @@ namespace notstd::util::async
         {
             if (handler_)
                 handler_.post_completion(ec, Type());
+            if (batch_handler_)
+                batch_handler_.post_completion(ec, batch_type());
         }
 
         auto get_executor() const -> executor_type { return exec_; }
 
         auto push(Type x) -> void;
+
+        /// Push a number of values with at most one completion of a waiting
+        /// pop
+        auto push_range(batch_type xs) -> void;
+
         template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, Type))
                        PopHandler >
         auto async_pop(PopHandler &&token)
             -> BOOST_ASIO_INITFN_RESULT_TYPE(PopHandler,
                                              void(error_code, Type));
 
-        executor_type                          exec_;
-        std::deque< Type >                     queue_;
-        poly_handler< void(error_code, Type) > handler_;
+        /// Wait for at least one value, then complete with all ready values,
+        /// up to a maximum of `max`, in a single completion.
+        /// @pre max > 0
+        template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code,
+                                                        batch_type))
+                       PopHandler >
+        auto async_pop_some(std::size_t max, PopHandler &&token)
+            -> BOOST_ASIO_INITFN_RESULT_TYPE(PopHandler,
+                                             void(error_code, batch_type));
+
+        // remove up to max values from the front of the queue
+        auto take(std::size_t max) -> batch_type;
+
+        // complete a waiting handler if there is anything to deliver
+        auto maybe_complete() -> void;
+
+        executor_type      exec_;
+        Container          queue_;
+        handler_type       handler_;
+        batch_handler_type batch_handler_;
+        std::size_t        batch_max_ = 0;
     };
 }   // namespace notstd::util::async
 
 namespace notstd::util::async
 {
-    template < class Type, class Executor >
+    template < class Type, class Executor, class Container >
     template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, Type))
                    PopHandler >
-    auto queue_impl< Type, Executor >::async_pop(PopHandler &&token)
+    auto
+    queue_impl< Type, Executor, Container >::async_pop(PopHandler &&token)
         -> BOOST_ASIO_INITFN_RESULT_TYPE(PopHandler, void(error_code, Type))
     {
         return net::async_initiate< PopHandler, void(error_code, Type) >(
@@ -56,9 +111,11 @@ namespace notstd::util::async
                 {
                     auto exec =
                         net::get_associated_executor(handler, get_executor());
+                    auto val = std::move(queue_.front());
+                    queue_.pop_front();
                     net::defer(exec,
                                [handler = std::move(handler),
-                                val     = std::move(queue_.front())]() mutable {
+                                val     = std::move(val)]() mutable {
                                    handler(error_code(), std::move(val));
                                });
                 }
@@ -66,8 +123,40 @@ namespace notstd::util::async
             token);
     }
 
-    template < class Type, class Executor >
-    auto queue_impl<Type, Executor>::push(Type x) -> void
+    template < class Type, class Executor, class Container >
+    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code,
+                                                    std::vector< Type >))
+                   PopHandler >
+    auto queue_impl< Type, Executor, Container >::async_pop_some(
+        std::size_t max, PopHandler &&token)
+        -> BOOST_ASIO_INITFN_RESULT_TYPE(PopHandler,
+                                         void(error_code, batch_type))
+    {
+        assert(max > 0);
+        return net::async_initiate< PopHandler, void(error_code, batch_type) >(
+            [this, max](auto &&handler) {
+                if (queue_.empty())
+                {
+                    batch_handler_.emplace_with_guards(std::move(handler),
+                                                       get_executor());
+                    batch_max_ = max;
+                }
+                else
+                {
+                    auto exec =
+                        net::get_associated_executor(handler, get_executor());
+                    net::defer(exec,
+                               [handler = std::move(handler),
+                                vals    = take(max)]() mutable {
+                                   handler(error_code(), std::move(vals));
+                               });
+                }
+            },
+            token);
+    }
+
+    template < class Type, class Executor, class Container >
+    auto queue_impl< Type, Executor, Container >::push(Type x) -> void
     {
         if (handler_.has_value())
         {
@@ -77,8 +166,59 @@ namespace notstd::util::async
         else
         {
             queue_.push_back(std::move(x));
+            maybe_complete();
         }
     }
 
+    template < class Type, class Executor, class Container >
+    auto queue_impl< Type, Executor, Container >::push_range(batch_type xs)
+        -> void
+    {
+        if (batch_handler_.has_value() and xs.size() <= batch_max_)
+        {
+            // hand the whole range to the waiter without copying
+            assert(queue_.empty());
+            if (not xs.empty())
+                batch_handler_.post_completion(error_code(), std::move(xs));
+        }
+        else
+        {
+            for (auto &x : xs)
+                queue_.push_back(std::move(x));
+            maybe_complete();
+        }
+    }
 
-}   // namespace notstd::util::async
\ No newline at end of file
+    template < class Type, class Executor, class Container >
+    auto queue_impl< Type, Executor, Container >::take(std::size_t max)
+        -> batch_type
+    {
+        auto vals = batch_type();
+        vals.reserve(std::min(max, queue_.size()));
+        while (vals.size() < max and not queue_.empty())
+        {
+            vals.push_back(std::move(queue_.front()));
+            queue_.pop_front();
+        }
+        return vals;
+    }
+
+    template < class Type, class Executor, class Container >
+    auto queue_impl< Type, Executor, Container >::maybe_complete() -> void
+    {
+        if (queue_.empty())
+            return;
+
+        if (handler_.has_value())
+        {
+            auto val = std::move(queue_.front());
+            queue_.pop_front();
+            handler_.post_completion(error_code(), std::move(val));
+        }
+        else if (batch_handler_.has_value())
+        {
+            batch_handler_.post_completion(error_code(), take(batch_max_));
+        }
+    }
+
+}   // namespace notstd::util::async
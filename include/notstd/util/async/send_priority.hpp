@@ -0,0 +1,17 @@
+#pragma once
+
+namespace notstd::util::async
+{
+    /// The transmit lane of an outgoing websocket frame. Frames in a lane are
+    /// sent in the order queued, and every queued urgent frame is sent before
+    /// any queued bulk frame
+    enum class send_priority
+    {
+        /// Latency critical messages, such as orders and cancels
+        urgent,
+
+        /// Everything else
+        bulk
+    };
+
+}   // namespace notstd::util::async
@@ -30,6 +30,20 @@ namespace notstd::util::async
 
         auto cancel(error_code = net::error::operation_aborted) -> void;
 
+        /// How the TCP connection is raced
+        /// @pre the connect has not started
+        auto set_connect_options(happy_eyeballs_options opts) -> void
+        {
+            connect_options_ = opts;
+        }
+
+        /// The cache the host is resolved through, if any
+        /// @pre the connect has not started
+        auto set_resolve_cache(std::shared_ptr< resolve_cache > cache) -> void
+        {
+            resolve_cache_ = std::move(cache);
+        }
+
         auto get_executor() -> executor_type { return stream_.get_executor(); }
 
         friend auto operator<<(std::ostream &                             os,
@@ -43,6 +57,8 @@ namespace notstd::util::async
       private:
         stream_type &                     stream_;
         std::function< void(error_code) > on_cancel_;
+        happy_eyeballs_options            connect_options_;
+        std::shared_ptr< resolve_cache >  resolve_cache_;
     };
 
     template < class NextLayer >
@@ -75,6 +91,8 @@ namespace notstd::util::async
         //
 
         auto next_connect_state = make_connect_state_impl(stream_.next_layer());
+        next_connect_state.set_connect_options(connect_options_);
+        next_connect_state.set_resolve_cache(resolve_cache_);
         on_cancel_              = [&](error_code ec) {
             my_error = ec;
             next_connect_state.cancel(ec);
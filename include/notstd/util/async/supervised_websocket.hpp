@@ -0,0 +1,336 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <notstd/util/async/async_join_impl.hpp>
+#include <notstd/util/async/websocket_state_impl.hpp>
+#include <notstd/util/backoff.hpp>
+#include <notstd/util/ring_buffer.hpp>
+#include <optional>
+
+namespace notstd::util::async
+{
+    /// A websocket connection which is re-established whenever it fails,
+    /// until it is closed.
+    ///
+    /// Each connection is a fresh websocket_state_impl. Reconnects are
+    /// spaced by jittered exponential backoff, so that many clients which
+    /// lost their connections at once do not all retry together. After each
+    /// connect the on_connected hook is called, so that subscriptions and
+    /// other session state can be replayed, and then any frames sent while
+    /// there was no connection go out, in order.
+    ///
+    /// Frames handed to a connection which then fails are lost with it.
+    /// As for websocket_state_impl, every member function is called on the
+    /// executor.
+    template < class NextLayer, class TextType = std::string >
+    class supervised_websocket
+    {
+      public:
+        using state_type    = websocket_state_impl< NextLayer, TextType >;
+        using executor_type = typename state_type::executor_type;
+        using awaitable     = typename state_type::awaitable;
+
+        /// Constructs the state of each new connection, for instance to
+        /// pass an SSL context or apply options
+        using make_state_type =
+            std::function< std::unique_ptr< state_type >(executor_type) >;
+
+        struct options
+        {
+            backoff_policy reconnect;
+
+            /// The most frames held while there is no connection
+            std::size_t max_buffered_frames = 1024;
+
+            /// The most bytes held while there is no connection
+            std::size_t max_buffered_bytes = 1024 * 1024;
+        };
+
+        supervised_websocket(executor_type   exec,
+                             options         opts       = {},
+                             make_state_type make_state = default_state);
+
+        auto get_executor() -> executor_type { return exec_; }
+
+        /// Called with the new state each time a connection comes up,
+        /// before buffered frames are sent. Frames sent from the hook go
+        /// ahead of them
+        auto set_on_connected(std::function< void(state_type &) > hook)
+            -> void
+        {
+            on_connected_ = std::move(hook);
+        }
+
+        /// Run until close(), calling the frame handlers as frames arrive
+        /// on whichever connection is current. The handlers are as for
+        /// websocket_state_impl::operator(), and each connection is given
+        /// copies of them.
+        template < class OnTextFrame,
+                   class OnBinaryFrame =
+                       typename state_type::null_frame_handler >
+        auto operator()(OnTextFrame   on_text,
+                        OnBinaryFrame on_binary = OnBinaryFrame())
+            -> awaitable;
+
+        /// Set the endpoint and let operator() start connecting
+        /// @pre connect has not been called
+        auto connect(std::string host, std::string port, std::string target)
+            -> void;
+
+        /// Close the current connection, if any, and stop reconnecting.
+        /// operator() returns once the connection has closed. Buffered
+        /// frames are dropped
+        auto close(websocket::close_reason reason =
+                       websocket::close_code::going_away) -> void;
+
+        /// Send a text frame on the current connection, or hold it until
+        /// the next one is up.
+        /// @exception system_error is thrown with net::error::no_buffer_space
+        /// if the frame would take the buffer over its limits, or with
+        /// net::error::not_connected once closed
+        auto send_text(TextType      text,
+                       send_priority priority = send_priority::bulk) -> void;
+
+        /// As send_text, for a binary frame
+        auto send_binary(TextType      data,
+                         send_priority priority = send_priority::bulk) -> void;
+
+        /// True while there is a connection to send on
+        auto connected() const -> bool
+        {
+            return state_ and state_->connected();
+        }
+
+        /// The current connection's state, if any
+        auto state() -> state_type * { return state_.get(); }
+
+        /// The number of connections made, including the first
+        auto connects() const -> std::size_t { return connects_; }
+
+        auto buffered_frames() const -> std::size_t { return buffer_.size(); }
+
+        auto buffered_bytes() const -> std::size_t { return buffered_bytes_; }
+
+      private:
+        struct buffered_frame
+        {
+            TextType      payload;
+            bool          binary   = false;
+            send_priority priority = send_priority::bulk;
+        };
+
+        using timer_type = net::basic_waitable_timer<
+            std::chrono::steady_clock,
+            net::wait_traits< std::chrono::steady_clock >,
+            executor_type >;
+
+        static auto default_state(executor_type exec)
+            -> std::unique_ptr< state_type >
+        {
+            return std::make_unique< state_type >(exec);
+        }
+
+        auto send(buffered_frame frame) -> void;
+
+        // send the buffered frames on the connection just made
+        auto flush() -> void;
+
+        executor_type                            exec_;
+        options                                  options_;
+        make_state_type                          make_state_;
+        std::function< void(state_type &) >      on_connected_;
+        std::unique_ptr< state_type >            state_;
+        async_event< executor_type >             endpoint_set_;
+        timer_type                               retry_timer_;
+        backoff                                  backoff_;
+        std::string                              host_;
+        std::string                              port_;
+        std::string                              target_;
+        std::optional< websocket::close_reason > close_request_;
+        ring_buffer< buffered_frame >            buffer_;
+        std::size_t                              buffered_bytes_ = 0;
+        std::size_t                              connects_       = 0;
+    };
+
+}   // namespace notstd::util::async
+
+namespace notstd::util::async
+{
+    template < class NextLayer, class TextType >
+    supervised_websocket< NextLayer, TextType >::supervised_websocket(
+        executor_type   exec,
+        options         opts,
+        make_state_type make_state)
+    : exec_(exec)
+    , options_(opts)
+    , make_state_(std::move(make_state))
+    , endpoint_set_(exec)
+    , retry_timer_(exec)
+    , backoff_(opts.reconnect)
+    {
+    }
+
+    template < class NextLayer, class TextType >
+    template < class OnTextFrame, class OnBinaryFrame >
+    auto supervised_websocket< NextLayer, TextType >::operator()(
+        OnTextFrame   on_text,
+        OnBinaryFrame on_binary) -> awaitable
+    {
+        using clock_type         = std::chrono::steady_clock;
+        auto const use_awaitable = net::use_awaitable_t< executor_type >();
+
+        try
+        {
+            co_await endpoint_set_.async_wait(use_awaitable);
+        }
+        catch (system_error &)
+        {
+            // closed before connect was called
+        }
+
+        while (not close_request_)
+        {
+            state_ = make_state_(exec_);
+
+            // run the state alongside the connect, and wait for both, so
+            // that nothing refers to the state once it is destroyed
+            auto done = async_event< executor_type >(exec_);
+            net::co_spawn(
+                exec_,
+                [&]() -> net::awaitable< void, executor_type > {
+                    co_await(*state_)(on_text, on_binary);
+                },
+                [&](std::exception_ptr ep) {
+                    spdlog::trace("{} exit: {}", *state_, explain(ep));
+                    done.set_event();
+                });
+
+            auto up_since = std::optional< clock_type::time_point >();
+            try
+            {
+                co_await state_->connect(host_, port_, target_);
+                up_since = clock_type::now();
+                ++connects_;
+                if (on_connected_)
+                    on_connected_(*state_);
+                flush();
+            }
+            catch (...)
+            {
+                spdlog::trace("{} connect: {}", *state_, explain());
+            }
+
+            // a close which arrived before the state could act on it
+            if (close_request_)
+                state_->close(*close_request_);
+
+            co_await done.async_wait(use_awaitable);
+            state_.reset();
+
+            if (close_request_)
+                break;
+
+            // a connection which lasted is not part of a run of failures
+            if (up_since and clock_type::now() - *up_since >=
+                                 options_.reconnect.reset_after)
+                backoff_.reset();
+
+            auto const delay = backoff_.next();
+            spdlog::trace("[supervised_websocket] retry {} in {}us",
+                          backoff_.attempts(),
+                          delay / std::chrono::microseconds(1));
+            retry_timer_.expires_after(delay);
+            auto ec = error_code();
+            co_await retry_timer_.async_wait(
+                net::redirect_error(use_awaitable, ec));
+        }
+
+        buffer_.clear();
+        buffered_bytes_ = 0;
+    }
+
+    template < class NextLayer, class TextType >
+    auto supervised_websocket< NextLayer, TextType >::connect(
+        std::string host,
+        std::string port,
+        std::string target) -> void
+    {
+        host_   = std::move(host);
+        port_   = std::move(port);
+        target_ = std::move(target);
+        endpoint_set_.set_event();
+    }
+
+    template < class NextLayer, class TextType >
+    auto supervised_websocket< NextLayer, TextType >::close(
+        websocket::close_reason reason) -> void
+    {
+        if (close_request_)
+            return;
+        close_request_ = reason;
+        endpoint_set_.cancel();
+        retry_timer_.cancel();
+        if (state_)
+            state_->close(reason);
+    }
+
+    template < class NextLayer, class TextType >
+    auto supervised_websocket< NextLayer, TextType >::send_text(
+        TextType      text,
+        send_priority priority) -> void
+    {
+        send(buffered_frame { .payload  = std::move(text),
+                              .priority = priority });
+    }
+
+    template < class NextLayer, class TextType >
+    auto supervised_websocket< NextLayer, TextType >::send_binary(
+        TextType      data,
+        send_priority priority) -> void
+    {
+        send(buffered_frame { .payload  = std::move(data),
+                              .binary   = true,
+                              .priority = priority });
+    }
+
+    template < class NextLayer, class TextType >
+    auto supervised_websocket< NextLayer, TextType >::send(buffered_frame frame)
+        -> void
+    {
+        if (close_request_)
+            throw system_error(net::error::not_connected);
+
+        // keep order with frames still waiting for the connection
+        if (connected() and buffer_.empty())
+        {
+            if (frame.binary)
+                state_->send_binary(std::move(frame.payload), frame.priority);
+            else
+                state_->send_text(std::move(frame.payload), frame.priority);
+            return;
+        }
+
+        auto const bytes = frame.payload.size();
+        if (buffer_.size() >= options_.max_buffered_frames or
+            buffered_bytes_ + bytes > options_.max_buffered_bytes)
+            throw system_error(net::error::no_buffer_space);
+        buffer_.push_back(std::move(frame));
+        buffered_bytes_ += bytes;
+    }
+
+    template < class NextLayer, class TextType >
+    auto supervised_websocket< NextLayer, TextType >::flush() -> void
+    {
+        for (; not buffer_.empty() and connected(); buffer_.pop_front())
+        {
+            auto &frame = buffer_.front();
+            buffered_bytes_ -= frame.payload.size();
+            if (frame.binary)
+                state_->send_binary(std::move(frame.payload), frame.priority);
+            else
+                state_->send_text(std::move(frame.payload), frame.priority);
+        }
+    }
+
+}   // namespace notstd::util::async
@@ -1,6 +1,9 @@
 #pragma once
+#include <memory>
+#include <notstd/util/async/async_join_impl.hpp>
 #include <notstd/util/async/executor_traits.hpp>
 #include <notstd/util/net.hpp>
+#include <notstd/util/resolve_cache.hpp>
 #include <notstd/util/wise_enum.hpp>
 
 namespace notstd::util::async
@@ -29,6 +32,15 @@ namespace notstd::util::async
 
         auto cancel(error_code ec = net::error::operation_aborted) -> void;
 
+        /// Answer lookups from a cache shared with other resolvers, making
+        /// at most one lookup of a host at a time between them. Null, the
+        /// default, resolves every time
+        /// @pre no lookup is in progress
+        auto set_cache(std::shared_ptr< resolve_cache > cache) -> void
+        {
+            cache_ = std::move(cache);
+        }
+
         auto get_executor() -> executor_type
         {
             return resolver_.get_executor();
@@ -37,8 +49,27 @@ namespace notstd::util::async
         static auto ident() -> std::string_view { return "[tcp_resolve]"; }
 
       private:
+        // where a lookup waiting on another's is completed. Shared with the
+        // cache, which may complete it after the lookup is cancelled
+        struct waiter_slot
+        {
+            waiter_slot(executor_type const &exec)
+            : ready(exec)
+            {
+            }
+
+            async_event< executor_type > ready;
+            resolve_result               result;
+        };
+
+        // resolve without the cache
+        auto resolve(std::string_view host,
+                     std::string_view port,
+                     error_code &     my_error) -> awaitable_type;
+
         resolver_type                     resolver_;
         std::function< void(error_code) > on_cancel_;
+        std::shared_ptr< resolve_cache >  cache_;
     };
 
 }   // namespace notstd::util::async
@@ -58,7 +89,99 @@ namespace notstd::util::async
         -> awaitable_type
     try
     {
-        auto my_error    = error_code();
+        auto my_error = error_code();
+        if (not cache_)
+            co_return co_await resolve(host, port, my_error);
+
+        for (;;)
+        {
+            auto leader = false;
+            auto slot   = std::make_shared< waiter_slot >(get_executor());
+            auto waiter = [exec = get_executor(), slot](resolve_result r) {
+                net::post(exec, [slot, r = std::move(r)]() mutable {
+                    slot->result = std::move(r);
+                    slot->ready.set_event();
+                });
+            };
+            auto hit = cache_->find(host, port, std::move(waiter), leader);
+            if (hit)
+            {
+                spdlog::trace("{} cached: [host {}], [port {}]",
+                              ident(),
+                              host,
+                              port);
+                if (hit->error)
+                    throw system_error(hit->error);
+                co_return hit->results;
+            }
+
+            if (leader)
+            {
+                // whatever happens, even destruction of this frame while
+                // suspended, release those waiting on this lookup
+                auto guard  = resolve_cache::leader_guard(*cache_, host, port);
+                auto result = resolve_result { .error = {}, .results = {} };
+                try
+                {
+                    result.results = co_await resolve(host, port, my_error);
+                }
+                catch (system_error &e)
+                {
+                    result.error =
+                        my_error ? net::error::operation_aborted : e.code();
+                }
+                on_cancel_ = nullptr;
+                guard.complete(result);
+                if (my_error)
+                    throw system_error(my_error);
+                if (result.error)
+                    throw system_error(result.error);
+                co_return result.results;
+            }
+
+            spdlog::trace("{} waiting for lookup in flight: [host {}], "
+                          "[port {}]",
+                          ident(),
+                          host,
+                          port);
+            on_cancel_ = [&](error_code ec) {
+                assert(net::is_correct_thread(get_executor()));
+                spdlog::trace("{} cancel requested: {}", ident(), print(ec));
+                my_error = ec;
+                slot->ready.cancel(ec);
+            };
+            try
+            {
+                co_await slot->ready.async_wait(this->use_awaitable);
+            }
+            catch (system_error &)
+            {
+                // cancelled
+            }
+            on_cancel_ = nullptr;
+            if (my_error)
+                throw system_error(my_error);
+
+            // the leader was cancelled, so take over from it
+            if (slot->result.error == net::error::operation_aborted)
+                continue;
+            if (slot->result.error)
+                throw system_error(slot->result.error);
+            co_return slot->result.results;
+        }
+    }
+    catch (...)
+    {
+        on_cancel_ = nullptr;
+        throw;
+    }
+
+    template < class Executor >
+    auto tcp_resolve_state_impl< Executor >::resolve(std::string_view host,
+                                                     std::string_view port,
+                                                     error_code &     my_error)
+        -> awaitable_type
+    {
         this->on_cancel_ = [&](error_code ec) {
             assert(net::is_correct_thread(get_executor()));
             spdlog::trace("{} cancel requested: {}", ident(), print(ec));
@@ -74,10 +197,5 @@ namespace notstd::util::async
         on_cancel_ = nullptr;
         co_return results;
     }
-    catch (...)
-    {
-        on_cancel_ = nullptr;
-        throw;
-    }
 
 }   // namespace notstd::util::async
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include <fmt/ostream.h>
+#include <notstd/util/async/executor_traits.hpp>
+#include <notstd/util/explain.hpp>
+#include <notstd/util/net.hpp>
+
+namespace notstd::util::async
+{
+    /// The server side counterpart of basic_tcp_socket_connect_state_impl.
+    /// A socket handed over by an acceptor is already connected, so there is
+    /// nothing left to do
+    template < class Executor >
+    struct basic_tcp_socket_accept_state_impl : executor_traits< Executor >
+    {
+        using protocol_type = net::ip::tcp;
+        using socket_type = net::basic_stream_socket< protocol_type, Executor >;
+        using executor_type = Executor;
+
+        using awaitable =
+            typename executor_traits< Executor >::template awaitable< void >;
+
+        basic_tcp_socket_accept_state_impl(socket_type &sock)
+        : sock_(sock)
+        {
+        }
+
+        auto operator()() -> awaitable { co_return; }
+
+        auto cancel(error_code = net::error::operation_aborted) -> void {}
+
+        auto get_executor() -> executor_type { return sock_.get_executor(); }
+
+        friend auto operator<<(std::ostream &                            os,
+                               basic_tcp_socket_accept_state_impl const &state)
+            -> std::ostream &
+        {
+            fmt::print(os, "[tcp_accept {}]", print(state.sock_));
+            return os;
+        }
+
+      private:
+        socket_type &sock_;
+    };
+
+    template < class Executor >
+    auto make_accept_state_impl(
+        net::basic_stream_socket< net::ip::tcp, Executor > &sock)
+    {
+        return basic_tcp_socket_accept_state_impl< Executor >(sock);
+    }
+
+}   // namespace notstd::util::async
@@ -1,13 +1,25 @@
 #pragma once
+#include <chrono>
 #include <fmt/ostream.h>
+#include <list>
 #include <notstd/util/async/executor_traits.hpp>
 #include <notstd/util/async/lowest_layer.hpp>
 #include <notstd/util/async/tcp_resolve_state_impl.hpp>
-#include <notstd/util/net.hpp>
 #include <notstd/util/explain.hpp>
+#include <notstd/util/happy_eyeballs.hpp>
+#include <notstd/util/net.hpp>
+#include <vector>
 
 namespace notstd::util::async
 {
+    /// Resolves a host and connects a socket to it.
+    ///
+    /// The host's addresses are raced as described by RFC 8305: attempts
+    /// alternate between IPv6 and IPv4 and are started attempt_delay apart,
+    /// or as soon as the previous one fails, each on its own socket. The
+    /// first to connect is moved into the socket and the rest are
+    /// abandoned, so an unreachable address costs attempt_delay rather than
+    /// a full connect timeout.
     template < class Executor >
     struct basic_tcp_socket_connect_state_impl : executor_traits< Executor >
     {
@@ -15,7 +27,8 @@ namespace notstd::util::async
         using socket_type = net::basic_stream_socket< protocol_type, Executor >;
         using executor_type = Executor;
 
-        using result_type = net::ip::tcp::endpoint;
+        using endpoint_type = protocol_type::endpoint;
+        using result_type   = endpoint_type;
 
         using awaitable = typename executor_traits<
             Executor >::template awaitable< result_type >;
@@ -28,8 +41,28 @@ namespace notstd::util::async
         auto operator()(std::string const &host, std::string_view port)
             -> awaitable;
 
+        /// Connect to whichever of the endpoints answers first, trying them
+        /// in happy_eyeballs_order.
+        /// @exception system_error is thrown with the error of the last
+        /// attempt to fail if none connects
+        auto operator()(std::vector< endpoint_type > endpoints) -> awaitable;
+
         auto cancel(error_code = net::error::operation_aborted) -> void;
 
+        /// @pre the connect has not started
+        auto set_connect_options(happy_eyeballs_options opts) -> void
+        {
+            options_ = opts;
+        }
+
+        /// Resolve through a shared cache. A host none of whose addresses
+        /// connect is dropped from the cache
+        /// @pre the connect has not started
+        auto set_resolve_cache(std::shared_ptr< resolve_cache > cache) -> void
+        {
+            cache_ = std::move(cache);
+        }
+
         auto get_executor() -> executor_type { return sock_.get_executor(); }
 
         friend auto operator<<(std::ostream &                             os,
@@ -41,8 +74,33 @@ namespace notstd::util::async
         }
 
       private:
+        using timer_type = net::basic_waitable_timer<
+            std::chrono::steady_clock,
+            net::wait_traits< std::chrono::steady_clock >,
+            Executor >;
+
+        // one connection attempt of a race
+        struct attempt
+        {
+            attempt(executor_type exec, endpoint_type ep)
+            : sock(exec)
+            , timer(exec)
+            , ep(ep)
+            {
+            }
+
+            socket_type   sock;
+            timer_type    timer;
+            endpoint_type ep;
+            error_code    ec;
+            bool          finished  = false;
+            bool          timed_out = false;
+        };
+
         socket_type &                     sock_;
         std::function< void(error_code) > on_cancel_;
+        happy_eyeballs_options            options_;
+        std::shared_ptr< resolve_cache >  cache_;
     };
 
     template < class Executor >
@@ -77,6 +135,7 @@ namespace notstd::util::async
 
         auto resolve_state =
             tcp_resolve_state_impl< executor_type >(sock_.get_executor());
+        resolve_state.set_cache(cache_);
         on_cancel_ = [&](error_code ec) {
             spdlog::trace("{} cancel request: {}", *this, ec);
             my_error = ec;
@@ -89,16 +148,20 @@ namespace notstd::util::async
         // connect the socket
         //
 
-        on_cancel_ = [&](error_code ec) {
-            my_error = ec;
-            sock_.cancel();
-        };
-        auto ep =
-            co_await net::async_connect(sock_, endpoints, this->use_awaitable);
-        error_check();
-        spdlog::trace("{} connected: {}", *this, ep);
-
-        co_return ep;
+        auto candidates = std::vector< endpoint_type >();
+        for (auto &entry : endpoints)
+            candidates.push_back(entry.endpoint());
+        try
+        {
+            co_return co_await(*this)(std::move(candidates));
+        }
+        catch (system_error &e)
+        {
+            // the host may have moved
+            if (cache_ and e.code() != net::error::operation_aborted)
+                cache_->invalidate(host, port);
+            throw;
+        }
     }
     catch (...)
     {
@@ -107,6 +170,139 @@ namespace notstd::util::async
         throw;
     }
 
+    template < class Executor >
+    auto basic_tcp_socket_connect_state_impl< Executor >::operator()(
+        std::vector< endpoint_type > endpoints) -> awaitable
+    {
+        assert(get_executor() == co_await net::this_coro::executor);
+
+        using clock_type         = std::chrono::steady_clock;
+        auto const use_awaitable = this->use_awaitable;
+
+        auto const order = happy_eyeballs_order(std::move(endpoints));
+        if (order.empty())
+            throw system_error(net::error::host_not_found);
+
+        // every handler below refers to this frame, so the race does not
+        // end until they have all run
+        auto attempts   = std::list< attempt >();
+        auto wake       = timer_type(get_executor());
+        auto pending    = std::size_t(0);
+        auto my_error   = error_code();
+        auto last_error = error_code();
+
+        auto start = [&](endpoint_type const &ep) {
+            auto &a = attempts.emplace_back(get_executor(), ep);
+            spdlog::trace("{} attempt: {}", *this, ep);
+            ++pending;
+            a.sock.async_connect(ep, [&](error_code ec) {
+                --pending;
+                a.finished = true;
+                a.ec       = a.timed_out ? net::error::timed_out : ec;
+                if (a.ec)
+                    last_error = a.ec;
+                a.timer.cancel();
+                wake.cancel();
+            });
+            if (options_.attempt_timeout.count() > 0)
+            {
+                ++pending;
+                a.timer.expires_after(options_.attempt_timeout);
+                a.timer.async_wait([&](error_code ec) {
+                    --pending;
+                    if (not ec and not a.finished)
+                    {
+                        a.timed_out = true;
+                        a.sock.cancel();
+                    }
+                    wake.cancel();
+                });
+            }
+        };
+
+        auto abandon = [&](attempt *keep) {
+            for (auto &a : attempts)
+            {
+                auto ec = error_code();
+                a.timer.cancel();
+                if (&a != keep)
+                    a.sock.close(ec);
+            }
+        };
+
+        on_cancel_ = [&](error_code ec) {
+            spdlog::trace("{} cancel request: {}", *this, ec);
+            my_error = ec;
+            wake.cancel();
+        };
+
+        auto     next       = order.begin();
+        auto     last_start = clock_type::now();
+        auto     seen_fails = std::size_t(0);
+        attempt *winner     = nullptr;
+        start(*next++);
+
+        while (not my_error)
+        {
+            auto running = std::size_t(0);
+            auto fails   = std::size_t(0);
+            for (auto &a : attempts)
+            {
+                if (not a.finished)
+                    ++running;
+                else if (a.ec)
+                    ++fails;
+                else if (not winner)
+                    winner = &a;
+            }
+            if (winner)
+                break;
+
+            // a failure, or the delay running out, starts the next attempt
+            auto const now = clock_type::now();
+            if (next != order.end() and
+                (fails > seen_fails or running == 0 or
+                 now - last_start >= options_.attempt_delay))
+            {
+                seen_fails = fails;
+                last_start = now;
+                start(*next++);
+                continue;
+            }
+            seen_fails = fails;
+            if (running == 0)
+                break;
+
+            if (next == order.end())
+                wake.expires_at(clock_type::time_point::max());
+            else
+                wake.expires_at(last_start + options_.attempt_delay);
+            auto ec = error_code();
+            co_await wake.async_wait(net::redirect_error(use_awaitable, ec));
+        }
+
+        on_cancel_ = nullptr;
+        abandon(winner);
+        while (pending)
+        {
+            wake.expires_at(clock_type::time_point::max());
+            auto ec = error_code();
+            co_await wake.async_wait(net::redirect_error(use_awaitable, ec));
+        }
+
+        if (my_error)
+            throw system_error(my_error);
+        if (not winner)
+        {
+            spdlog::debug("{} all attempts failed: {}", *this, last_error);
+            throw system_error(last_error);
+        }
+
+        sock_ = std::move(winner->sock);
+        spdlog::trace("{} connected: {}", *this, winner->ep);
+        co_return winner->ep;
+    }
+
     template < class Executor >
     auto basic_tcp_socket_connect_state_impl< Executor >::cancel(error_code ec)
         -> void
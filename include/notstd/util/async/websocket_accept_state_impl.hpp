@@ -0,0 +1,140 @@
+#pragma once
+#include <notstd/util/async/executor_traits.hpp>
+#include <notstd/util/async/lowest_layer.hpp>
+#include <notstd/util/async/ssl_stream_accept_state_impl.hpp>
+#include <notstd/util/net.hpp>
+#include <notstd/util/websocket.hpp>
+#include <notstd/util/websocket_compression.hpp>
+#include <notstd/util/write_coalescing_stream.hpp>
+
+namespace notstd::util::async
+{
+    /// The server side counterpart of basic_websocket_connect_state_impl.
+    /// Accepts the next layer, then reads the client's upgrade request and
+    /// answers it
+    template < class NextLayer >
+    struct basic_websocket_accept_state_impl
+    : executor_traits< typename NextLayer::executor_type >
+    {
+        using traits_type =
+            executor_traits< typename NextLayer::executor_type >;
+
+        using websock_type = websocket::stream< NextLayer >;
+
+        using executor_type = typename traits_type::executor_type;
+
+        using awaitable = typename traits_type::template awaitable< void >;
+
+        basic_websocket_accept_state_impl(websock_type &websock)
+        : websock_(websock)
+        {
+        }
+
+        auto operator()() -> awaitable;
+
+        auto cancel(error_code = net::error::operation_aborted) -> void;
+
+        /// The permessage-deflate settings accepted in the handshake
+        /// @pre the accept has not started
+        auto set_compression_options(compression_options opts) -> void
+        {
+            compression_ = opts;
+        }
+
+        auto get_executor() -> executor_type { return websock_.get_executor(); }
+
+        friend auto operator<<(std::ostream &                           os,
+                               basic_websocket_accept_state_impl const &state)
+            -> std::ostream &
+        {
+            fmt::print(os, "[websocket_accept {}]", print(state.websock_));
+            return os;
+        }
+
+      private:
+        websock_type &                    websock_;
+        std::function< void(error_code) > on_cancel_;
+        compression_options               compression_;
+    };
+
+    template < class NextLayer >
+    auto make_accept_state_impl(websocket::stream< NextLayer > &websock)
+    {
+        return basic_websocket_accept_state_impl< NextLayer >(websock);
+    }
+
+}   // namespace notstd::util::async
+
+namespace notstd::util
+{
+    /// Accepting the coalescing layer is accepting the layer beneath it
+    template < class NextLayer >
+    auto make_accept_state_impl(write_coalescing_stream< NextLayer > &stream)
+    {
+        return async::make_accept_state_impl(stream.next_layer());
+    }
+}   // namespace notstd::util
+
+namespace notstd::util::async
+{
+    template < class NextLayer >
+    auto basic_websocket_accept_state_impl< NextLayer >::operator()()
+        -> awaitable
+    try
+    {
+#if !defined(NDEBUG)
+        auto my_executor = co_await net::this_coro::executor;
+        assert(get_executor() == my_executor);
+#endif
+
+        auto my_error    = error_code();
+        auto error_check = [&] {
+            on_cancel_ = nullptr;
+            if (my_error)
+                throw system_error(my_error);
+        };
+
+        //
+        // accept the next layer
+        //
+
+        auto next_layer_accept = make_accept_state_impl(websock_.next_layer());
+        on_cancel_             = [&](error_code ec) {
+            spdlog::trace("{} cancel signal: {}", *this, ec);
+            my_error = ec;
+            next_layer_accept.cancel(ec);
+        };
+        co_await next_layer_accept();
+        error_check();
+
+        //
+        // perform handshake
+        //
+
+        on_cancel_ = [&](error_code ec) {
+            my_error = ec;
+            get_lowest_layer(websock_).cancel();
+            spdlog::trace("{} cancel signal: {}", *this, ec);
+        };
+
+        websock_.set_option(to_permessage_deflate(compression_));
+        co_await websock_.async_accept(this->use_awaitable);
+        error_check();
+
+        spdlog::trace("{} websocket up", *this);
+    }
+    catch (...)
+    {
+        on_cancel_ = nullptr;
+        spdlog::trace("{} exception: {}", *this, explain());
+        throw;
+    }
+
+    template < class NextLayer >
+    auto basic_websocket_accept_state_impl< NextLayer >::cancel(error_code ec)
+        -> void
+    {
+        if (on_cancel_)
+            on_cancel_(ec);
+    }
+}   // namespace notstd::util::async
@@ -0,0 +1,413 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <notstd/util/async/async_join_impl.hpp>
+#include <notstd/util/async/websocket_state_impl.hpp>
+#include <notstd/util/backoff.hpp>
+#include <notstd/util/io_context_pool.hpp>
+#include <vector>
+
+namespace notstd::util::async
+{
+#if defined(SO_REUSEPORT)
+    /// Lets several sockets listen on one port, the kernel spreading new
+    /// connections between them
+    using reuse_port = net::detail::socket_option::boolean< SOL_SOCKET,
+                                                            SO_REUSEPORT >;
+#endif
+
+    /// Accepts websocket clients on an endpoint, running each connection as
+    /// a websocket_state_impl.
+    ///
+    /// One listener per thread of an io_context_pool is bound to the
+    /// endpoint with SO_REUSEPORT, so that the kernel spreads connections
+    /// across the threads. Where SO_REUSEPORT is not available there is a
+    /// single listener. A connection stays on the thread of the listener
+    /// which accepted it.
+    ///
+    /// Each wakeup of a listener accepts up to max_accept_batch pending
+    /// connections. Every connection completes its TLS and websocket
+    /// handshakes in its own coroutine, so a slow client does not hold up
+    /// the others.
+    template < class NextLayer, class TextType = std::string >
+    class websocket_acceptor
+    {
+      public:
+        using state_type    = websocket_state_impl< NextLayer, TextType >;
+        using executor_type = typename state_type::executor_type;
+        using protocol_type = net::ip::tcp;
+        using socket_type =
+            net::basic_stream_socket< protocol_type, executor_type >;
+        using endpoint_type = protocol_type::endpoint;
+
+        /// Constructs the state of each accepted connection from its socket,
+        /// for instance to wrap it in an SSL stream or apply options
+        using make_state_type =
+            std::function< std::unique_ptr< state_type >(socket_type) >;
+
+        struct options
+        {
+            /// The number of listeners. Zero for one per pool thread
+            std::size_t listeners = 0;
+
+            /// The most connections accepted per wakeup of a listener
+            std::size_t max_accept_batch = 64;
+
+            /// The length of each listener's queue of pending connections
+            int backlog = net::socket_base::max_listen_connections;
+
+            /// How long a listener waits before accepting again after an
+            /// accept fails, e.g. for want of file descriptors
+            backoff_policy accept_retry = {
+                .initial = std::chrono::milliseconds(10),
+                .max     = std::chrono::seconds(1),
+            };
+        };
+
+        /// Bind and listen. Connections queue until start() is called
+        /// @param threads the threads to accept and run connections on.
+        /// Must outlive this acceptor
+        /// @param endpoint the address to listen on. If its port is zero, the
+        /// port chosen for the first listener is shared by the rest
+        /// @param opts
+        /// @param make_state
+        /// @exception system_error is thrown if the endpoint can not be bound
+        websocket_acceptor(io_context_pool &threads,
+                           endpoint_type    endpoint,
+                           options          opts,
+                           make_state_type  make_state = default_state);
+
+        websocket_acceptor(websocket_acceptor const &) = delete;
+        websocket_acceptor &operator=(websocket_acceptor const &) = delete;
+
+        /// Stops listening, closes every connection and waits for them to end
+        /// @pre not called from one of the pool's threads
+        ~websocket_acceptor();
+
+        /// Start accepting connections.
+        ///
+        /// For each connection, session is called with its state and must
+        /// return an awaitable which runs the state, for example by
+        /// co_await state(on_text). The connection's handshakes start once the
+        /// state is running. Each session holds its own copy of session,
+        /// called on the thread of the listener which accepted it.
+        /// @pre start has not been called
+        template < class Session >
+        auto start(Session session) -> void;
+
+        /// Stop accepting and close every connection. Returns without
+        /// waiting for the connections to end
+        auto stop(websocket::close_reason reason =
+                      websocket::close_code::going_away) -> void;
+
+        auto local_endpoint() const -> endpoint_type
+        {
+            return listeners_.front()->acceptor.local_endpoint();
+        }
+
+        /// The number of connections accepted so far
+        auto accepted() const -> std::size_t;
+
+        /// The number of connections whose websocket is up
+        auto established() const -> std::size_t;
+
+      private:
+        using acceptor_type =
+            net::basic_socket_acceptor< protocol_type, executor_type >;
+        using session_list = std::list< state_type * >;
+        using timer_type   = net::basic_waitable_timer<
+            std::chrono::steady_clock,
+            net::wait_traits< std::chrono::steady_clock >,
+            executor_type >;
+
+        struct listener
+        {
+            listener(executor_type exec)
+            : exec(exec)
+            , acceptor(exec)
+            , retry_timer(exec)
+            {
+            }
+
+            executor_type exec;
+
+            // accessed only on exec
+            acceptor_type acceptor;
+            timer_type    retry_timer;
+            session_list  sessions;
+            bool          listening = false;
+            bool          stopped   = false;
+
+            // accessed from any thread
+            std::atomic< std::size_t > accepted { 0 };
+            std::atomic< std::size_t > established { 0 };
+            std::promise< void >       done;
+        };
+
+        static auto default_state(socket_type sock)
+            -> std::unique_ptr< state_type >
+        {
+            return std::make_unique< state_type >(std::move(sock));
+        }
+
+        // accept connections until the listener is closed
+        template < class Session >
+        auto listen(listener &l, Session session)
+            -> net::awaitable< void, executor_type >;
+
+        // register a connection with its listener, then serve it. The
+        // connection is counted before its coroutine is spawned, so that
+        // the listener is not reported done while the spawn is pending
+        template < class Session >
+        auto start_session(listener &l, socket_type sock, Session &session)
+            -> void;
+
+        // handshake and run one registered connection
+        template < class Session >
+        auto serve(listener &                    l,
+                   std::unique_ptr< state_type > state,
+                   session_list::iterator        entry,
+                   Session                       session)
+            -> net::awaitable< void, executor_type >;
+
+        // signal the destructor once the listener has nothing left running,
+        // neither its accept loop nor any registered connection
+        auto check_done(listener &l) -> void;
+
+        options                                    options_;
+        make_state_type                            make_state_;
+        std::vector< std::unique_ptr< listener > > listeners_;
+        std::atomic< bool >                        stopping_ { false };
+        bool                                       started_ = false;
+    };
+
+}   // namespace notstd::util::async
+
+namespace notstd::util::async
+{
+    template < class NextLayer, class TextType >
+    websocket_acceptor< NextLayer, TextType >::websocket_acceptor(
+        io_context_pool &threads,
+        endpoint_type    endpoint,
+        options          opts,
+        make_state_type  make_state)
+    : options_(opts)
+    , make_state_(std::move(make_state))
+    {
+#if defined(SO_REUSEPORT)
+        auto const n = opts.listeners ? opts.listeners : threads.size();
+#else
+        auto const n = std::size_t(1);
+#endif
+        listeners_.reserve(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            auto &l = *listeners_.emplace_back(
+                std::make_unique< listener >(threads.get_executor(i)));
+            l.acceptor.open(endpoint.protocol());
+            l.acceptor.set_option(net::socket_base::reuse_address(true));
+#if defined(SO_REUSEPORT)
+            if (n > 1)
+                l.acceptor.set_option(reuse_port(true));
+#endif
+            l.acceptor.bind(i == 0 ? endpoint : local_endpoint());
+            l.acceptor.listen(opts.backlog);
+            l.acceptor.non_blocking(true);
+        }
+    }
+
+    template < class NextLayer, class TextType >
+    websocket_acceptor< NextLayer, TextType >::~websocket_acceptor()
+    {
+        stop();
+        if (started_)
+            for (auto &l : listeners_)
+                l->done.get_future().wait();
+    }
+
+    template < class NextLayer, class TextType >
+    template < class Session >
+    auto websocket_acceptor< NextLayer, TextType >::start(Session session)
+        -> void
+    {
+        assert(not started_);
+        started_ = true;
+        for (auto &l : listeners_)
+        {
+            l->listening = true;
+            net::co_spawn(l->exec,
+                          listen(*l, session),
+                          [this, &l = *l](std::exception_ptr ep) {
+                              spdlog::trace("[websocket_acceptor] listen "
+                                            "exit: {}",
+                                            explain(ep));
+                              l.listening = false;
+                              check_done(l);
+                          });
+        }
+    }
+
+    template < class NextLayer, class TextType >
+    auto websocket_acceptor< NextLayer, TextType >::stop(
+        websocket::close_reason reason) -> void
+    {
+        if (not started_ or stopping_.exchange(true))
+            return;
+        for (auto &l : listeners_)
+            net::post(l->exec, [&l = *l, reason] {
+                auto ec = error_code();
+                l.acceptor.close(ec);
+                l.retry_timer.cancel();
+                for (auto *state : l.sessions)
+                    state->close(reason);
+            });
+    }
+
+    template < class NextLayer, class TextType >
+    template < class Session >
+    auto websocket_acceptor< NextLayer, TextType >::listen(listener &l,
+                                                           Session   session)
+        -> net::awaitable< void, executor_type >
+    {
+        auto const use_awaitable = net::use_awaitable_t< executor_type >();
+        auto       retry         = backoff(options_.accept_retry);
+        while (not stopping_)
+        {
+            auto ec   = error_code();
+            auto sock = co_await l.acceptor.async_accept(
+                net::redirect_error(use_awaitable, ec));
+            if (not l.acceptor.is_open())
+                break;
+            if (ec)
+            {
+                // e.g. out of file descriptors. Carry on with those
+                // connections which are already up, and give them time to
+                // free some before trying again
+                spdlog::warn("[websocket_acceptor] accept: {}", print(ec));
+                l.retry_timer.expires_after(retry.next());
+                co_await l.retry_timer.async_wait(
+                    net::redirect_error(use_awaitable, ec));
+                continue;
+            }
+            retry.reset();
+            start_session(l, std::move(sock), session);
+
+            // take whatever else is already pending without waiting again
+            for (std::size_t i = 1; i < options_.max_accept_batch; ++i)
+            {
+                auto ec   = error_code();
+                auto more = l.acceptor.accept(ec);
+                if (ec)
+                    break;
+                start_session(l, std::move(more), session);
+            }
+        }
+    }
+
+    template < class NextLayer, class TextType >
+    template < class Session >
+    auto websocket_acceptor< NextLayer, TextType >::start_session(
+        listener &  l,
+        socket_type sock,
+        Session &   session) -> void
+    {
+        ++l.accepted;
+        auto state = std::unique_ptr< state_type >();
+        try
+        {
+            state = make_state_(std::move(sock));
+        }
+        catch (...)
+        {
+            spdlog::warn("[websocket_acceptor] make state: {}", explain());
+            return;
+        }
+        auto entry = l.sessions.insert(l.sessions.end(), state.get());
+        net::co_spawn(l.exec,
+                      serve(l, std::move(state), entry, session),
+                      net::detached);
+    }
+
+    template < class NextLayer, class TextType >
+    template < class Session >
+    auto websocket_acceptor< NextLayer, TextType >::serve(
+        listener &                    l,
+        std::unique_ptr< state_type > state,
+        session_list::iterator        entry,
+        Session                       session)
+        -> net::awaitable< void, executor_type >
+    {
+
+        // run the session alongside the accept, and wait for both, so that
+        // nothing refers to the state once it is destroyed
+        auto done = async_event< executor_type >(l.exec);
+        net::co_spawn(
+            l.exec,
+            [&]() -> net::awaitable< void, executor_type > {
+                co_await session(*state);
+            },
+            [&](std::exception_ptr ep) {
+                spdlog::trace("{} session exit: {}", *state, explain(ep));
+                done.set_event();
+            });
+
+        auto up = false;
+        try
+        {
+            co_await state->accept();
+            up = true;
+            ++l.established;
+        }
+        catch (...)
+        {
+            spdlog::trace("{} accept: {}", *state, explain());
+        }
+
+        // a stop which arrived before the state could act on it
+        if (stopping_)
+            state->close();
+
+        co_await done.async_wait(net::use_awaitable_t< executor_type >());
+        if (up)
+            --l.established;
+        l.sessions.erase(entry);
+        state.reset();
+        check_done(l);
+    }
+
+    template < class NextLayer, class TextType >
+    auto websocket_acceptor< NextLayer, TextType >::check_done(listener &l)
+        -> void
+    {
+        if (stopping_ and not l.listening and l.sessions.empty() and
+            not l.stopped)
+        {
+            l.stopped = true;
+            l.done.set_value();
+        }
+    }
+
+    template < class NextLayer, class TextType >
+    auto websocket_acceptor< NextLayer, TextType >::accepted() const
+        -> std::size_t
+    {
+        auto n = std::size_t(0);
+        for (auto &l : listeners_)
+            n += l->accepted.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    template < class NextLayer, class TextType >
+    auto websocket_acceptor< NextLayer, TextType >::established() const
+        -> std::size_t
+    {
+        auto n = std::size_t(0);
+        for (auto &l : listeners_)
+            n += l->established.load(std::memory_order_relaxed);
+        return n;
+    }
+
+}   // namespace notstd::util::async
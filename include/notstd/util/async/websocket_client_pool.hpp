@@ -0,0 +1,391 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <notstd/util/async/async_join_impl.hpp>
+#include <notstd/util/async/websocket_state_impl.hpp>
+#include <notstd/util/backoff.hpp>
+#include <notstd/util/io_context_pool.hpp>
+#include <optional>
+#include <vector>
+
+namespace notstd::util::async
+{
+    /// A fixed number of websocket connections to the same endpoint, spread
+    /// across the threads of an io_context_pool.
+    ///
+    /// Each member connection is a websocket_state_impl running on one
+    /// thread. A member whose connection fails is rebuilt and reconnected
+    /// after a backoff delay, independently of the others. Frames may be
+    /// sent from any thread, either to the member with the fewest bytes
+    /// outstanding or to the member chosen by a key, which keeps frames with
+    /// equal keys in order.
+    template < class NextLayer, class TextType = std::string >
+    class websocket_client_pool
+    {
+      public:
+        using state_type    = websocket_state_impl< NextLayer, TextType >;
+        using executor_type = typename state_type::executor_type;
+
+        /// Constructs the state of each new connection, for instance to
+        /// pass an SSL context or apply options
+        using make_state_type =
+            std::function< std::unique_ptr< state_type >(executor_type) >;
+
+        struct options
+        {
+            /// The number of connections. Zero for one per pool thread
+            std::size_t connections = 0;
+
+            /// How long a member waits before reconnecting. Each member
+            /// backs off independently, so that members which failed
+            /// together reconnect at different times
+            backoff_policy reconnect;
+        };
+
+        /// @param threads the threads to run the connections on. Member i
+        /// runs on threads.get_executor(i). Must outlive this pool
+        /// @param opts
+        /// @param make_state
+        websocket_client_pool(io_context_pool &threads,
+                              options          opts,
+                              make_state_type  make_state = default_state);
+
+        websocket_client_pool(websocket_client_pool const &) = delete;
+        websocket_client_pool &
+        operator=(websocket_client_pool const &) = delete;
+
+        /// Closes every connection and waits for the members to stop, and
+        /// for any send already posted to them to run
+        /// @pre not called from one of the pool's threads
+        ~websocket_client_pool();
+
+        /// Connect every member and keep it connected until stop().
+        ///
+        /// Each member holds its own copy of the frame handlers, which are
+        /// called on that member's thread. Different members may therefore
+        /// call their copies concurrently.
+        /// @pre start has not been called
+        template < class OnTextFrame,
+                   class OnBinaryFrame =
+                       typename state_type::null_frame_handler >
+        auto start(std::string   host,
+                   std::string   port,
+                   std::string   target,
+                   OnTextFrame   on_text,
+                   OnBinaryFrame on_binary = OnBinaryFrame()) -> void;
+
+        /// Close every connection and stop reconnecting. Returns without
+        /// waiting for the members to stop
+        auto stop(websocket::close_reason reason =
+                      websocket::close_code::going_away) -> void;
+
+        auto size() const -> std::size_t { return members_.size(); }
+
+        /// The number of members currently connected
+        auto connected() const -> std::size_t;
+
+        /// The bytes handed to member i and not yet written or dropped
+        auto outstanding_bytes(std::size_t i) const -> std::size_t
+        {
+            return members_[i]->outstanding.load(std::memory_order_relaxed);
+        }
+
+        /// Send a text frame on the connected member with the fewest
+        /// outstanding bytes. As for websocket_state_impl::send_text, no
+        /// indication is fed back as to whether the frame was sent.
+        /// @exception system_error is thrown if no member is connected
+        auto send_text(TextType      text,
+                       send_priority priority = send_priority::bulk) -> void;
+
+        /// As send_text, for a binary frame
+        auto send_binary(TextType      data,
+                         send_priority priority = send_priority::bulk) -> void;
+
+        /// Send a text frame on the member chosen by hashing key, whether or
+        /// not it is connected. Frames with equal keys are sent in order,
+        /// unless that member's connection fails in between
+        /// @exception system_error is thrown once stop() has been called
+        template < class Key, class Hash = std::hash< Key > >
+        auto send_text_by_key(Key const &   key,
+                              TextType      text,
+                              send_priority priority = send_priority::bulk)
+            -> void;
+
+      private:
+        using timer_type = net::basic_waitable_timer<
+            std::chrono::steady_clock,
+            net::wait_traits< std::chrono::steady_clock >,
+            executor_type >;
+
+        struct member
+        {
+            member(executor_type exec, backoff_policy policy)
+            : exec(exec)
+            , reconnect_timer(exec)
+            , reconnect_backoff(policy)
+            {
+            }
+
+            executor_type exec;
+
+            // accessed only on exec
+            std::unique_ptr< state_type > state;
+            timer_type                    reconnect_timer;
+            backoff                       reconnect_backoff;
+
+            // accessed from any thread
+            std::atomic< bool >        up { false };
+            std::atomic< std::size_t > outstanding { 0 };
+            std::promise< void >       stopped;
+        };
+
+        static auto default_state(executor_type exec)
+            -> std::unique_ptr< state_type >
+        {
+            return std::make_unique< state_type >(exec);
+        }
+
+        // connect, run and reconnect one member until stopped
+        template < class OnTextFrame, class OnBinaryFrame >
+        auto run(member &m, OnTextFrame on_text, OnBinaryFrame on_binary)
+            -> net::awaitable< void, executor_type >;
+
+        auto least_loaded() -> member &;
+
+        auto send(member &m, TextType payload, bool binary, send_priority p)
+            -> void;
+
+        options                                  options_;
+        make_state_type                          make_state_;
+        std::string                              host_;
+        std::string                              port_;
+        std::string                              target_;
+        std::vector< std::unique_ptr< member > > members_;
+        std::atomic< bool >                      stopping_ { false };
+        bool                                     started_ = false;
+    };
+
+}   // namespace notstd::util::async
+
+namespace notstd::util::async
+{
+    template < class NextLayer, class TextType >
+    websocket_client_pool< NextLayer, TextType >::websocket_client_pool(
+        io_context_pool &threads,
+        options          opts,
+        make_state_type  make_state)
+    : options_(opts)
+    , make_state_(std::move(make_state))
+    {
+        auto const n = opts.connections ? opts.connections : threads.size();
+        members_.reserve(n);
+        for (std::size_t i = 0; i < n; ++i)
+            members_.push_back(
+                std::make_unique< member >(threads.get_executor(i),
+                                           opts.reconnect));
+    }
+
+    template < class NextLayer, class TextType >
+    websocket_client_pool< NextLayer, TextType >::~websocket_client_pool()
+    {
+        stop();
+        if (started_)
+            for (auto &m : members_)
+                m->stopped.get_future().wait();
+
+        // a send posted before stopping may still be queued, and refers to
+        // its member
+        for (auto &m : members_)
+        {
+            auto barrier = std::promise< void >();
+            net::post(m->exec, [&barrier] { barrier.set_value(); });
+            barrier.get_future().wait();
+        }
+    }
+
+    template < class NextLayer, class TextType >
+    template < class OnTextFrame, class OnBinaryFrame >
+    auto websocket_client_pool< NextLayer, TextType >::start(
+        std::string   host,
+        std::string   port,
+        std::string   target,
+        OnTextFrame   on_text,
+        OnBinaryFrame on_binary) -> void
+    {
+        assert(not started_);
+        started_ = true;
+        host_    = std::move(host);
+        port_    = std::move(port);
+        target_  = std::move(target);
+        for (auto &m : members_)
+            net::co_spawn(m->exec,
+                          run(*m, on_text, on_binary),
+                          [&m = *m](std::exception_ptr) {
+                              m.stopped.set_value();
+                          });
+    }
+
+    template < class NextLayer, class TextType >
+    auto websocket_client_pool< NextLayer, TextType >::stop(
+        websocket::close_reason reason) -> void
+    {
+        if (not started_ or stopping_.exchange(true))
+            return;
+        for (auto &m : members_)
+            net::post(m->exec, [&m = *m, reason] {
+                m.reconnect_timer.cancel();
+                if (m.state)
+                    m.state->close(reason);
+            });
+    }
+
+    template < class NextLayer, class TextType >
+    template < class OnTextFrame, class OnBinaryFrame >
+    auto websocket_client_pool< NextLayer, TextType >::run(
+        member &      m,
+        OnTextFrame   on_text,
+        OnBinaryFrame on_binary) -> net::awaitable< void, executor_type >
+    {
+        using clock_type         = std::chrono::steady_clock;
+        auto const use_awaitable = net::use_awaitable_t< executor_type >();
+
+        while (not stopping_)
+        {
+            m.state = make_state_(m.exec);
+
+            // run the state alongside the connect, and wait for both, so
+            // that nothing refers to the state once it is destroyed
+            auto done = async_event< executor_type >(m.exec);
+            net::co_spawn(
+                m.exec,
+                [&]() -> net::awaitable< void, executor_type > {
+                    co_await(*m.state)(on_text, on_binary);
+                },
+                [&](std::exception_ptr ep) {
+                    spdlog::trace("{} exit: {}", *m.state, explain(ep));
+                    done.set_event();
+                });
+
+            auto up_since = std::optional< clock_type::time_point >();
+            try
+            {
+                co_await m.state->connect(host_, port_, target_);
+                up_since = clock_type::now();
+                m.up     = true;
+            }
+            catch (...)
+            {
+                spdlog::trace("{} connect: {}", *m.state, explain());
+            }
+
+            // a stop which arrived before the state could act on it
+            if (stopping_)
+                m.state->close();
+
+            co_await done.async_wait(use_awaitable);
+            m.up = false;
+            m.state.reset();
+
+            if (stopping_)
+                break;
+
+            // a connection which lasted is not part of a run of failures
+            if (up_since and clock_type::now() - *up_since >=
+                                 options_.reconnect.reset_after)
+                m.reconnect_backoff.reset();
+            m.reconnect_timer.expires_after(m.reconnect_backoff.next());
+            auto ec = error_code();
+            co_await m.reconnect_timer.async_wait(
+                net::redirect_error(use_awaitable, ec));
+        }
+    }
+
+    template < class NextLayer, class TextType >
+    auto websocket_client_pool< NextLayer, TextType >::connected() const
+        -> std::size_t
+    {
+        return std::count_if(members_.begin(),
+                             members_.end(),
+                             [](auto const &m) { return m->up.load(); });
+    }
+
+    template < class NextLayer, class TextType >
+    auto websocket_client_pool< NextLayer, TextType >::least_loaded()
+        -> member &
+    {
+        member *best  = nullptr;
+        auto    least = std::size_t(0);
+        for (auto &m : members_)
+        {
+            if (not m->up.load(std::memory_order_relaxed))
+                continue;
+            auto const n = m->outstanding.load(std::memory_order_relaxed);
+            if (not best or n < least)
+            {
+                best  = m.get();
+                least = n;
+            }
+        }
+        if (not best)
+            throw system_error(net::error::not_connected);
+        return *best;
+    }
+
+    template < class NextLayer, class TextType >
+    auto websocket_client_pool< NextLayer, TextType >::send_text(
+        TextType      text,
+        send_priority priority) -> void
+    {
+        send(least_loaded(), std::move(text), false, priority);
+    }
+
+    template < class NextLayer, class TextType >
+    auto websocket_client_pool< NextLayer, TextType >::send_binary(
+        TextType      data,
+        send_priority priority) -> void
+    {
+        send(least_loaded(), std::move(data), true, priority);
+    }
+
+    template < class NextLayer, class TextType >
+    template < class Key, class Hash >
+    auto websocket_client_pool< NextLayer, TextType >::send_text_by_key(
+        Key const &   key,
+        TextType      text,
+        send_priority priority) -> void
+    {
+        auto &m = *members_[Hash()(key) % members_.size()];
+        send(m, std::move(text), false, priority);
+    }
+
+    template < class NextLayer, class TextType >
+    auto websocket_client_pool< NextLayer, TextType >::send(
+        member &      m,
+        TextType      payload,
+        bool          binary,
+        send_priority p) -> void
+    {
+        if (stopping_)
+            throw system_error(net::error::not_connected);
+
+        auto const n = payload.size();
+        m.outstanding.fetch_add(n, std::memory_order_relaxed);
+        auto op = [&m, n, binary, p, payload = std::move(payload)]() mutable {
+            auto release = [&m, n](error_code) {
+                m.outstanding.fetch_sub(n, std::memory_order_relaxed);
+            };
+            if (not m.state)
+                release(net::error::not_connected);
+            else if (binary)
+                m.state->async_send_binary(std::move(payload), p, release);
+            else
+                m.state->async_send_text(std::move(payload), p, release);
+        };
+        net::post(m.exec, std::move(op));
+    }
+
+}   // namespace notstd::util::async
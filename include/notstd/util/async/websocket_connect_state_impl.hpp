@@ -4,6 +4,8 @@
 #include <notstd/util/async/ssl_stream_connect_state_impl.hpp>
 #include <notstd/util/net.hpp>
 #include <notstd/util/websocket.hpp>
+#include <notstd/util/websocket_compression.hpp>
+#include <notstd/util/write_coalescing_stream.hpp>
 
 namespace notstd::util::async
 {
@@ -33,6 +35,27 @@ namespace notstd::util::async
 
         auto cancel(error_code = net::error::operation_aborted) -> void;
 
+        /// The permessage-deflate settings offered in the handshake
+        /// @pre the connect has not started
+        auto set_compression_options(compression_options opts) -> void
+        {
+            compression_ = opts;
+        }
+
+        /// How the TCP connection is raced
+        /// @pre the connect has not started
+        auto set_connect_options(happy_eyeballs_options opts) -> void
+        {
+            connect_options_ = opts;
+        }
+
+        /// The cache the host is resolved through, if any
+        /// @pre the connect has not started
+        auto set_resolve_cache(std::shared_ptr< resolve_cache > cache) -> void
+        {
+            resolve_cache_ = std::move(cache);
+        }
+
         auto get_executor() -> executor_type { return websock_.get_executor(); }
 
         friend auto operator<<(std::ostream &                             os,
@@ -46,6 +69,9 @@ namespace notstd::util::async
       private:
         websock_type &                    websock_;
         std::function< void(error_code) > on_cancel_;
+        compression_options               compression_;
+        happy_eyeballs_options            connect_options_;
+        std::shared_ptr< resolve_cache >  resolve_cache_;
     };
 
     template < class NextLayer >
@@ -56,6 +82,16 @@ namespace notstd::util::async
 
 }   // namespace notstd::util::async
 
+namespace notstd::util
+{
+    /// Connecting the coalescing layer is connecting the layer beneath it
+    template < class NextLayer >
+    auto make_connect_state_impl(write_coalescing_stream< NextLayer > &stream)
+    {
+        return async::make_connect_state_impl(stream.next_layer());
+    }
+}   // namespace notstd::util
+
 namespace notstd::util::async
 {
     template < class NextLayer >
@@ -84,6 +120,8 @@ namespace notstd::util::async
         spdlog::trace("{} connect next layer: [host {}] [port {}]", *this, host, port);
         auto next_layer_connect =
             make_connect_state_impl(websock_.next_layer());
+        next_layer_connect.set_connect_options(connect_options_);
+        next_layer_connect.set_resolve_cache(resolve_cache_);
         on_cancel_ = [&](error_code ec) {
 #if !defined(NDEBUG)
             assert(get_executor() == my_executor);
@@ -109,6 +147,7 @@ namespace notstd::util::async
             spdlog::trace("{} cancel signal: {}", *this, ec);
         };
 
+        websock_.set_option(to_permessage_deflate(compression_));
         co_await websock_.async_handshake(
             host,
             beast::string_view(target.data(), target.size()),
@@ -1,9 +1,20 @@
 #pragma once
+#include <algorithm>
+#include <chrono>
 #include <fmt/ostream.h>
 #include <notstd/util/async/async_join_impl.hpp>
+#include <notstd/util/async/detail/frame_dispatch.hpp>
 #include <notstd/util/async/executor_traits.hpp>
 #include <notstd/util/async/queue_impl.hpp>
+#include <notstd/util/async/send_priority.hpp>
+#include <notstd/util/buffer_pool.hpp>
+#include <notstd/util/happy_eyeballs.hpp>
+#include <notstd/util/latency_histogram.hpp>
+#include <notstd/util/receive_buffer.hpp>
+#include <notstd/util/resolve_cache.hpp>
 #include <notstd/util/websocket.hpp>
+#include <notstd/util/websocket_compression.hpp>
+#include <notstd/util/write_coalescing_stream.hpp>
 #include <span>
 #include <spdlog/spdlog.h>
 
@@ -15,10 +26,65 @@ namespace notstd::util::async
     {
         using traits_type =
             executor_traits< typename NextLayer::executor_type >;
-        using stream_type   = websocket::stream< NextLayer >;
+        using stream_type =
+            websocket::stream< write_coalescing_stream< NextLayer > >;
         using executor_type = typename traits_type::executor_type;
         using awaitable     = typename traits_type::template awaitable< void >;
 
+        /// Controls how queued frames are batched into writes on the
+        /// underlying stream
+        struct write_options
+        {
+            /// The most frames sent in one write
+            std::size_t max_frames_per_batch = 64;
+
+            /// The most bytes held back to make up a batch
+            std::size_t max_batch_bytes = 64 * 1024;
+
+            /// How long the writer may wait for further frames when fewer
+            /// than max_frames_per_batch are ready. Zero sends whatever is
+            /// ready immediately. An urgent frame ends the wait, and is
+            /// written ahead of the bulk frames in its batch
+            std::chrono::steady_clock::duration latency_budget {};
+
+            /// The outstanding bytes at or above which async_send_text and
+            /// async_send_binary wait before queueing their frame. Zero for
+            /// no limit
+            std::size_t high_water_mark = 0;
+        };
+
+        /// Controls how much of each incoming message is held in memory
+        struct read_options
+        {
+            /// The largest message accepted. A longer message fails the
+            /// connection with websocket::error::message_too_big
+            std::size_t max_message_size = 16 * 1024 * 1024;
+
+            /// The most bytes read for each fragment passed to a streaming
+            /// frame handler
+            std::size_t max_fragment_size = 64 * 1024;
+        };
+
+        /// Controls how a silent peer is detected. Zero durations disable
+        /// the corresponding behaviour
+        struct keepalive_options
+        {
+            /// How often a ping is sent once connected. The pongs that come
+            /// back are timed into round_trip_times()
+            std::chrono::steady_clock::duration ping_interval {};
+
+            /// How long the connection may go without receiving anything,
+            /// including pongs, before it is failed. After half of this
+            /// without receiving, an untimed ping is sent to prompt the peer.
+            /// Should be comfortably longer than ping_interval
+            std::chrono::steady_clock::duration idle_timeout {};
+
+            /// The longest the websocket handshake, or the closing handshake,
+            /// may take
+            std::chrono::steady_clock::duration handshake_timeout =
+                std::chrono::seconds(30);
+        };
+
         /// Construct with arguments necessary to construct the websocket stream
         /// @tparam Args
         /// @param args
@@ -27,13 +93,103 @@ namespace notstd::util::async
 
         auto get_executor() -> executor_type { return stream_.get_executor(); }
 
+        /// Takes effect from the next batch
+        auto set_write_options(write_options opts) -> void
+        {
+            write_options_ = opts;
+        }
+
+        /// @pre the state is not running
+        auto set_read_options(read_options opts) -> void
+        {
+            read_options_ = opts;
+        }
+
+        /// @pre the state is not running
+        auto set_keepalive_options(keepalive_options opts) -> void
+        {
+            keepalive_options_ = opts;
+        }
+
+        /// Round trip times measured from pings to their pongs. Kept across
+        /// connections. A ping cannot overtake a frame already being
+        /// written, so while a large frame or batch is going out the time
+        /// includes the wait for it as well as the network
+        auto round_trip_times() const -> latency_histogram const &
+        {
+            return rtt_;
+        }
+
+        /// Set how the buffer that whole messages and fragments are read into
+        /// is sized. Frames read into pooled buffers do not use it.
+        /// @pre the state is not running
+        auto set_receive_buffer_policy(receive_buffer_policy policy) -> void
+        {
+            rx_buffer_.set_policy(policy);
+        }
+
+        /// Memory counters of the receive buffer. The buffer's storage is
+        /// freed when the connection ends, but the counters are kept
+        auto receive_buffer_stats() const -> util::receive_buffer_stats
+        {
+            return rx_buffer_.stats();
+        }
+
+        /// The permessage-deflate settings offered when connecting
+        /// @pre the state is not running
+        auto set_compression_options(compression_options opts) -> void
+        {
+            compression_ = opts;
+        }
+
+        /// How the addresses of the host are raced when connecting
+        /// @pre the state is not running
+        auto set_connect_options(happy_eyeballs_options opts) -> void
+        {
+            connect_options_ = opts;
+        }
+
+        /// Resolve the host through a cache, which may be shared with other
+        /// states on any thread
+        /// @pre the state is not running
+        auto set_resolve_cache(std::shared_ptr< resolve_cache > cache) -> void
+        {
+            resolve_cache_ = std::move(cache);
+        }
+
         /// Model of a frame handler which ignores incoming data
         struct null_frame_handler
         {
             void operator()(std::span< char >) const {}
         };
 
+        /// Draw receive buffers from the given pool, for instance one shared
+        /// by many connections, rather than this state's own.
+        /// @pre the state is not running
+        auto set_receive_buffer_pool(buffer_pool pool) -> void
+        {
+            rx_pool_ = std::move(pool);
+        }
+
         /// Run the state, calling the supplied frame handlers as frames arrive
+        ///
+        /// A frame handler is invoked either with a std::span< char > which is
+        /// valid only for the duration of the call, or, if it is not
+        /// invocable with a span but is with a pooled_buffer, with a buffer
+        /// holding the frame. Frames are then read directly into buffers from
+        /// the receive pool, so the handler may keep the buffer, or pass it
+        /// to another thread, without copying. The storage returns to the
+        /// pool once the last copy of the buffer is destroyed.
+        ///
+        /// A handler invocable only with a frame_fragment is instead called
+        /// with each part of a message as it is read, so that large messages
+        /// may be consumed before they are complete. The state then holds at
+        /// most read_options::max_fragment_size bytes of such a message. The
+        /// other handler, if it takes spans, is called once its messages are
+        /// complete. Streaming and pooled handlers may not be mixed.
+        ///
+        /// The handlers are held by value in this coroutine and called
+        /// directly, without type erasure.
         /// @tparam OnTextFrame
         /// @tparam OnBinaryFrame
         /// @param on_text The handler to call when a text frame arrives. This
@@ -49,8 +205,8 @@ namespace notstd::util::async
         ///  dependent objects if necessary.
         /// @return
         template < class OnTextFrame, class OnBinaryFrame = null_frame_handler >
-        auto operator()(OnTextFrame &&  on_text,
-                        OnBinaryFrame &&on_binary = OnBinaryFrame())
+        auto operator()(OnTextFrame   on_text,
+                        OnBinaryFrame on_binary = OnBinaryFrame())
             -> awaitable;
 
         /// Notify the websocket that it should close. Successful closing of the
@@ -66,14 +222,160 @@ namespace notstd::util::async
         /// @exception system_error is thrown if the websocket is not connected
         /// at the time of this call
         /// @param text
-        auto send_text(TextType text) -> void;
+        /// @param priority the lane to queue the frame in. Urgent frames
+        /// overtake any bulk frames which have not yet been written
+        auto send_text(TextType      text,
+                       send_priority priority = send_priority::bulk) -> void;
+
+        /// Notify the websocket that it should send a binary frame as soon as
+        /// possible, queued in order with text frames. As for send_text, no
+        /// indication is fed back to the caller.
+        /// @pre websocket is connected
+        /// @exception system_error is thrown if the websocket is not connected
+        /// at the time of this call
+        /// @param data the frame's bytes, held in the same container type as
+        /// the text of text frames
+        /// @param priority the lane to queue the frame in
+        auto send_binary(TextType      data,
+                         send_priority priority = send_priority::bulk) -> void;
+
+        /// Queue a text frame, completing once it has been written or has
+        /// failed to be.
+        ///
+        /// While the outstanding bytes are at or above the high water mark
+        /// the frame is held back, in order with other such frames, until
+        /// the writer has caught up. Frames from send_text and send_binary
+        /// are never held back, but count towards the outstanding bytes.
+        /// @param text
+        /// @param priority the lane to queue the frame in
+        /// @param token completion token for void(error_code). The error is
+        /// net::error::not_connected if the websocket is not connected at the
+        /// time of this call, or the reason the frame was not written
+        template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code))
+                       SendHandler >
+        auto async_send_text(TextType      text,
+                             send_priority priority,
+                             SendHandler &&token)
+            -> BOOST_ASIO_INITFN_RESULT_TYPE(SendHandler, void(error_code));
+
+        template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code))
+                       SendHandler >
+        auto async_send_text(TextType text, SendHandler &&token)
+            -> BOOST_ASIO_INITFN_RESULT_TYPE(SendHandler, void(error_code))
+        {
+            return async_send_text(std::move(text),
+                                   send_priority::bulk,
+                                   std::forward< SendHandler >(token));
+        }
+
+        /// As async_send_text, for a binary frame
+        template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code))
+                       SendHandler >
+        auto async_send_binary(TextType      data,
+                               send_priority priority,
+                               SendHandler &&token)
+            -> BOOST_ASIO_INITFN_RESULT_TYPE(SendHandler, void(error_code));
+
+        /// True while frames may be sent, i.e. from when connect or accept
+        /// completes until the connection fails or starts to close
+        auto connected() const -> bool { return tx_queue_ != nullptr; }
+
+        /// The number of frames in a lane waiting to be written. Zero when
+        /// not connected
+        auto queue_depth(send_priority lane) const -> std::size_t;
+
+        /// The bytes queued or being written, excluding frames held back by
+        /// the high water mark
+        auto outstanding_bytes() const -> std::size_t
+        {
+            return tx_outstanding_;
+        }
 
         using connect_awaitable = net::awaitable< void, executor_type >;
 
         auto connect(std::string host, std::string port, std::string target)
             -> connect_awaitable;
 
+        /// The server side of connect: complete the handshakes of a stream
+        /// which was constructed from an accepted socket, answering the
+        /// client's upgrade request. Completes once the websocket is up.
+        /// As for connect, the state must be running for this to complete
+        auto accept() -> connect_awaitable;
+
       private:
+        /// A frame waiting in the transmit queue
+        using sent_handler_type = poly_handler_for<
+            void(error_code),
+            guarded_handler_t<
+                typename traits_type::template awaitable_handler< void(
+                    error_code) >,
+                executor_type > >;
+
+        struct tx_frame
+        {
+            TextType      payload;
+            bool          binary   = false;
+            send_priority priority = send_priority::bulk;
+
+            /// Completion of an async send, if any
+            sent_handler_type on_sent = sent_handler_type();
+        };
+
+        /// Storage for the transmit queue: a FIFO lane per priority, from
+        /// which frames are taken in priority order
+        struct tx_lanes
+        {
+            auto empty() const -> bool { return size() == 0; }
+
+            auto size() const -> std::size_t
+            {
+                return urgent.size() + bulk.size();
+            }
+
+            auto front() -> tx_frame &
+            {
+                return urgent.empty() ? bulk.front() : urgent.front();
+            }
+
+            auto push_back(tx_frame frame) -> void
+            {
+                lane(frame.priority).push_back(std::move(frame));
+            }
+
+            auto pop_front() -> void
+            {
+                if (urgent.empty())
+                    bulk.pop_front();
+                else
+                    urgent.pop_front();
+            }
+
+            auto lane(send_priority priority) -> ring_buffer< tx_frame > &
+            {
+                return priority == send_priority::urgent ? urgent : bulk;
+            }
+
+            ring_buffer< tx_frame > urgent;
+            ring_buffer< tx_frame > bulk;
+        };
+
+        using tx_queue_type = queue_impl< tx_frame, executor_type, tx_lanes >;
+
+        // zero disables a timeout here, whereas to Beast it is immediate
+        static auto or_none(std::chrono::steady_clock::duration d)
+            -> std::chrono::steady_clock::duration
+        {
+            return d.count() > 0 ? d : websocket::stream_base::none();
+        }
+
+        // queue a frame, or hold it back if async and over the high water
+        // mark
+        auto enqueue(tx_frame frame) -> void;
+
+        // initiate an async send
+        template < class SendHandler >
+        auto initiate_send(tx_frame frame, SendHandler &&token);
+
         /// The substate that controls writing of frames
         struct write_state_impl
         {
@@ -89,6 +391,26 @@ namespace notstd::util::async
             }
 
           private:
+            using frame_batch = typename tx_queue_type::batch_type;
+
+            // send the frames, coalesced into as few writes on the
+            // underlying stream as the write options allow, and complete
+            // those which reached it. Once stop is set, no more frames are
+            // started than it takes to send those already held back; the
+            // rest are left in frames. On failure, held back bytes are
+            // dropped and their frames left in frames with the rest
+            auto write_batch(frame_batch &frames, error_code const &stop)
+                -> net::awaitable< void, executor_type >;
+
+            // complete the first n frames' async sends with ec, remove them
+            // and release their bytes, then admit held back frames which
+            // now fit
+            auto complete(frame_batch &frames, std::size_t n, error_code ec)
+                -> void;
+
+            // complete every frame not yet written with ec
+            auto abandon(frame_batch &frames, error_code ec) -> void;
+
             websocket_state_impl &               outer_state_;
             std::function< void(error_code ec) > on_cancel_ = nullptr;
         };
@@ -97,7 +419,11 @@ namespace notstd::util::async
         struct read_state_impl
         {
             read_state_impl(websocket_state_impl &outer_state);
-            auto        operator()() -> net::awaitable< void, executor_type >;
+
+            template < class OnTextFrame, class OnBinaryFrame >
+            auto operator()(OnTextFrame &on_text, OnBinaryFrame &on_binary)
+                -> net::awaitable< void, executor_type >;
+
             friend auto operator<<(std::ostream &         os,
                                    read_state_impl const &state)
                 -> std::ostream &
@@ -138,6 +464,25 @@ namespace notstd::util::async
             std::function< void(error_code) >              on_cancel_;
         };
 
+        /// The substate that sends pings and times their pongs
+        struct ping_state_impl
+        {
+            ping_state_impl(websocket_state_impl &outer_state);
+            auto operator()() -> net::awaitable< void, executor_type >;
+            auto cancel() -> void;
+            friend auto operator<<(std::ostream &         os,
+                                   ping_state_impl const &state)
+                -> std::ostream &
+            {
+                fmt::print(os, "[{}::ping]", print(state.outer_state_));
+                return os;
+            }
+
+          private:
+            websocket_state_impl & outer_state_;
+            std::function< void() > on_cancel_ = nullptr;
+        };
+
         friend auto operator<<(std::ostream &              os,
                                websocket_state_impl const &state)
             -> std::ostream &
@@ -152,6 +497,9 @@ namespace notstd::util::async
             std::string host;
             std::string port;
             std::string target;
+
+            /// Accept the websocket rather than connect it
+            bool accept = false;
         };
 
       private:
@@ -159,12 +507,23 @@ namespace notstd::util::async
         std::function< void(websocket::close_reason) >    on_close_;
         async_join_impl< executor_type, connect_request > connect_latch_;
         async_event< executor_type >                      connected_signal_;
-        std::function< void(std::span< char >) > on_text_frame_   = nullptr;
-        std::function< void(std::span< char >) > on_binary_frame_ = nullptr;
-        std::function< void(TextType) >          on_send_text_    = nullptr;
+        tx_queue_type *                                   tx_queue_ = nullptr;
+        std::function< void() >                           tx_urgent_;
+        std::size_t                                       tx_outstanding_ = 0;
+        ring_buffer< tx_frame >                           tx_held_;
+        write_options                                     write_options_;
+        read_options                                      read_options_;
+        buffer_pool                                       rx_pool_;
+        receive_buffer                                    rx_buffer_;
+        compression_options                               compression_;
+        happy_eyeballs_options                            connect_options_;
+        std::shared_ptr< resolve_cache >                  resolve_cache_;
+        keepalive_options                                 keepalive_options_;
+        latency_histogram                                 rtt_;
     };
 }   // namespace notstd::util::async
 
+#include <notstd/util/async/websocket_accept_state_impl.hpp>
 #include <notstd/util/async/websocket_connect_state_impl.hpp>
 
 namespace notstd::util::async
@@ -182,12 +541,15 @@ namespace notstd::util::async
     template < class NextLayer, class TextType >
     template < class OnTextFrame, class OnBinaryFrame >
     auto websocket_state_impl< NextLayer, TextType >::operator()(
-        OnTextFrame &&  on_text,
-        OnBinaryFrame &&on_binary) -> awaitable
+        OnTextFrame   on_text,
+        OnBinaryFrame on_binary) -> awaitable
     {
+        static_assert(detail::is_frame_handler_v< OnTextFrame > and
+                          detail::is_frame_handler_v< OnBinaryFrame >,
+                      "frame handler must accept std::span< char >, "
+                      "pooled_buffer or frame_fragment");
+
         auto close_request = std::optional< websocket::close_reason >();
-        on_text_frame_     = std::forward< OnTextFrame >(on_text);
-        on_binary_frame_   = std::forward< OnBinaryFrame >(on_binary);
 
         try
         {
@@ -209,20 +571,53 @@ namespace notstd::util::async
             // start connection
             //
 
-            auto connect_state = make_connect_state_impl(stream_);
-            on_close_          = [&](websocket::close_reason reason) {
-                spdlog::trace("{} close requested: {}", *this, print(reason));
+            stream_.set_option(websocket::stream_base::timeout {
+                .handshake_timeout =
+                    or_none(keepalive_options_.handshake_timeout),
+                .idle_timeout     = or_none(keepalive_options_.idle_timeout),
+                .keep_alive_pings =
+                    keepalive_options_.idle_timeout.count() > 0 });
+
+            auto cr = get< connect_request & >(connect_latch_.events());
+            if (cr.accept)
+            {
+                auto accept_state = make_accept_state_impl(stream_);
+                accept_state.set_compression_options(compression_);
+                on_close_ = [&](websocket::close_reason reason) {
+                    spdlog::trace(
+                        "{} close requested: {}", *this, print(reason));
+                    close_request = reason;
+                    accept_state.cancel();
+                };
+                spdlog::trace("{} accept", *this);
+                co_await accept_state();
+            }
+            else
+            {
+                auto connect_state = make_connect_state_impl(stream_);
+                connect_state.set_compression_options(compression_);
+                connect_state.set_connect_options(connect_options_);
+                connect_state.set_resolve_cache(resolve_cache_);
+                on_close_ = [&](websocket::close_reason reason) {
+                    spdlog::trace(
+                        "{} close requested: {}", *this, print(reason));
+                    close_request = reason;
+                    connect_state.cancel();
+                };
+                spdlog::trace("{} connect: {}://{}{}",
+                              *this,
+                              cr.port,
+                              cr.host,
+                              cr.target);
+                co_await connect_state(cr.host, cr.port, cr.target);
+            }
+            on_close_ = [&](websocket::close_reason reason) {
                 close_request = reason;
-                connect_state.cancel();
             };
-            auto cr = get< connect_request & >(connect_latch_.events());
-            spdlog::trace(
-                "{} connect: {}://{}{}", *this, cr.port, cr.host, cr.target);
-            co_await connect_state(cr.host, cr.port, cr.target);
             spdlog::trace("{} connection up", *this);
 
             //
-            // fork into read, write and close states
+            // fork into read, write, close and ping states
             //
 
             struct writer_done
@@ -231,18 +626,24 @@ namespace notstd::util::async
             struct closer_done
             {
             };
+            struct pinger_done
+            {
+            };
 
             auto write_state = write_state_impl(*this);
             auto close_state = close_state_impl(*this);
+            auto ping_state  = ping_state_impl(*this);
             auto read_state  = read_state_impl(*this);
 
             // provide a rendezvous object so that the orthognoal regions of
             // read, write and close can join. The read state shall be the
             // parent 'thread' so no need to provide an event for it, as it will
             // initiate the join
-            auto connected_join =
-                async_join_impl< executor_type, writer_done, closer_done >(
-                    get_executor());
+            auto connected_join = async_join_impl< executor_type,
+                                                   writer_done,
+                                                   closer_done,
+                                                   pinger_done >(
+                get_executor());
 
             // fork the write state and ensure that it notifies the rendezvous
             // when it exits (for any reason)
@@ -268,6 +669,18 @@ namespace notstd::util::async
                     connected_join.set_event(closer_done());
                 });
 
+            // fork the ping state and ensure that it notifies the rendezvous
+            // when it exits (for any reason)
+            net::co_spawn(
+                get_executor(),
+                [&]() -> net::awaitable< void, executor_type > {
+                    co_await ping_state();
+                },
+                [&](std::exception_ptr ep) {
+                    spdlog::trace("{} ping exit: {}", *this, explain(ep));
+                    connected_join.set_event(pinger_done());
+                });
+
             // run the read state until complete
             try
             {
@@ -281,6 +694,7 @@ namespace notstd::util::async
                     spdlog::trace("{} close requested: {}", *this, print(reason));
                     close_state.close(reason);
                     write_state.cancel();
+                    ping_state.cancel();
                 };
 
                 // if the close request has already arrived, action it now,
@@ -294,23 +708,23 @@ namespace notstd::util::async
 
                 // run the read state to completion - this means either a comms
                 // error or a succesful close
-                co_await read_state();
+                co_await read_state(on_text, on_binary);
             }
             catch (...)
             {
                 spdlog::trace("{} read exception: {}", *this, explain());
-                // if we get a read error, we must ensure that the write and
-                // close states are properly canceled, otherwise the join may
-                // not happen
-                write_state.cancel();
-                close_state.cancel();
             }
 
-            // join the forked coroutines
-            connected_join.async_wait(net::use_awaitable_t< executor_type >());
+            // whether the read failed or the peer closed the connection, we
+            // must ensure that the write, close and ping states are properly
+            // canceled, otherwise the join may not happen
+            write_state.cancel();
+            close_state.cancel();
+            ping_state.cancel();
 
-            on_text_frame_   = nullptr;
-            on_binary_frame_ = nullptr;
+            // join the forked coroutines
+            co_await connected_join.async_wait(
+                net::use_awaitable_t< executor_type >());
 
             co_return;
         }
@@ -318,9 +732,7 @@ namespace notstd::util::async
         {
             spdlog::trace("{} exception: {}", *this, explain());
             connected_signal_.cancel(se.code());
-            on_close_        = nullptr;
-            on_text_frame_   = nullptr;
-            on_binary_frame_ = nullptr;
+            on_close_ = nullptr;
             if (not close_request)
                 throw;
         }
@@ -328,9 +740,7 @@ namespace notstd::util::async
         {
             spdlog::trace("{} exception: {}", *this, explain());
             connected_signal_.cancel(net::error::fault);
-            on_close_        = nullptr;
-            on_text_frame_   = nullptr;
-            on_binary_frame_ = nullptr;
+            on_close_ = nullptr;
             if (not close_request)
                 throw;
         }
@@ -377,6 +787,31 @@ namespace notstd::util::async
         throw;
     }
 
+    template < class NextLayer, class TextType >
+    auto websocket_state_impl< NextLayer, TextType >::accept()
+        -> connect_awaitable
+    try
+    {
+        assert(co_await net::this_coro::executor == get_executor());
+        assert(not connect_latch_.triggered());
+
+        spdlog::trace("{}::accept() starting", *this);
+
+        connect_latch_.set_event(connect_request { .accept = true });
+
+        co_await connected_signal_.async_wait(
+            net::use_awaitable_t< executor_type >());
+
+        spdlog::trace("{}::accept complete", *this);
+
+        co_return;
+    }
+    catch (...)
+    {
+        spdlog::trace("{}::accept exception: {}", *this, explain());
+        throw;
+    }
+
     //
     // write state
     //
@@ -392,51 +827,192 @@ namespace notstd::util::async
     auto
     websocket_state_impl< NextLayer, TextType >::write_state_impl::operator()()
         -> net::awaitable< void, executor_type >
-    try
     {
-        auto my_error = error_code();
-        auto tx_queue =
-            queue_impl< TextType, executor_type >(outer_state_.get_executor());
+        using timer_type = net::basic_waitable_timer<
+            std::chrono::steady_clock,
+            net::wait_traits< std::chrono::steady_clock >,
+            executor_type >;
 
-        outer_state_.on_send_text_ = [&](TextType text) {
-            tx_queue.push(std::move(text));
+        auto my_error     = error_code();
+        auto tx_queue     = tx_queue_type(outer_state_.get_executor());
+        auto budget_timer = timer_type(outer_state_.get_executor());
+        auto frames       = frame_batch();
+        auto ep           = std::exception_ptr();
+
+        outer_state_.tx_queue_ = &tx_queue;
+
+        // a cancel while a batch is being written takes effect between its
+        // frames
+        on_cancel_ = [&](error_code ec) {
+            my_error = ec;
+            tx_queue.cancel(ec);
+            budget_timer.cancel();
+            spdlog::trace("{}::on_cancel({})", *this, print(ec));
+            outer_state_.tx_queue_ = nullptr;
         };
 
-        while (!my_error)
+        try
         {
-            on_cancel_ = [&](error_code ec) {
-                my_error = ec;
-                tx_queue.cancel(ec);
-                spdlog::trace("{}::on_cancel({})", *this, print(ec));
-                outer_state_.on_send_text_ = nullptr;
-            };
-            auto frame =
-                co_await tx_queue.async_pop(outer_state_.use_awaitable);
-            if (my_error)
-                break;
-
-            on_cancel_ = nullptr;
-            co_await outer_state_.stream_.async_write(
-                net::buffer(frame.data(), frame.size()),
-                outer_state_.use_awaitable);
+            while (!my_error)
+            {
+                auto const opts = outer_state_.write_options_;
+                frames          = co_await tx_queue.async_pop_some(
+                    opts.max_frames_per_batch, outer_state_.use_awaitable);
+                if (my_error)
+                    break;
+
+                // give stragglers a chance to join the batch, unless
+                // something in it is urgent or is queued behind it. An
+                // urgent frame queued during the wait cuts it short, and is
+                // written first
+                auto is_urgent = [](tx_frame const &f) {
+                    return f.priority == send_priority::urgent;
+                };
+                auto urgent =
+                    std::any_of(frames.begin(), frames.end(), is_urgent) or
+                    not tx_queue.queue_.urgent.empty();
+                if (opts.latency_budget.count() > 0 and not urgent and
+                    frames.size() < opts.max_frames_per_batch)
+                {
+                    budget_timer.expires_after(opts.latency_budget);
+                    outer_state_.tx_urgent_ = [&] { budget_timer.cancel(); };
+                    auto ec = error_code();
+                    co_await budget_timer.async_wait(
+                        net::redirect_error(outer_state_.use_awaitable, ec));
+                    outer_state_.tx_urgent_ = nullptr;
+                    if (my_error)
+                        break;
+                    for (auto &frame : tx_queue.take(
+                             opts.max_frames_per_batch - frames.size()))
+                        frames.push_back(std::move(frame));
+                    std::stable_partition(
+                        frames.begin(), frames.end(), is_urgent);
+                }
+
+                co_await write_batch(frames, my_error);
+            }
+        }
+        catch (system_error &se)
+        {
+            my_error = se.code();
+            ep       = std::current_exception();
+        }
+        catch (...)
+        {
+            my_error = net::error::fault;
+            ep       = std::current_exception();
         }
 
-        outer_state_.on_send_text_ = nullptr;
+        // fail whatever was not written
+        on_cancel_              = nullptr;
+        outer_state_.tx_queue_  = nullptr;
+        outer_state_.tx_urgent_ = nullptr;
+        for (auto &frame : tx_queue.take(tx_queue.queue_.size()))
+            frames.push_back(std::move(frame));
+        abandon(frames, my_error ? my_error : net::error::operation_aborted);
 
-        co_return;
+        if (ep)
+        {
+            spdlog::trace("{} exception: {}", *this, explain(ep));
+            std::rethrow_exception(ep);
+        }
     }
-    catch (...)
+
+    template < class NextLayer, class TextType >
+    auto websocket_state_impl< NextLayer, TextType >::write_state_impl::
+        write_batch(frame_batch &frames, error_code const &stop)
+            -> net::awaitable< void, executor_type >
     {
-        outer_state_.on_send_text_ = nullptr;
-        spdlog::trace("{} exception: {}", *this, explain());
-        throw;
+        auto &stream    = outer_state_.stream_;
+        auto &coalescer = stream.next_layer();
+
+        // every frame but the last is held back, the last carries them all.
+        // A frame has reached the stream once nothing is held back after it,
+        // whether its own write or a control frame written since sent it
+        auto i    = std::size_t(0);
+        auto sent = std::size_t(0);
+        try
+        {
+            if (frames.size() > 1)
+                coalescer.cork(outer_state_.write_options_.max_batch_bytes);
+
+            for (; i < frames.size(); ++i)
+            {
+                if (coalescer.pending() == 0)
+                {
+                    sent = i;
+                    if (stop)
+                        break;
+                }
+
+                // when stopping, this frame carries those held back
+                if (i + 1 == frames.size() or stop)
+                    coalescer.uncork();
+                auto &payload = frames[i].payload;
+                stream.binary(frames[i].binary);
+                co_await stream.async_write(
+                    net::buffer(payload.data(), payload.size()),
+                    outer_state_.use_awaitable);
+            }
+            if (coalescer.pending() == 0)
+                sent = i;
+        }
+        catch (...)
+        {
+            // the frames before the failed one succeeded, unless held back
+            if (coalescer.pending() == 0)
+                sent = i;
+            coalescer.uncork();
+            coalescer.discard();
+            complete(frames, sent, error_code());
+            throw;
+        }
+
+        coalescer.uncork();
+        complete(frames, sent, error_code());
+    }
+
+    template < class NextLayer, class TextType >
+    auto websocket_state_impl< NextLayer, TextType >::write_state_impl::
+        complete(frame_batch &frames, std::size_t n, error_code ec) -> void
+    {
+        auto &outer = outer_state_;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            outer.tx_outstanding_ -= frames[i].payload.size();
+            if (frames[i].on_sent)
+                frames[i].on_sent.post_completion(ec);
+        }
+        frames.erase(frames.begin(), frames.begin() + n);
+
+        auto const hwm = outer.write_options_.high_water_mark;
+        while (outer.tx_queue_ and not outer.tx_held_.empty() and
+               (hwm == 0 or outer.tx_outstanding_ < hwm))
+        {
+            auto frame = std::move(outer.tx_held_.front());
+            outer.tx_held_.pop_front();
+            outer.tx_outstanding_ += frame.payload.size();
+            outer.tx_queue_->push(std::move(frame));
+        }
+    }
+
+    template < class NextLayer, class TextType >
+    auto websocket_state_impl< NextLayer, TextType >::write_state_impl::
+        abandon(frame_batch &frames, error_code ec) -> void
+    {
+        complete(frames, frames.size(), ec);
+        auto &held = outer_state_.tx_held_;
+        for (; not held.empty(); held.pop_front())
+            if (held.front().on_sent)
+                held.front().on_sent.post_completion(ec);
     }
 
     template < class NextLayer, class TextType >
     auto websocket_state_impl< NextLayer, TextType >::write_state_impl::cancel(
         error_code ec) -> void
     {
-        on_cancel_(ec);
+        if (on_cancel_)
+            on_cancel_(ec);
     }
 
     //
@@ -502,6 +1078,91 @@ namespace notstd::util::async
             on_cancel_(ec);
     }
 
+    //
+    // ping state
+    //
+
+    template < class NextLayer, class TextType >
+    websocket_state_impl< NextLayer, TextType >::ping_state_impl::
+        ping_state_impl(websocket_state_impl &outer_state)
+    : outer_state_(outer_state)
+    {
+    }
+
+    template < class NextLayer, class TextType >
+    auto
+    websocket_state_impl< NextLayer, TextType >::ping_state_impl::operator()()
+        -> net::awaitable< void, executor_type >
+    {
+        using clock_type = std::chrono::steady_clock;
+        using timer_type = net::basic_waitable_timer<
+            clock_type,
+            net::wait_traits< clock_type >,
+            executor_type >;
+
+        auto const interval = outer_state_.keepalive_options_.ping_interval;
+        if (interval.count() <= 0)
+            co_return;
+
+        auto &stream   = outer_state_.stream_;
+        auto  timer    = timer_type(outer_state_.get_executor());
+        auto  stopped  = false;
+        auto  sequence = std::uint64_t(0);
+        auto  awaiting = websocket::ping_data();
+        auto  sent     = clock_type::time_point();
+
+        on_cancel_ = [&] {
+            spdlog::trace("{}::on_cancel()", *this);
+            stopped = true;
+            timer.cancel();
+        };
+
+        // only the latest ping is timed. A pong to an earlier one, or an
+        // unsolicited pong, is ignored
+        stream.control_callback(
+            [&](websocket::frame_type kind, beast::string_view payload) {
+                if (kind != websocket::frame_type::pong or awaiting.empty() or
+                    payload != beast::string_view(awaiting))
+                    return;
+                outer_state_.rtt_.record(clock_type::now() - sent);
+                awaiting.clear();
+            });
+
+        try
+        {
+            while (not stopped)
+            {
+                timer.expires_after(interval);
+                auto ec = error_code();
+                co_await timer.async_wait(
+                    net::redirect_error(outer_state_.use_awaitable, ec));
+                if (stopped)
+                    break;
+
+                awaiting = std::to_string(++sequence);
+                sent     = clock_type::now();
+                co_await stream.async_ping(awaiting,
+                                           outer_state_.use_awaitable);
+            }
+        }
+        catch (...)
+        {
+            spdlog::trace("{} exception: {}", *this, explain());
+        }
+
+        // a failed ping is reported by the read state, which fails too
+        on_cancel_ = nullptr;
+        stream.control_callback();
+    }
+
+    template < class NextLayer, class TextType >
+    auto websocket_state_impl< NextLayer, TextType >::ping_state_impl::cancel()
+        -> void
+    {
+        if (on_cancel_)
+            on_cancel_();
+    }
+
     //
     // read state
     //
@@ -514,52 +1175,184 @@ namespace notstd::util::async
     }
 
     template < class NextLayer, class TextType >
-    auto
-    websocket_state_impl< NextLayer, TextType >::read_state_impl::operator()()
-        -> net::awaitable< void, executor_type >
+    template < class OnTextFrame, class OnBinaryFrame >
+    auto websocket_state_impl< NextLayer, TextType >::read_state_impl::
+        operator()(OnTextFrame &on_text, OnBinaryFrame &on_binary)
+            -> net::awaitable< void, executor_type >
     {
-        beast::flat_buffer rxbuf;
+        constexpr auto pooled =
+            detail::is_pooled_frame_handler_v< OnTextFrame > or
+            detail::is_pooled_frame_handler_v< OnBinaryFrame >;
+        constexpr auto streaming =
+            detail::is_fragment_frame_handler_v< OnTextFrame > or
+            detail::is_fragment_frame_handler_v< OnBinaryFrame >;
+        static_assert(not(pooled and streaming),
+                      "pooled and streaming frame handlers may not be mixed");
+
+        auto &stream = outer_state_.stream_;
+        auto &rx     = outer_state_.rx_buffer_;
+        auto  opts   = outer_state_.read_options_;
+        stream.read_message_max(opts.max_message_size);
+        if constexpr (not pooled)
+            rx.reserve();
         try
         {
-            for (;;)
+            if constexpr (streaming)
             {
-                auto bytes = co_await outer_state_.stream_.async_read(
-                    rxbuf, outer_state_.use_awaitable);
-                auto buf   = rxbuf.data();
-                auto first = reinterpret_cast< char * >(buf.data());
-                if (outer_state_.stream_.got_text())
+                auto first = true;
+                for (;;)
                 {
-                    if (outer_state_.on_text_frame_)
-                        outer_state_.on_text_frame_(
-                            std::span< char >(first, bytes));
+                    co_await stream.async_read_some(rx.buffer(),
+                                                    opts.max_fragment_size,
+                                                    outer_state_.use_awaitable);
+                    auto buf      = rx.buffer().data();
+                    auto data     = static_cast< char * >(buf.data());
+                    auto fragment = frame_fragment {
+                        .data  = std::span< char >(data, buf.size()),
+                        .first = first,
+                        .last  = stream.is_message_done()
+                    };
+                    first = fragment.last;
+                    if (detail::dispatch_fragment(
+                            stream.got_text(), fragment, on_text, on_binary))
+                        rx.consume_all();
                 }
-                else if (outer_state_.stream_.got_binary())
+            }
+            else if constexpr (pooled)
+            {
+                for (;;)
                 {
-                    if (outer_state_.on_binary_frame_)
-                        outer_state_.on_binary_frame_(
-                            std::span< char >(first, bytes));
+                    auto frame = outer_state_.rx_pool_.acquire();
+                    co_await stream.async_read(frame.buffer(),
+                                               outer_state_.use_awaitable);
+                    detail::dispatch_frame(stream.got_text(),
+                                           std::move(frame),
+                                           on_text,
+                                           on_binary);
                 }
-                else
+            }
+            else
+            {
+                for (;;)
                 {
-                    // ignore whatever this is
+                    auto bytes = co_await stream.async_read(
+                        rx.buffer(), outer_state_.use_awaitable);
+                    auto buf = rx.buffer().data();
+                    detail::dispatch_frame(
+                        stream.got_text(),
+                        std::span< char >(static_cast< char * >(buf.data()),
+                                          bytes),
+                        on_text,
+                        on_binary);
+                    rx.consume_all();
                 }
-                rxbuf.consume(bytes);
             }
         }
         catch (system_error &se)
         {
+            rx.release();
             if (se.code() != websocket::error::closed)
                 throw;
         }
+        catch (...)
+        {
+            rx.release();
+            throw;
+        }
     }
 
     template < class NextLayer, class TextType >
-    auto websocket_state_impl< NextLayer, TextType >::send_text(TextType text)
-        -> void
+    auto websocket_state_impl< NextLayer, TextType >::send_text(
+        TextType      text,
+        send_priority priority) -> void
     {
-        if (!on_send_text_)
+        if (!tx_queue_)
             throw system_error(net::error::not_connected);
-        on_send_text_(std::move(text));
+        enqueue(tx_frame { .payload = std::move(text), .priority = priority });
+    }
+
+    template < class NextLayer, class TextType >
+    auto websocket_state_impl< NextLayer, TextType >::send_binary(
+        TextType      data,
+        send_priority priority) -> void
+    {
+        if (!tx_queue_)
+            throw system_error(net::error::not_connected);
+        enqueue(tx_frame { .payload  = std::move(data),
+                           .binary   = true,
+                           .priority = priority });
+    }
+
+    template < class NextLayer, class TextType >
+    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code)) SendHandler >
+    auto websocket_state_impl< NextLayer, TextType >::async_send_text(
+        TextType      text,
+        send_priority priority,
+        SendHandler &&token)
+        -> BOOST_ASIO_INITFN_RESULT_TYPE(SendHandler, void(error_code))
+    {
+        return initiate_send(
+            tx_frame { .payload = std::move(text), .priority = priority },
+            std::forward< SendHandler >(token));
+    }
+
+    template < class NextLayer, class TextType >
+    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code)) SendHandler >
+    auto websocket_state_impl< NextLayer, TextType >::async_send_binary(
+        TextType      data,
+        send_priority priority,
+        SendHandler &&token)
+        -> BOOST_ASIO_INITFN_RESULT_TYPE(SendHandler, void(error_code))
+    {
+        return initiate_send(tx_frame { .payload  = std::move(data),
+                                        .binary   = true,
+                                        .priority = priority },
+                             std::forward< SendHandler >(token));
+    }
+
+    template < class NextLayer, class TextType >
+    template < class SendHandler >
+    auto websocket_state_impl< NextLayer, TextType >::initiate_send(
+        tx_frame      frame,
+        SendHandler &&token)
+    {
+        return net::async_initiate< SendHandler, void(error_code) >(
+            [this](auto &&handler, tx_frame frame) {
+                frame.on_sent.emplace_with_guards(std::move(handler),
+                                                  get_executor());
+                if (!tx_queue_)
+                    frame.on_sent.post_completion(
+                        error_code(net::error::not_connected));
+                else
+                    enqueue(std::move(frame));
+            },
+            token,
+            std::move(frame));
+    }
+
+    template < class NextLayer, class TextType >
+    auto websocket_state_impl< NextLayer, TextType >::enqueue(tx_frame frame)
+        -> void
+    {
+        auto const hwm = write_options_.high_water_mark;
+        if (frame.on_sent and hwm != 0 and
+            (tx_outstanding_ >= hwm or not tx_held_.empty()))
+        {
+            tx_held_.push_back(std::move(frame));
+            return;
+        }
+        tx_outstanding_ += frame.payload.size();
+        auto const urgent = frame.priority == send_priority::urgent;
+        tx_queue_->push(std::move(frame));
+        if (urgent and tx_urgent_)
+            tx_urgent_();
+    }
+
+    template < class NextLayer, class TextType >
+    auto websocket_state_impl< NextLayer, TextType >::queue_depth(
+        send_priority lane) const -> std::size_t
+    {
+        return tx_queue_ ? tx_queue_->queue_.lane(lane).size() : 0;
     }
 
 }   // namespace notstd::util::async
\ No newline at end of file
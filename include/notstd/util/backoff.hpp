@@ -0,0 +1,64 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+namespace notstd::util
+{
+    /// How retry delays grow
+    struct backoff_policy
+    {
+        using duration = std::chrono::steady_clock::duration;
+
+        /// The delay before the first retry, before jitter
+        duration initial = std::chrono::milliseconds(100);
+
+        /// The longest delay, before jitter
+        duration max = std::chrono::seconds(30);
+
+        /// The factor by which the delay grows after each retry
+        double multiplier = 2.0;
+
+        /// The fraction of each delay which is random, in [0, 1]. Zero gives
+        /// fixed delays. One gives delays anywhere from zero up to the
+        /// current limit, which best spreads out clients which failed at the
+        /// same moment
+        double jitter = 0.5;
+
+        /// A connection which stays up at least this long resets the delay
+        /// to initial
+        duration reset_after = std::chrono::seconds(10);
+    };
+
+    /// Jittered exponential backoff. Not thread-safe
+    class backoff
+    {
+      public:
+        using duration = backoff_policy::duration;
+
+        explicit backoff(backoff_policy policy = {});
+
+        /// Seeded, for repeatable delays
+        backoff(backoff_policy policy, std::uint64_t seed);
+
+        /// The delay before the next retry. Each call grows the limit on the
+        /// following delay
+        auto next() -> duration;
+
+        /// Start again from the initial delay
+        auto reset() -> void;
+
+        /// The number of delays taken since the last reset
+        auto attempts() const -> std::size_t { return attempts_; }
+
+        auto policy() const -> backoff_policy const & { return policy_; }
+
+      private:
+        backoff_policy policy_;
+        duration       limit_;
+        std::size_t    attempts_ = 0;
+        std::mt19937   rng_;
+    };
+
+}   // namespace notstd::util
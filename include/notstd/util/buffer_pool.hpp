@@ -0,0 +1,100 @@
+#pragma once
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <cstddef>
+#include <notstd/util/beast.hpp>
+#include <span>
+#include <string_view>
+#include <utility>
+
+namespace notstd::util
+{
+    namespace detail
+    {
+        struct buffer_pool_impl;
+        struct pooled_block;
+    }   // namespace detail
+
+    /// A reference-counted handle to a buffer drawn from a buffer_pool.
+    ///
+    /// Copies share the same storage, and may be passed to and released on
+    /// any thread. When the last copy is destroyed the storage returns to its
+    /// pool, keeping its capacity for the next frame.
+    class pooled_buffer
+    {
+      public:
+        pooled_buffer() = default;
+
+        pooled_buffer(pooled_buffer const &other) noexcept;
+        pooled_buffer(pooled_buffer &&other) noexcept
+        : block_(std::exchange(other.block_, nullptr))
+        {
+        }
+
+        pooled_buffer &operator=(pooled_buffer const &other) noexcept;
+        pooled_buffer &operator=(pooled_buffer &&other) noexcept;
+
+        ~pooled_buffer();
+
+        explicit operator bool() const { return block_ != nullptr; }
+
+        /// The underlying storage, to read into
+        /// @pre this is the only copy
+        auto buffer() -> beast::flat_buffer &;
+
+        auto data() const -> char const *;
+        auto size() const -> std::size_t;
+
+        auto bytes() const -> std::span< char const >
+        {
+            return { data(), size() };
+        }
+
+        auto view() const -> std::string_view { return { data(), size() }; }
+
+        /// The number of copies sharing this buffer
+        auto use_count() const -> std::size_t;
+
+      private:
+        friend struct detail::buffer_pool_impl;
+
+        explicit pooled_buffer(detail::pooled_block *block) noexcept
+        : block_(block)
+        {
+        }
+
+        detail::pooled_block *block_ = nullptr;
+    };
+
+    /// A thread-safe pool of receive buffers.
+    ///
+    /// Copies of a buffer_pool share one pool. The pool lives until it and
+    /// every buffer drawn from it have been destroyed.
+    class buffer_pool
+    {
+      public:
+        /// @param max_idle the most released buffers kept for reuse. Buffers
+        /// released beyond this are freed
+        /// @param max_idle_capacity the most storage a released buffer keeps.
+        /// A buffer which grew past this, for a large message, gives its
+        /// storage back rather than holding it while idle
+        explicit buffer_pool(std::size_t max_idle          = 64,
+                             std::size_t max_idle_capacity = 64 * 1024);
+
+        buffer_pool(buffer_pool const &other);
+        buffer_pool(buffer_pool &&other) noexcept;
+        buffer_pool &operator=(buffer_pool const &other);
+        buffer_pool &operator=(buffer_pool &&other) noexcept;
+        ~buffer_pool();
+
+        /// Take an empty buffer from the pool, or allocate one if none is
+        /// idle
+        auto acquire() -> pooled_buffer;
+
+        /// The number of released buffers waiting for reuse
+        auto idle() const -> std::size_t;
+
+      private:
+        boost::intrusive_ptr< detail::buffer_pool_impl > impl_;
+    };
+
+}   // namespace notstd::util
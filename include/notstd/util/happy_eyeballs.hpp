@@ -0,0 +1,31 @@
+#pragma once
+#include <chrono>
+#include <notstd/util/net.hpp>
+#include <vector>
+
+namespace notstd::util
+{
+    /// How connection attempts to the addresses of a host are raced, after
+    /// RFC 8305
+    struct happy_eyeballs_options
+    {
+        using duration = std::chrono::steady_clock::duration;
+
+        /// How long an attempt is given before the next address is also
+        /// tried. An attempt which fails starts the next one at once. Zero
+        /// tries every address together
+        duration attempt_delay = std::chrono::milliseconds(250);
+
+        /// How long a single attempt may take before it is abandoned with
+        /// net::error::timed_out. Zero leaves it to the operating system
+        duration attempt_timeout {};
+    };
+
+    /// The order in which to try endpoints: the resolver's order, but
+    /// alternating between address families, starting with the family of
+    /// the first endpoint. A host whose IPv6 addresses are unreachable then
+    /// costs at most one attempt_delay before IPv4 is tried, and vice versa
+    auto happy_eyeballs_order(std::vector< net::ip::tcp::endpoint > endpoints)
+        -> std::vector< net::ip::tcp::endpoint >;
+
+}   // namespace notstd::util
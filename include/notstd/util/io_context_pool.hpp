@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <notstd/util/net.hpp>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace notstd::util
+{
+    /// A set of single-threaded io_contexts, each run by its own thread, so
+    /// that work spread across them scales with cores while everything on
+    /// one context stays free of locks.
+    ///
+    /// The threads run until stop() is called or the pool is destroyed.
+    class io_context_pool
+    {
+      public:
+        using executor_type = net::io_context::executor_type;
+
+        /// @param size the number of contexts and threads. Zero for one per
+        /// hardware thread
+        explicit io_context_pool(std::size_t size = 0);
+
+        io_context_pool(io_context_pool const &) = delete;
+        io_context_pool &operator=(io_context_pool const &) = delete;
+
+        /// Stops and joins the threads
+        ~io_context_pool();
+
+        auto size() const -> std::size_t { return contexts_.size(); }
+
+        auto context(std::size_t i) -> net::io_context &
+        {
+            return *contexts_[i];
+        }
+
+        /// The executor of context i % size()
+        auto get_executor(std::size_t i) -> executor_type;
+
+        /// Let each thread exit once its context runs out of work
+        auto release() -> void;
+
+        /// Stop every context, abandoning any outstanding work, and join the
+        /// threads
+        /// @pre not called from one of the pool's threads
+        auto stop() -> void;
+
+        /// Wait for the threads to exit
+        /// @pre not called from one of the pool's threads
+        auto join() -> void;
+
+      private:
+        using work_guard = net::executor_work_guard< executor_type >;
+
+        std::vector< std::unique_ptr< net::io_context > > contexts_;
+        std::vector< std::optional< work_guard > >        work_;
+        std::vector< std::thread >                        threads_;
+    };
+
+}   // namespace notstd::util
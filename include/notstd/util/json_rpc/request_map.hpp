@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <notstd/util/async/executor_traits.hpp>
 #include <notstd/util/async/poly_handler.hpp>
 #include <notstd/util/json_rpc/remote_result.hpp>
 #include <unordered_map>
@@ -10,8 +11,11 @@ namespace notstd::util::json_rpc
     struct request_map
     {
       private:
-        using handler_type =
-            async::poly_handler< void(error_code, remote_result) >;
+        // sized to hold a coroutine awaiting the result without allocation
+        using handler_type = async::poly_handler_for<
+            void(error_code, remote_result),
+            async::executor_traits< net::any_io_executor >::
+                awaitable_handler< void(error_code, remote_result) > >;
 
         struct request_event
         {
@@ -51,8 +51,12 @@ namespace notstd::util::json_rpc
         // requests
         //
 
-        using call_handler =
-            util::async::poly_handler< void(error_code, remote_result) >;
+        using call_handler = util::async::poly_handler_for<
+            void(error_code, remote_result),
+            util::async::guarded_handler_t<
+                typename stream_state_impl::template awaitable_handler< void(
+                    error_code, remote_result) >,
+                executor_type > >;
 
         std::int64_t                                     request_id_;
         std::unordered_map< std::int64_t, call_handler > call_handlers_;
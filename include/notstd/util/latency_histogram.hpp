@@ -0,0 +1,58 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace notstd::util
+{
+    /// Counts durations in buckets whose bounds double, from 1us upwards.
+    /// Recording a sample costs a few instructions and no allocation, so it
+    /// may be done for every sample.
+    ///
+    /// Bucket 0 holds durations under 1us. Bucket i holds those from
+    /// 2^(i-1)us up to but excluding 2^i us, and the last bucket also holds
+    /// everything longer.
+    class latency_histogram
+    {
+      public:
+        using duration = std::chrono::steady_clock::duration;
+
+        static constexpr std::size_t bucket_count = 32;
+
+        auto record(duration d) -> void;
+
+        /// The number of samples recorded
+        auto count() const -> std::uint64_t { return count_; }
+
+        /// Zero if nothing has been recorded
+        auto min() const -> duration;
+        auto max() const -> duration { return max_; }
+        auto last() const -> duration { return last_; }
+        auto mean() const -> duration;
+
+        /// The upper bound of the bucket holding the q'th quantile, q in
+        /// [0, 1], limited to max(). Exact to within a factor of two
+        auto quantile(double q) const -> duration;
+
+        auto buckets() const
+            -> std::array< std::uint64_t, bucket_count > const &
+        {
+            return buckets_;
+        }
+
+        /// The least duration counted in bucket i
+        static auto bucket_floor(std::size_t i) -> duration;
+
+        auto reset() -> void;
+
+      private:
+        std::array< std::uint64_t, bucket_count > buckets_ {};
+        std::uint64_t                             count_ = 0;
+        duration                                  total_ {};
+        duration                                  min_ = duration::max();
+        duration                                  max_ {};
+        duration                                  last_ {};
+    };
+
+}   // namespace notstd::util
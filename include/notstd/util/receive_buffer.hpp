@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <limits>
+#include <notstd/util/beast.hpp>
+
+namespace notstd::util
+{
+    /// How a receive_buffer sizes its storage
+    struct receive_buffer_policy
+    {
+        /// The capacity reserved before the first read, and kept after
+        /// shrinking, so that small messages never reallocate
+        std::size_t initial_reserve = 4 * 1024;
+
+        /// The most bytes the buffer may hold
+        std::size_t max_size = std::numeric_limits< std::size_t >::max();
+
+        /// The buffer is shrunk back to initial_reserve after this many
+        /// consecutive messages have each used less than 1 / shrink_ratio of
+        /// its capacity. Zero disables shrinking
+        std::size_t shrink_after = 16;
+        std::size_t shrink_ratio = 4;
+    };
+
+    /// Memory counters of a receive_buffer
+    struct receive_buffer_stats
+    {
+        /// The bytes currently allocated
+        std::size_t capacity = 0;
+
+        /// The largest capacity the buffer has reached
+        std::size_t high_water = 0;
+
+        /// The number of messages which caused the buffer to grow
+        std::size_t grows = 0;
+
+        /// The number of times the buffer was shrunk by its policy
+        std::size_t shrinks = 0;
+    };
+
+    /// A flat buffer for reading whole messages which gives back memory
+    /// once a run of large messages has passed.
+    ///
+    /// Read into buffer(), then call consume_all() once the message has been
+    /// handled.
+    class receive_buffer
+    {
+      public:
+        explicit receive_buffer(receive_buffer_policy policy = {});
+
+        /// Takes effect from the next reserve()
+        auto set_policy(receive_buffer_policy policy) -> void;
+
+        auto policy() const -> receive_buffer_policy const & { return policy_; }
+
+        auto buffer() -> beast::flat_buffer & { return buffer_; }
+
+        /// Allocate the policy's initial reserve
+        auto reserve() -> void;
+
+        /// Discard the buffer's contents, shrinking it if the policy says so
+        auto consume_all() -> void;
+
+        /// Discard the buffer's contents and free its storage
+        auto release() -> void;
+
+        auto stats() const -> receive_buffer_stats;
+
+      private:
+        auto shrink() -> void;
+
+        receive_buffer_policy policy_;
+        beast::flat_buffer    buffer_;
+        receive_buffer_stats  stats_;
+        std::size_t           underused_ = 0;
+    };
+
+}   // namespace notstd::util
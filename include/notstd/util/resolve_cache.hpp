@@ -0,0 +1,158 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <notstd/util/net.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace notstd::util
+{
+    /// How long resolve_cache keeps the outcome of a lookup
+    struct resolve_cache_options
+    {
+        using duration = std::chrono::steady_clock::duration;
+
+        /// How long addresses are reused. getaddrinfo does not report the
+        /// TTL of the DNS records, so this applies to every host
+        duration ttl = std::chrono::seconds(60);
+
+        /// How long a failed lookup is reported again without retrying.
+        /// Zero does not cache failures
+        duration negative_ttl = std::chrono::seconds(5);
+
+        /// The most hosts held. Expired entries, then the oldest, make way
+        /// for new ones
+        std::size_t max_entries = 1024;
+    };
+
+    struct resolve_cache_stats
+    {
+        /// Lookups answered from the cache, including cached failures
+        std::size_t hits = 0;
+
+        /// Lookups which went to the resolver
+        std::size_t misses = 0;
+
+        /// Lookups which waited for an identical lookup already in flight
+        std::size_t coalesced = 0;
+    };
+
+    /// The outcome of a name lookup, as cached
+    struct resolve_result
+    {
+        using results_type = net::ip::basic_resolver_results< net::ip::tcp >;
+
+        error_code   error;
+        results_type results;
+    };
+
+    /// A cache of host and port lookups, shared between any number of
+    /// resolvers on any threads.
+    ///
+    /// A lookup which misses is made by one caller, the leader, while
+    /// callers asking for the same host and port in the meantime wait for
+    /// its outcome rather than making their own. This keeps a mass
+    /// reconnect to one host down to a single getaddrinfo call.
+    ///
+    /// The cache does not resolve anything itself. See
+    /// async::tcp_resolve_state_impl::set_cache.
+    class resolve_cache
+    {
+      public:
+        using clock_type = std::chrono::steady_clock;
+
+        /// Completes a waiting lookup. Called on the leader's thread, so
+        /// it must post to wherever the waiter runs
+        using waiter_type = std::function< void(resolve_result) >;
+
+        explicit resolve_cache(resolve_cache_options opts = {});
+
+        /// Look up host and port.
+        ///
+        /// On a hit, the cached outcome is returned. Otherwise, if an
+        /// identical lookup is in flight, waiter is called with its outcome.
+        /// Otherwise the caller becomes the leader: it must resolve the
+        /// host itself and pass the outcome to complete(). waiter is not
+        /// called for the leader
+        /// @param leader set to whether the caller is the leader
+        auto find(std::string_view host,
+                  std::string_view port,
+                  waiter_type      waiter,
+                  bool &           leader) -> std::optional< resolve_result >;
+
+        /// Store the leader's outcome and pass it to the waiters. An
+        /// outcome of net::error::operation_aborted is passed on but not
+        /// stored, so that a waiter may retry as the new leader
+        auto complete(std::string_view host,
+                      std::string_view port,
+                      resolve_result   result) -> void;
+
+        /// Held by a leader while it resolves. Completes the lookup with
+        /// net::error::operation_aborted unless complete() is called first,
+        /// so that waiters are released, and the host may be looked up
+        /// again, even if the leader is destroyed mid lookup
+        class leader_guard
+        {
+          public:
+            leader_guard(resolve_cache &  cache,
+                         std::string_view host,
+                         std::string_view port);
+
+            leader_guard(leader_guard const &) = delete;
+            leader_guard &operator=(leader_guard const &) = delete;
+
+            ~leader_guard();
+
+            /// As resolve_cache::complete. The destructor then does nothing
+            auto complete(resolve_result result) -> void;
+
+          private:
+            resolve_cache *cache_;
+            std::string    host_;
+            std::string    port_;
+        };
+
+        /// Forget the outcome for host and port, e.g. after its addresses
+        /// failed to connect. A lookup in flight is unaffected
+        auto invalidate(std::string_view host, std::string_view port) -> void;
+
+        /// Forget every outcome
+        auto invalidate_all() -> void;
+
+        auto stats() const -> resolve_cache_stats;
+
+        auto options() const -> resolve_cache_options const &
+        {
+            return options_;
+        }
+
+      private:
+        struct entry
+        {
+            std::optional< resolve_result > result;
+            clock_type::time_point          expires;
+            clock_type::time_point          stored;
+
+            // set while a leader is resolving
+            bool                       in_flight = false;
+            std::vector< waiter_type > waiters;
+        };
+
+        static auto key(std::string_view host, std::string_view port)
+            -> std::string;
+
+        // make room for one more entry
+        auto evict(clock_type::time_point now) -> void;
+
+        resolve_cache_options                    options_;
+        mutable std::mutex                       mutex_;
+        std::unordered_map< std::string, entry > entries_;
+        resolve_cache_stats                      stats_;
+    };
+
+}   // namespace notstd::util
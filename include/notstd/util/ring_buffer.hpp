@@ -0,0 +1,335 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace notstd::util
+{
+    /// A FIFO sequence container stored in a single contiguous, power-of-two
+    /// sized ring.
+    ///
+    /// Unlike std::deque, which allocates and frees fixed size chunks as the
+    /// sequence oscillates, a ring_buffer only allocates when it grows beyond
+    /// its current capacity, and never releases capacity until destroyed. A
+    /// queue which has reached its high-water mark therefore pushes and pops
+    /// without touching the heap.
+    ///
+    /// Provides the subset of the sequence container interface needed by
+    /// std::queue, so may be used as its underlying container.
+    /// @tparam T the element type
+    /// @tparam Allocator the allocator used for the ring storage
+    template < class T, class Allocator = std::allocator< T > >
+    class ring_buffer
+    {
+        using alloc_traits = std::allocator_traits< Allocator >;
+
+        template < bool Const >
+        class basic_iterator;
+
+      public:
+        using value_type      = T;
+        using allocator_type  = Allocator;
+        using size_type       = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference       = T &;
+        using const_reference = T const &;
+        using iterator        = basic_iterator< false >;
+        using const_iterator  = basic_iterator< true >;
+
+        /// The capacity allocated by the first push into an empty ring_buffer
+        static constexpr size_type initial_capacity = 16;
+
+        ring_buffer() noexcept(noexcept(Allocator()))
+        : ring_buffer(Allocator())
+        {
+        }
+
+        explicit ring_buffer(Allocator const &alloc) noexcept
+        : alloc_(alloc)
+        {
+        }
+
+        ring_buffer(ring_buffer const &other);
+        ring_buffer(ring_buffer &&other) noexcept;
+
+        /// The allocator is propagated along with the elements
+        ring_buffer &operator=(ring_buffer const &other);
+        ring_buffer &operator=(ring_buffer &&other) noexcept;
+
+        ~ring_buffer();
+
+        auto get_allocator() const -> allocator_type { return alloc_; }
+
+        auto empty() const noexcept -> bool { return size_ == 0; }
+        auto size() const noexcept -> size_type { return size_; }
+        auto capacity() const noexcept -> size_type { return capacity_; }
+
+        /// Ensure that at least n elements may be held without allocation
+        auto reserve(size_type n) -> void;
+
+        /// Destroy all elements. Capacity is retained
+        auto clear() noexcept -> void;
+
+        auto front() -> reference { return data_[head_]; }
+        auto front() const -> const_reference { return data_[head_]; }
+        auto back() -> reference { return data_[index(size_ - 1)]; }
+        auto back() const -> const_reference { return data_[index(size_ - 1)]; }
+
+        auto push_back(T const &x) -> void { emplace_back(x); }
+        auto push_back(T &&x) -> void { emplace_back(std::move(x)); }
+
+        template < class... Args >
+        auto emplace_back(Args &&... args) -> reference;
+
+        auto pop_front() -> void;
+
+        auto begin() noexcept -> iterator { return { this, 0 }; }
+        auto end() noexcept -> iterator { return { this, size_ }; }
+        auto begin() const noexcept -> const_iterator { return { this, 0 }; }
+        auto end() const noexcept -> const_iterator { return { this, size_ }; }
+
+        auto swap(ring_buffer &other) noexcept -> void;
+
+        friend auto swap(ring_buffer &l, ring_buffer &r) noexcept -> void
+        {
+            l.swap(r);
+        }
+
+      private:
+        // position in storage of the element at logical position i
+        auto index(size_type i) const noexcept -> size_type
+        {
+            return (head_ + i) & (capacity_ - 1);
+        }
+
+        // reallocate with at least min_capacity slots, preserving order
+        auto grow(size_type min_capacity) -> void;
+
+        // destroy the elements and release the storage
+        auto release() noexcept -> void;
+
+        template < bool Const >
+        class basic_iterator
+        {
+            using owner_type =
+                std::conditional_t< Const, ring_buffer const, ring_buffer >;
+
+          public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+            using pointer   = std::conditional_t< Const, T const *, T * >;
+            using reference = std::conditional_t< Const, T const &, T & >;
+
+            basic_iterator() = default;
+
+            basic_iterator(owner_type *owner, size_type pos)
+            : owner_(owner)
+            , pos_(pos)
+            {
+            }
+
+            operator basic_iterator< true >() const { return { owner_, pos_ }; }
+
+            auto operator*() const -> reference
+            {
+                return owner_->data_[owner_->index(pos_)];
+            }
+
+            auto operator->() const -> pointer
+            {
+                return std::addressof(**this);
+            }
+
+            auto operator++() -> basic_iterator &
+            {
+                ++pos_;
+                return *this;
+            }
+
+            auto operator++(int) -> basic_iterator
+            {
+                auto tmp = *this;
+                ++pos_;
+                return tmp;
+            }
+
+            friend bool operator==(basic_iterator const &l,
+                                   basic_iterator const &r)
+            {
+                return l.pos_ == r.pos_;
+            }
+
+            friend bool operator!=(basic_iterator const &l,
+                                   basic_iterator const &r)
+            {
+                return not(l == r);
+            }
+
+          private:
+            owner_type *owner_ = nullptr;
+            size_type   pos_   = 0;
+        };
+
+      private:
+        T *       data_     = nullptr;
+        size_type capacity_ = 0;   // zero or a power of two
+        size_type head_     = 0;
+        size_type size_     = 0;
+        [[no_unique_address]] Allocator alloc_;
+    };
+
+}   // namespace notstd::util
+
+namespace notstd::util
+{
+    template < class T, class Allocator >
+    ring_buffer< T, Allocator >::ring_buffer(ring_buffer const &other)
+    : alloc_(alloc_traits::select_on_container_copy_construction(
+          other.alloc_))
+    {
+        reserve(other.size_);
+        for (auto &x : other)
+            emplace_back(x);
+    }
+
+    template < class T, class Allocator >
+    ring_buffer< T, Allocator >::ring_buffer(ring_buffer &&other) noexcept
+    : data_(std::exchange(other.data_, nullptr))
+    , capacity_(std::exchange(other.capacity_, 0))
+    , head_(std::exchange(other.head_, 0))
+    , size_(std::exchange(other.size_, 0))
+    , alloc_(std::move(other.alloc_))
+    {
+    }
+
+    template < class T, class Allocator >
+    auto ring_buffer< T, Allocator >::operator=(ring_buffer const &other)
+        -> ring_buffer &
+    {
+        if (this != &other)
+        {
+            auto tmp = ring_buffer(other);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    template < class T, class Allocator >
+    auto ring_buffer< T, Allocator >::operator=(ring_buffer &&other) noexcept
+        -> ring_buffer &
+    {
+        auto tmp = ring_buffer(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+
+    template < class T, class Allocator >
+    ring_buffer< T, Allocator >::~ring_buffer()
+    {
+        release();
+    }
+
+    template < class T, class Allocator >
+    auto ring_buffer< T, Allocator >::reserve(size_type n) -> void
+    {
+        if (n > capacity_)
+            grow(n);
+    }
+
+    template < class T, class Allocator >
+    auto ring_buffer< T, Allocator >::clear() noexcept -> void
+    {
+        while (size_)
+            pop_front();
+        head_ = 0;
+    }
+
+    template < class T, class Allocator >
+    template < class... Args >
+    auto ring_buffer< T, Allocator >::emplace_back(Args &&... args)
+        -> reference
+    {
+        if (size_ == capacity_)
+        {
+            // args may refer to an element of this buffer, so construct the
+            // new element before the storage moves
+            auto x = T(std::forward< Args >(args)...);
+            grow(capacity_ ? capacity_ * 2 : initial_capacity);
+            alloc_traits::construct(alloc_, data_ + index(size_), std::move(x));
+        }
+        else
+        {
+            alloc_traits::construct(
+                alloc_, data_ + index(size_), std::forward< Args >(args)...);
+        }
+        ++size_;
+        return back();
+    }
+
+    template < class T, class Allocator >
+    auto ring_buffer< T, Allocator >::pop_front() -> void
+    {
+        assert(size_);
+        alloc_traits::destroy(alloc_, data_ + head_);
+        head_ = index(1);
+        --size_;
+    }
+
+    template < class T, class Allocator >
+    auto ring_buffer< T, Allocator >::swap(ring_buffer &other) noexcept -> void
+    {
+        using std::swap;
+        swap(data_, other.data_);
+        swap(capacity_, other.capacity_);
+        swap(head_, other.head_);
+        swap(size_, other.size_);
+        swap(alloc_, other.alloc_);
+    }
+
+    template < class T, class Allocator >
+    auto ring_buffer< T, Allocator >::grow(size_type min_capacity) -> void
+    {
+        auto cap = capacity_ ? capacity_ : initial_capacity;
+        while (cap < min_capacity)
+            cap *= 2;
+
+        auto data = alloc_traits::allocate(alloc_, cap);
+        auto n    = size_type(0);
+        try
+        {
+            for (; n < size_; ++n)
+                alloc_traits::construct(
+                    alloc_, data + n, std::move_if_noexcept(data_[index(n)]));
+        }
+        catch (...)
+        {
+            while (n)
+                alloc_traits::destroy(alloc_, data + --n);
+            alloc_traits::deallocate(alloc_, data, cap);
+            throw;
+        }
+
+        auto size = size_;
+        release();
+        data_     = data;
+        capacity_ = cap;
+        head_     = 0;
+        size_     = size;
+    }
+
+    template < class T, class Allocator >
+    auto ring_buffer< T, Allocator >::release() noexcept -> void
+    {
+        if (not data_)
+            return;
+        clear();
+        alloc_traits::deallocate(alloc_, data_, capacity_);
+        data_     = nullptr;
+        capacity_ = 0;
+    }
+
+}   // namespace notstd::util
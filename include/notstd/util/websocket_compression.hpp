@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <notstd/util/websocket.hpp>
+
+namespace notstd::util
+{
+    /// Settings of the websocket permessage-deflate extension, which take
+    /// effect if the peer agrees to them during the handshake
+    struct compression_options
+    {
+        /// Offer the extension
+        bool enable = false;
+
+        /// log2 of the compression window, 9..15. A smaller window needs
+        /// less memory per connection but finds fewer repeats
+        int window_bits = 15;
+
+        /// zlib memory level, 1..9. Higher levels are faster and compress
+        /// better but need more memory
+        int memory_level = 4;
+
+        /// Deflate level, 0..9. Higher levels compress better at greater CPU
+        /// cost
+        int level = 8;
+
+        /// Messages shorter than this are sent uncompressed. Honoured only
+        /// by versions of Beast with permessage_deflate::msg_size_threshold
+        std::size_t threshold = 0;
+
+        /// Keep the compression window between messages. This compresses
+        /// streams of similar messages far better, but holds the window for
+        /// the life of the connection
+        bool context_takeover = true;
+    };
+
+    /// The Beast option which offers the given settings in either role
+    auto to_permessage_deflate(compression_options const &opts)
+        -> websocket::permessage_deflate;
+
+}   // namespace notstd::util
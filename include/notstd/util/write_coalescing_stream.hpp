@@ -0,0 +1,254 @@
+#pragma once
+#include <notstd/util/beast.hpp>
+#include <notstd/util/net.hpp>
+#include <notstd/util/print.hpp>
+#include <notstd/util/websocket.hpp>
+#include <utility>
+#include <vector>
+
+namespace notstd::util
+{
+    /// A stream layer which can hold back writes, so that several messages
+    /// from the layer above reach the next layer in a single write.
+    ///
+    /// While corked, async_write_some copies the data into an internal buffer
+    /// and completes as if by post. The first write made after uncork(), or
+    /// which would take the held bytes over the cork limit, sends the held
+    /// bytes together with its own in one gather write.
+    ///
+    /// Between a websocket stream and its transport, this turns a burst of
+    /// small messages into one syscall and, over TLS, into full records
+    /// rather than one record per message.
+    ///
+    /// A write which starts with a websocket control frame (ping, pong or
+    /// close) is never held: it goes out at once, behind anything already
+    /// held, so that a close or pong is not delayed by the cork. Part of a
+    /// data frame may happen to start with the same byte, which costs no
+    /// more than an early flush.
+    ///
+    /// Once a write carrying held bytes fails, the held bytes are kept, for
+    /// pending() to report, and every later write fails with the same error.
+    /// @note like any stream, at most one write may be outstanding
+    template < class NextLayer >
+    class write_coalescing_stream
+    {
+      public:
+        using next_layer_type = NextLayer;
+        using executor_type   = typename NextLayer::executor_type;
+
+        template < class... Args >
+        explicit write_coalescing_stream(Args &&... args)
+        : next_layer_(std::forward< Args >(args)...)
+        {
+        }
+
+        auto get_executor() -> executor_type
+        {
+            return next_layer_.get_executor();
+        }
+
+        auto next_layer() -> next_layer_type & { return next_layer_; }
+        auto next_layer() const -> next_layer_type const &
+        {
+            return next_layer_;
+        }
+
+        /// Hold back subsequent writes until uncork(), or until holding a
+        /// write would take the held bytes over max_bytes
+        auto cork(std::size_t max_bytes) -> void
+        {
+            corked_      = true;
+            max_pending_ = max_bytes;
+        }
+
+        /// The next write sends everything held back
+        auto uncork() -> void { corked_ = false; }
+
+        auto corked() const -> bool { return corked_; }
+
+        /// The number of bytes held back and not yet sent
+        auto pending() const -> std::size_t { return pending_.size(); }
+
+        /// Drop everything held back, e.g. once the stream has failed
+        auto discard() -> void { pending_.clear(); }
+
+        template < class MutableBufferSequence,
+                   BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code,
+                                                        std::size_t))
+                       ReadHandler >
+        auto async_read_some(MutableBufferSequence const &buffers,
+                             ReadHandler &&               token)
+            -> BOOST_ASIO_INITFN_RESULT_TYPE(ReadHandler,
+                                             void(error_code, std::size_t))
+        {
+            return next_layer_.async_read_some(
+                buffers, std::forward< ReadHandler >(token));
+        }
+
+        template < class ConstBufferSequence,
+                   BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code,
+                                                        std::size_t))
+                       WriteHandler >
+        auto async_write_some(ConstBufferSequence const &buffers,
+                              WriteHandler &&            token)
+            -> BOOST_ASIO_INITFN_RESULT_TYPE(WriteHandler,
+                                             void(error_code, std::size_t));
+
+      private:
+        template < class ConstBufferSequence >
+        struct flush_op;
+
+        // whether buffers start with the header of a websocket ping, pong
+        // or close frame
+        template < class ConstBufferSequence >
+        static auto is_control_frame(ConstBufferSequence const &buffers)
+            -> bool;
+
+        NextLayer           next_layer_;
+        std::vector< char > pending_;
+        std::size_t         max_pending_ = 0;
+        bool                corked_      = false;
+        error_code          error_;
+    };
+
+    /// Websocket teardown of the coalescing layer is teardown of the layer
+    /// beneath it
+    template < class NextLayer >
+    void teardown(beast::role_type                        role,
+                  write_coalescing_stream< NextLayer > &stream,
+                  error_code &                            ec)
+    {
+        using websocket::teardown;
+        teardown(role, stream.next_layer(), ec);
+    }
+
+    template < class NextLayer, class TeardownHandler >
+    void async_teardown(beast::role_type                        role,
+                        write_coalescing_stream< NextLayer > &stream,
+                        TeardownHandler &&                      handler)
+    {
+        using websocket::async_teardown;
+        async_teardown(role,
+                       stream.next_layer(),
+                       std::forward< TeardownHandler >(handler));
+    }
+
+    template < class NextLayer >
+    struct print_wrapper< write_coalescing_stream< NextLayer > >
+    {
+        write_coalescing_stream< NextLayer > const &arg;
+
+        friend auto operator<<(std::ostream &os, print_wrapper const &wrap)
+            -> std::ostream &
+        {
+            return os << print(wrap.arg.next_layer());
+        }
+    };
+}   // namespace notstd::util
+
+namespace notstd::util
+{
+    template < class NextLayer >
+    template < class ConstBufferSequence >
+    struct write_coalescing_stream< NextLayer >::flush_op
+    {
+        write_coalescing_stream &stream_;
+        ConstBufferSequence      buffers_;
+        bool                     started_ = false;
+
+        template < class Self >
+        void operator()(Self &self, error_code ec = {}, std::size_t n = 0)
+        {
+            if (not std::exchange(started_, true))
+                return net::async_write(
+                    stream_.next_layer_,
+                    beast::buffers_cat(net::buffer(stream_.pending_), buffers_),
+                    std::move(self));
+
+            // report only the caller's own bytes as written
+            auto held = stream_.pending_.size();
+            if (ec)
+                stream_.error_ = ec;
+            else
+                stream_.pending_.clear();
+            self.complete(ec, n > held ? n - held : 0);
+        }
+    };
+
+    template < class NextLayer >
+    template < class ConstBufferSequence >
+    auto write_coalescing_stream< NextLayer >::is_control_frame(
+        ConstBufferSequence const &buffers) -> bool
+    {
+        auto first = net::buffer_sequence_begin(buffers);
+        auto last  = net::buffer_sequence_end(buffers);
+        for (; first != last; ++first)
+        {
+            auto b = net::const_buffer(*first);
+            if (b.size() == 0)
+                continue;
+
+            // FIN with opcode close (0x8), ping (0x9) or pong (0xA)
+            auto byte = *static_cast< unsigned char const * >(b.data());
+            return byte >= 0x88 and byte <= 0x8a;
+        }
+        return false;
+    }
+
+    template < class NextLayer >
+    template < class ConstBufferSequence,
+               BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, std::size_t))
+                   WriteHandler >
+    auto write_coalescing_stream< NextLayer >::async_write_some(
+        ConstBufferSequence const &buffers,
+        WriteHandler &&            token)
+        -> BOOST_ASIO_INITFN_RESULT_TYPE(WriteHandler,
+                                         void(error_code, std::size_t))
+    {
+        auto n = net::buffer_size(buffers);
+
+        if (error_)
+        {
+            auto initiate = [this](auto &&handler) {
+                auto exec =
+                    net::get_associated_executor(handler, get_executor());
+                net::post(exec,
+                          beast::bind_front_handler(
+                              std::move(handler), error_, std::size_t(0)));
+            };
+            return net::async_initiate< WriteHandler,
+                                        void(error_code, std::size_t) >(
+                initiate, token);
+        }
+
+        if (corked_ and pending_.size() + n <= max_pending_ and
+            not is_control_frame(buffers))
+        {
+            auto initiate = [this, n](auto &&                     handler,
+                                      ConstBufferSequence const &buffers) {
+                auto first = pending_.size();
+                pending_.resize(first + n);
+                net::buffer_copy(net::buffer(pending_.data() + first, n),
+                                 buffers);
+                auto exec =
+                    net::get_associated_executor(handler, get_executor());
+                net::post(exec,
+                          beast::bind_front_handler(
+                              std::move(handler), error_code(), n));
+            };
+            return net::async_initiate< WriteHandler,
+                                        void(error_code, std::size_t) >(
+                initiate, token, buffers);
+        }
+
+        if (pending_.empty())
+            return next_layer_.async_write_some(
+                buffers, std::forward< WriteHandler >(token));
+
+        return net::async_compose< WriteHandler,
+                                   void(error_code, std::size_t) >(
+            flush_op< ConstBufferSequence > { *this, buffers },
+            token,
+            next_layer_);
+    }
+}   // namespace notstd::util
@@ -0,0 +1,70 @@
+#include "testing/allocation_counter.hpp"
+
+#include <benchmark/benchmark.h>
+#include <notstd/util/async/async_join_impl.hpp>
+
+using namespace notstd::util;
+using namespace notstd::util::async;
+using notstd::util::testing::allocation_counter;
+
+namespace
+{
+    using executor = net::io_context::executor_type;
+
+    struct event_a
+    {
+    };
+    struct event_b
+    {
+    };
+
+    // wait on a join of two events, then set both. The join is one-shot, so
+    // construction is part of the measurement. A concurrency hint of 1
+    // selects the unsynchronised state, any other the atomic one
+    template < int ConcurrencyHint >
+    void async_join_impl_wait_set(benchmark::State &state)
+    {
+        auto ioc   = net::io_context(ConcurrencyHint);
+        auto count = 0;
+
+        auto counter = allocation_counter(state);
+        for (auto _ : state)
+        {
+            auto join = async_join_impl< executor, event_a, event_b >(
+                ioc.get_executor());
+            join.async_wait([&](error_code) { ++count; });
+            join.set_event(event_a());
+            join.set_event(event_b());
+            ioc.restart();
+            ioc.poll();
+        }
+        benchmark::DoNotOptimize(count);
+    }
+
+    template < int ConcurrencyHint >
+    void async_event_wait_set(benchmark::State &state)
+    {
+        auto ioc   = net::io_context(ConcurrencyHint);
+        auto count = 0;
+
+        auto counter = allocation_counter(state);
+        for (auto _ : state)
+        {
+            auto event = async_event< executor >(ioc.get_executor());
+            event.async_wait([&](error_code) { ++count; });
+            event.set_event();
+            ioc.restart();
+            ioc.poll();
+        }
+        benchmark::DoNotOptimize(count);
+    }
+}   // namespace
+
+BENCHMARK_TEMPLATE(async_join_impl_wait_set, 1)
+    ->Name("async_join_impl/wait_set/single_threaded");
+BENCHMARK_TEMPLATE(async_join_impl_wait_set, 2)
+    ->Name("async_join_impl/wait_set/multi_threaded");
+BENCHMARK_TEMPLATE(async_event_wait_set, 1)
+    ->Name("async_event/wait_set/single_threaded");
+BENCHMARK_TEMPLATE(async_event_wait_set, 2)
+    ->Name("async_event/wait_set/multi_threaded");
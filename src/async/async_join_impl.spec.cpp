@@ -1,5 +1,6 @@
 #include <catch2/catch.hpp>
 #include <notstd/util/async/async_join_impl.hpp>
+#include <thread>
 
 using namespace notstd::util;
 
@@ -88,4 +89,144 @@ TEST_CASE("notstd::util::async::join_impl")
             }
         }
     }
-}
\ No newline at end of file
+}
+TEST_CASE("notstd::util::async::join_impl single threaded")
+{
+    struct event_a
+    {
+        int value;
+    };
+    struct event_b
+    {
+    };
+
+    auto ioc    = net::io_context(1);
+    auto strand = net::make_strand(ioc.get_executor());
+    CHECK(async::executor_traits< decltype(strand) >::is_single_threaded(
+        strand));
+    CHECK(async::executor_traits< net::io_context::executor_type >::
+              is_single_threaded(ioc.get_executor()));
+
+    auto multi = net::io_context();
+    CHECK(not async::executor_traits< net::io_context::executor_type >::
+              is_single_threaded(multi.get_executor()));
+
+    auto impl =
+        async::async_join_impl< decltype(strand), event_a, event_b >(strand);
+    auto ec_    = error_code(net::error::would_block);
+    auto events = 0;
+
+    SECTION("events set before the wait")
+    {
+        impl.set_event(event_a { 42 });
+        impl.set_event(event_b());
+        CHECK(impl.triggered());
+        impl.async_wait([&](error_code ec) {
+            ec_    = ec;
+            events = std::get< 0 >(impl.events()).value;
+        });
+        CHECK(ioc.run() == 1);
+        CHECK(not ec_);
+        CHECK(events == 42);
+    }
+
+    SECTION("unset event")
+    {
+        impl.set_event(event_a { 1 });
+        impl.unset_event< event_a >();
+        impl.set_event(event_b());
+        CHECK(not impl.triggered());
+        impl.async_wait([&](error_code ec) { ec_ = ec; });
+        CHECK(ioc.poll() == 0);
+        impl.set_event(event_a { 2 });
+        CHECK(ioc.run() == 1);
+        CHECK(not ec_);
+        CHECK(std::get< 0 >(impl.events()).value == 2);
+    }
+
+    SECTION("cancel before the wait")
+    {
+        impl.cancel(net::error::connection_reset);
+        impl.cancel();
+        impl.async_wait([&](error_code ec) { ec_ = ec; });
+        CHECK(ioc.run() == 1);
+        CHECK(ec_ == net::error::connection_reset);
+    }
+}
+
+TEST_CASE("notstd::util::async::async_event")
+{
+    auto ioc   = net::io_context(1);
+    auto event = async::async_event< net::io_context::executor_type >(
+        ioc.get_executor());
+    auto ec_ = error_code(net::error::would_block);
+
+    SECTION("set while waiting")
+    {
+        event.async_wait([&](error_code ec) { ec_ = ec; });
+        CHECK(ioc.poll() == 0);
+        CHECK(not ioc.stopped());
+        event.set_event();
+        CHECK(ioc.run() == 1);
+        CHECK(not ec_);
+    }
+
+    SECTION("set before waiting")
+    {
+        event.set_event();
+        event.async_wait([&](error_code ec) { ec_ = ec; });
+        CHECK(ioc.run() == 1);
+        CHECK(not ec_);
+    }
+
+    SECTION("cancel while waiting")
+    {
+        event.async_wait([&](error_code ec) { ec_ = ec; });
+        event.cancel();
+        CHECK(ioc.run() == 1);
+        CHECK(ec_ == net::error::operation_aborted);
+
+        event.async_wait([&](error_code ec) { ec_ = ec; });
+        ioc.restart();
+        CHECK(ioc.run() == 1);
+        CHECK(ec_ == net::error::operation_aborted);
+    }
+}
+
+TEST_CASE("notstd::util::async::join_impl multi threaded")
+{
+    struct event_a
+    {
+    };
+    struct event_b
+    {
+    };
+
+    constexpr int rounds = 2000;
+
+    auto ioc       = net::io_context();
+    auto completed = std::atomic< int >(0);
+    auto failed    = std::atomic< int >(0);
+
+    for (int i = 0; i < rounds; ++i)
+    {
+        auto impl = async::async_join_impl< net::io_context::executor_type,
+                                            event_a,
+                                            event_b >(ioc.get_executor());
+        auto t1   = std::thread([&] { impl.set_event(event_a()); });
+        auto t2   = std::thread([&] {
+            if (i % 4 == 0)
+                impl.cancel();
+            else
+                impl.set_event(event_b());
+        });
+        impl.async_wait([&](error_code ec) { ++(ec ? failed : completed); });
+        t1.join();
+        t2.join();
+        ioc.restart();
+        CHECK(ioc.run() == 1);
+    }
+
+    CHECK(failed == rounds / 4);
+    CHECK(completed + failed == rounds);
+}
@@ -0,0 +1,183 @@
+#include "testing/allocation_counter.hpp"
+
+#include <benchmark/benchmark.h>
+#include <notstd/util/async/async_queue.hpp>
+#include <thread>
+#include <vector>
+
+using namespace notstd::util;
+using namespace notstd::util::async;
+using notstd::util::testing::allocation_counter;
+
+namespace
+{
+    constexpr std::size_t messages_per_iteration = 1 << 16;
+
+    // a consumer which pops exactly `remaining` values from the queue, then
+    // stops
+    template < class Queue >
+    struct consumer
+    {
+        void start()
+        {
+            queue_.async_pop([this](error_code ec, int) {
+                if (ec or --remaining_ == 0)
+                    return;
+                start();
+            });
+        }
+
+        Queue &     queue_;
+        std::size_t remaining_;
+    };
+
+    // state.range(0) producer threads push into one queue, drained by a
+    // single consumer running on the benchmark thread
+    template < class Queue >
+    void async_queue_throughput(benchmark::State &state)
+    {
+        auto const producers = std::size_t(state.range(0));
+        auto const per_producer = messages_per_iteration / producers;
+
+        auto ioc = net::io_context(1);
+        for (auto _ : state)
+        {
+            auto queue = Queue(ioc.get_executor());
+            auto c     = consumer< Queue > { queue, per_producer * producers };
+            c.start();
+
+            auto threads = std::vector< std::thread >();
+            for (std::size_t p = 0; p < producers; ++p)
+                threads.emplace_back([&] {
+                    for (std::size_t i = 0; i < per_producer; ++i)
+                        queue.push(int(i));
+                });
+
+            ioc.run();
+            ioc.restart();
+            for (auto &t : threads)
+                t.join();
+        }
+        state.SetItemsProcessed(state.iterations() * per_producer * producers);
+    }
+
+    // drain a burst of queued values, one completion per value or one per
+    // state.range(0) values
+    template < class Queue >
+    void async_queue_drain(benchmark::State &state)
+    {
+        auto const batch = std::size_t(state.range(0));
+
+        auto ioc = net::io_context(1);
+        auto q   = Queue(ioc.get_executor());
+        for (auto _ : state)
+        {
+            for (std::size_t i = 0; i < messages_per_iteration; ++i)
+                q.push(int(i));
+
+            auto remaining = messages_per_iteration;
+            auto pop_one   = [&](auto &self) -> void {
+                q.async_pop([&](error_code, int) {
+                    if (--remaining)
+                        self(self);
+                });
+            };
+            auto pop_some = [&](auto &self) -> void {
+                q.async_pop_some(batch,
+                                 [&](error_code, std::vector< int > vs) {
+                                     remaining -= vs.size();
+                                     if (remaining)
+                                         self(self);
+                                 });
+            };
+
+            if (batch == 1)
+                pop_one(pop_one);
+            else
+                pop_some(pop_some);
+            ioc.run();
+            ioc.restart();
+        }
+        state.SetItemsProcessed(state.iterations() * messages_per_iteration);
+    }
+
+    // one push and one pop per iteration. If CrossExecutor, the consumer's
+    // handler is bound to a second io_context, as when a coroutine on one
+    // thread consumes a queue owned by another
+    template < class Queue, bool CrossExecutor >
+    void async_queue_round_trip(benchmark::State &state)
+    {
+        auto ioc      = net::io_context(1);
+        auto consumer = net::io_context(1);
+        auto q        = Queue(ioc.get_executor());
+        auto sum      = 0;
+        auto handler  = [&](error_code, int v) { sum += v; };
+
+        auto counter = allocation_counter(state);
+        for (auto _ : state)
+        {
+            q.push(1);
+            if constexpr (CrossExecutor)
+            {
+                q.async_pop(net::bind_executor(consumer, handler));
+                ioc.restart();
+                ioc.poll();
+                consumer.restart();
+                consumer.poll();
+            }
+            else
+            {
+                q.async_pop(handler);
+                ioc.restart();
+                ioc.poll();
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+
+    using executor = net::io_context::executor_type;
+
+    BENCHMARK_TEMPLATE(async_queue_round_trip,
+                       basic_async_queue< int, executor >,
+                       false)
+        ->Name("async_queue/round_trip");
+    BENCHMARK_TEMPLATE(async_queue_round_trip,
+                       basic_async_queue< int, executor >,
+                       true)
+        ->Name("async_queue/round_trip/cross_executor");
+    BENCHMARK_TEMPLATE(async_queue_round_trip,
+                       basic_mpsc_async_queue< int, executor >,
+                       false)
+        ->Name("mpsc_async_queue/round_trip");
+    BENCHMARK_TEMPLATE(async_queue_round_trip,
+                       basic_mpsc_async_queue< int, executor >,
+                       true)
+        ->Name("mpsc_async_queue/round_trip/cross_executor");
+
+    BENCHMARK_TEMPLATE(async_queue_throughput,
+                       basic_async_queue< int, executor >)
+        ->Name("async_queue/throughput")
+        ->Arg(1)
+        ->Arg(4)
+        ->Arg(16)
+        ->UseRealTime();
+
+    BENCHMARK_TEMPLATE(async_queue_throughput,
+                       basic_mpsc_async_queue< int, executor >)
+        ->Name("mpsc_async_queue/throughput")
+        ->Arg(1)
+        ->Arg(4)
+        ->Arg(16)
+        ->UseRealTime();
+
+    BENCHMARK_TEMPLATE(async_queue_drain, basic_async_queue< int, executor >)
+        ->Name("async_queue/drain")
+        ->Arg(1)
+        ->Arg(64);
+
+    BENCHMARK_TEMPLATE(async_queue_drain,
+                       basic_mpsc_async_queue< int, executor >)
+        ->Name("mpsc_async_queue/drain")
+        ->Arg(1)
+        ->Arg(64);
+}   // namespace
@@ -128,5 +128,37 @@ TEST_CASE("notstd::util::async::async_queue",
             CHECK(error.message() == "Operation canceled");
             CHECK(value == "");
         }
+
+        SECTION("pop some")
+        {
+            auto values = std::vector< std::string >();
+            auto pop_some = [&](std::size_t max) {
+                q.async_pop_some(
+                    max, [&](error_code ec, std::vector< std::string > vs) {
+                        error  = ec;
+                        values = std::move(vs);
+                    });
+            };
+
+            q.push_range({ "a", "b", "c" });
+            q.push("d");
+            CHECK(poll(ioc) == 2);
+
+            pop_some(3);
+            CHECK(poll(ioc) == 1);
+            CHECK(error.message() == "Success");
+            CHECK(values == std::vector< std::string > { "a", "b", "c" });
+
+            pop_some(3);
+            CHECK(poll(ioc) == 1);
+            CHECK(values == std::vector< std::string > { "d" });
+
+            pop_some(3);
+            CHECK(poll(ioc) == 1);
+            q.stop();
+            CHECK(poll(ioc) == 1);
+            CHECK(error.message() == "Operation canceled");
+            CHECK(values.empty());
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include <catch2/catch.hpp>
+#include <notstd/util/async/bounded_async_queue.hpp>
+
+using namespace notstd::util;
+using namespace notstd::util::async;
+
+TEST_CASE("notstd::util::async::bounded_async_queue",
+          "[notstd::util::async::bounded_async_queue]")
+{
+    auto ioc = net::io_context(1);
+    auto e   = ioc.get_executor();
+    using queue_type = basic_bounded_async_queue< std::string, decltype(e) >;
+
+    auto poll = [](net::io_context &ioc) {
+        if (ioc.stopped())
+            ioc.restart();
+        auto s = ioc.poll();
+        return s;
+    };
+
+    error_code  pop_error;
+    std::string value;
+    auto        pop = [&](queue_type &q) {
+        q.async_pop([&](error_code ec, std::string s) {
+            pop_error = ec;
+            value     = s;
+        });
+    };
+
+    SECTION("block")
+    {
+        auto q = queue_type(e, 2);
+        CHECK(q.try_push("a"));
+        CHECK(q.try_push("b"));
+        CHECK(not q.try_push("c"));
+
+        auto pushed     = false;
+        auto push_error = error_code();
+        q.async_push("d", [&](error_code ec) {
+            pushed     = true;
+            push_error = ec;
+        });
+        CHECK(poll(ioc) == 0);
+        CHECK(not pushed);
+
+        pop(q);
+        CHECK(poll(ioc) == 2);
+        CHECK(value == "a");
+        CHECK(pushed);
+        CHECK(push_error.message() == "Success");
+
+        pop(q);
+        CHECK(poll(ioc) == 1);
+        CHECK(value == "b");
+        pop(q);
+        CHECK(poll(ioc) == 1);
+        CHECK(value == "d");
+    }
+
+    SECTION("drop_oldest")
+    {
+        auto q = queue_type(e, 2, overflow_policy::drop_oldest);
+        CHECK(q.try_push("a"));
+        CHECK(q.try_push("b"));
+        CHECK(q.try_push("c"));
+
+        pop(q);
+        CHECK(poll(ioc) == 1);
+        CHECK(value == "b");
+        pop(q);
+        CHECK(poll(ioc) == 1);
+        CHECK(value == "c");
+    }
+
+    SECTION("drop_newest")
+    {
+        auto q = queue_type(e, 2, overflow_policy::drop_newest);
+        CHECK(q.try_push("a"));
+        CHECK(q.try_push("b"));
+        CHECK(not q.try_push("c"));
+
+        auto push_error = error_code();
+        q.async_push("d", [&](error_code ec) { push_error = ec; });
+        CHECK(poll(ioc) == 1);
+        CHECK(push_error == net::error::no_buffer_space);
+
+        pop(q);
+        CHECK(poll(ioc) == 1);
+        CHECK(value == "a");
+    }
+
+    SECTION("conflate")
+    {
+        auto q = queue_type(
+            e,
+            2,
+            overflow_policy::conflate,
+            [](std::string const &l, std::string const &r) {
+                return l.front() == r.front();
+            });
+        CHECK(q.try_push("a1"));
+        CHECK(q.try_push("b1"));
+        CHECK(q.try_push("a2"));
+        CHECK(not q.try_push("c1"));
+
+        pop(q);
+        CHECK(poll(ioc) == 1);
+        CHECK(value == "a2");
+        CHECK(q.try_push("c1"));
+        pop(q);
+        CHECK(poll(ioc) == 1);
+        CHECK(value == "b1");
+    }
+
+    SECTION("stop")
+    {
+        auto q = queue_type(e, 1);
+        CHECK(q.try_push("a"));
+
+        auto push_error = error_code();
+        q.async_push("b", [&](error_code ec) { push_error = ec; });
+        q.stop();
+        CHECK(poll(ioc) == 1);
+        CHECK(push_error == net::error::operation_aborted);
+
+        pop(q);
+        CHECK(poll(ioc) == 1);
+        CHECK(pop_error == net::error::operation_aborted);
+        CHECK(value == "");
+        CHECK(not q.try_push("c"));
+    }
+
+    SECTION("different executors")
+    {
+        auto ioc2 = net::io_context(1);
+        auto e2   = ioc2.get_executor();
+        auto q    = queue_type(e, 1);
+
+        q.async_pop(bind_executor(e2, [&](error_code ec, std::string s) {
+            pop_error = ec;
+            value     = s;
+        }));
+        CHECK(q.try_push("a"));
+        CHECK(poll(ioc) == 0);
+        CHECK(poll(ioc2) == 1);
+        CHECK(pop_error.message() == "Success");
+        CHECK(value == "a");
+    }
+}
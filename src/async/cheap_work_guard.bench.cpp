@@ -0,0 +1,46 @@
+#include <benchmark/benchmark.h>
+#include <notstd/util/async/cheap_work_guard.hpp>
+
+using namespace notstd::util;
+using namespace notstd::util::async;
+
+namespace
+{
+    template < class Guard >
+    void work_guard_construct_destroy(benchmark::State &state)
+    {
+        auto ioc  = net::io_context(1);
+        auto exec = ioc.get_executor();
+
+        for (auto _ : state)
+        {
+            auto g = Guard(exec);
+            benchmark::DoNotOptimize(g);
+        }
+    }
+
+    template < class Guard >
+    void work_guard_copy(benchmark::State &state)
+    {
+        auto ioc = net::io_context(1);
+        auto g   = Guard(ioc.get_executor());
+
+        for (auto _ : state)
+        {
+            auto copy = g;
+            benchmark::DoNotOptimize(copy);
+        }
+    }
+
+    using executor = net::io_context::executor_type;
+}   // namespace
+
+BENCHMARK_TEMPLATE(work_guard_construct_destroy, cheap_work_guard< executor >)
+    ->Name("cheap_work_guard/construct_destroy");
+BENCHMARK_TEMPLATE(work_guard_construct_destroy,
+                   net::executor_work_guard< executor >)
+    ->Name("executor_work_guard/construct_destroy");
+BENCHMARK_TEMPLATE(work_guard_copy, cheap_work_guard< executor >)
+    ->Name("cheap_work_guard/copy");
+BENCHMARK_TEMPLATE(work_guard_copy, net::executor_work_guard< executor >)
+    ->Name("executor_work_guard/copy");
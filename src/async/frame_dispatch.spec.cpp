@@ -0,0 +1,50 @@
+#include <catch2/catch.hpp>
+#include <notstd/util/async/detail/frame_dispatch.hpp>
+#include <string>
+#include <vector>
+
+using namespace notstd::util::async;
+
+TEST_CASE("notstd::util::async::detail::dispatch_fragment",
+          "[notstd::util::async::detail::dispatch_fragment]")
+{
+    auto message = std::string("hello, world");
+    auto part    = [&](std::size_t first, std::size_t last) {
+        return std::span< char >(message.data() + first, last - first);
+    };
+
+    auto fragments = std::vector< std::string >();
+    auto flags     = std::vector< std::pair< bool, bool > >();
+    auto messages  = std::vector< std::string >();
+
+    auto on_fragment = [&](frame_fragment f) {
+        fragments.emplace_back(f.data.begin(), f.data.end());
+        flags.emplace_back(f.first, f.last);
+    };
+    auto on_message = [&](std::span< char > m) {
+        messages.emplace_back(m.begin(), m.end());
+    };
+
+    SECTION("a streaming handler sees every fragment as it arrives")
+    {
+        CHECK(detail::dispatch_fragment(
+            true, { part(0, 5), true, false }, on_fragment, on_message));
+        CHECK(detail::dispatch_fragment(
+            true, { part(5, 12), false, true }, on_fragment, on_message));
+        CHECK(fragments == std::vector< std::string > { "hello", ", world" });
+        CHECK(flags == std::vector< std::pair< bool, bool > > {
+                           { true, false }, { false, true } });
+        CHECK(messages.empty());
+    }
+
+    SECTION("a span handler sees only the complete message")
+    {
+        CHECK_FALSE(detail::dispatch_fragment(
+            false, { part(0, 5), true, false }, on_fragment, on_message));
+        CHECK(messages.empty());
+        CHECK(detail::dispatch_fragment(
+            false, { part(0, 12), true, true }, on_fragment, on_message));
+        CHECK(messages == std::vector< std::string > { "hello, world" });
+        CHECK(fragments.empty());
+    }
+}
@@ -0,0 +1,138 @@
+#include <catch2/catch.hpp>
+#include <notstd/util/async/async_queue.hpp>
+#include <thread>
+
+using namespace notstd::util;
+using namespace notstd::util::async;
+
+TEST_CASE("notstd::util::async::mpmc_async_queue",
+          "[notstd::util::async::async_queue]")
+{
+    auto ioc = net::io_context(1);
+    auto e   = ioc.get_executor();
+    auto q   = basic_mpmc_async_queue< std::string, decltype(e) >(e);
+
+    auto poll = [](net::io_context &ioc) {
+        if (ioc.stopped())
+            ioc.restart();
+        return ioc.poll();
+    };
+
+    auto results = std::vector< std::pair< int, std::string > >();
+    auto errors  = std::vector< error_code >();
+    auto pop     = [&](int id) {
+        q.async_pop([&, id](error_code ec, std::string s) {
+            errors.push_back(ec);
+            results.emplace_back(id, s);
+        });
+    };
+
+    SECTION("waiters are served in order, one per value")
+    {
+        pop(1);
+        pop(2);
+        pop(3);
+        CHECK(poll(ioc) == 0);
+
+        q.push("a");
+        CHECK(poll(ioc) == 1);
+        q.push_range({ "b", "c", "d" });
+        CHECK(poll(ioc) == 2);
+
+        CHECK(results == decltype(results) {
+                             { 1, "a" }, { 2, "b" }, { 3, "c" } });
+
+        pop(4);
+        CHECK(poll(ioc) == 1);
+        CHECK(results.back() == std::pair< int, std::string >(4, "d"));
+    }
+
+    SECTION("stop aborts every waiter")
+    {
+        pop(1);
+        pop(2);
+        q.stop();
+        CHECK(poll(ioc) == 2);
+        CHECK(errors == std::vector< error_code >(
+                            2, net::error::operation_aborted));
+
+        q.push("a");
+        pop(3);
+        CHECK(poll(ioc) == 1);
+        CHECK(errors.back() == net::error::operation_aborted);
+    }
+
+    SECTION("waiters are completed on their own executors")
+    {
+        auto ioc2 = net::io_context(1);
+        auto ioc3 = net::io_context(1);
+        auto on   = [&](net::io_context &ctx, int id) {
+            q.async_pop(bind_executor(
+                ctx.get_executor(), [&, id](error_code ec, std::string s) {
+                    CHECK(not ec);
+                    CHECK(ctx.get_executor().running_in_this_thread());
+                    results.emplace_back(id, s);
+                }));
+        };
+        on(ioc2, 2);
+        on(ioc3, 3);
+        q.push_range({ "a", "b" });
+
+        CHECK(poll(ioc3) == 1);
+        CHECK(poll(ioc2) == 1);
+        CHECK(results == decltype(results) { { 3, "b" }, { 2, "a" } });
+    }
+
+    SECTION("worker pool")
+    {
+        constexpr int workers = 4;
+        constexpr int values  = 20000;
+
+        auto pool     = net::io_context(workers);
+        auto received = std::vector< std::atomic< int > >(values);
+        auto total    = std::atomic< int >(0);
+        auto wq = basic_mpmc_async_queue< int, decltype(pool.get_executor()) >(
+            pool.get_executor());
+
+        struct worker
+        {
+            void start()
+            {
+                q_.async_pop([this](error_code ec, int v) {
+                    if (ec)
+                        return;
+                    ++received_[v];
+                    if (++total_ == values)
+                        q_.stop();
+                    start();
+                });
+            }
+
+            decltype(wq) &                     q_;
+            std::vector< std::atomic< int > > &received_;
+            std::atomic< int > &               total_;
+        };
+
+        auto ws =
+            std::vector< worker >(workers, worker { wq, received, total });
+        for (auto &w : ws)
+            w.start();
+
+        auto producer = std::thread([&] {
+            for (int i = 0; i < values; ++i)
+                wq.push(i);
+        });
+        auto threads = std::vector< std::thread >();
+        for (int i = 0; i < workers; ++i)
+            threads.emplace_back([&] { pool.run(); });
+
+        producer.join();
+        for (auto &t : threads)
+            t.join();
+
+        CHECK(total == values);
+        CHECK(std::all_of(received.begin(), received.end(), [](auto &n) {
+            return n == 1;
+        }));
+    }
+}
@@ -0,0 +1,151 @@
+#include <catch2/catch.hpp>
+#include <notstd/util/async/async_queue.hpp>
+#include <thread>
+
+using namespace notstd::util;
+using namespace notstd::util::async;
+
+TEST_CASE("notstd::util::async::mpsc_async_queue",
+          "[notstd::util::async::async_queue]")
+{
+    auto ioc = net::io_context(1);
+    auto e   = ioc.get_executor();
+    auto q   = basic_mpsc_async_queue< std::string, decltype(e) >(e);
+
+    auto run = [](net::io_context &ioc) {
+        if (ioc.stopped())
+            ioc.restart();
+        return ioc.run();
+    };
+
+    error_code  error;
+    std::string value;
+
+    auto make_handler = [&]() {
+        return [&](error_code ec, std::string s) {
+            error = ec;
+            value = s;
+        };
+    };
+
+    SECTION("push does not touch the executor")
+    {
+        q.push("a");
+        q.push("b");
+        CHECK(run(ioc) == 0);
+
+        q.async_pop(make_handler());
+        CHECK(run(ioc) == 1);
+        CHECK(not error);
+        CHECK(value == "a");
+
+        q.async_pop(make_handler());
+        CHECK(run(ioc) == 1);
+        CHECK(value == "b");
+    }
+
+    SECTION("parked consumer is woken by push")
+    {
+        q.async_pop(make_handler());
+        CHECK(ioc.poll() == 0);
+        q.push("a");
+        CHECK(run(ioc) == 1);
+        CHECK(value == "a");
+    }
+
+    SECTION("stop")
+    {
+        q.push("a");
+        q.stop();
+        q.async_pop(make_handler());
+        CHECK(run(ioc) == 1);
+        CHECK(error == net::error::operation_aborted);
+        CHECK(value == "");
+
+        q.push("b");
+        q.async_pop(make_handler());
+        CHECK(run(ioc) == 1);
+        CHECK(error == net::error::operation_aborted);
+    }
+
+    SECTION("pop some")
+    {
+        auto values = std::vector< std::string >();
+        auto pop_some = [&](std::size_t max) {
+            q.async_pop_some(max,
+                             [&](error_code ec, std::vector< std::string > vs) {
+                                 error  = ec;
+                                 values = std::move(vs);
+                             });
+        };
+
+        q.push_range({ "a", "b", "c" });
+        q.push("d");
+        pop_some(3);
+        CHECK(run(ioc) == 1);
+        CHECK(values == std::vector< std::string > { "a", "b", "c" });
+
+        pop_some(3);
+        CHECK(run(ioc) == 1);
+        CHECK(values == std::vector< std::string > { "d" });
+
+        pop_some(3);
+        CHECK(ioc.poll() == 0);
+        q.stop();
+        CHECK(run(ioc) == 1);
+        CHECK(error == net::error::operation_aborted);
+        CHECK(values.empty());
+    }
+
+    SECTION("different executors")
+    {
+        auto ioc2 = net::io_context(1);
+        q.async_pop(bind_executor(ioc2.get_executor(), make_handler()));
+        q.push("a");
+        CHECK(ioc.poll() == 1);
+        CHECK(value == "");
+        CHECK(run(ioc2) == 1);
+        CHECK(value == "a");
+    }
+
+    SECTION("many producers")
+    {
+        constexpr int producers = 4;
+        constexpr int per       = 10000;
+
+        auto received = std::vector< int >(producers, 0);
+        auto count    = 0;
+        auto ordered  = true;
+
+        auto failed = false;
+
+        // the pending pop holds work on the executor, so run() returns once
+        // the final value has been consumed
+        std::function< void(error_code, std::string) > consume =
+            [&](error_code ec, std::string s) {
+                failed |= bool(ec);
+                auto p = s[0] - 'a';
+                auto n = std::stoi(s.substr(1));
+                ordered &= n == received[p];
+                received[p] = n + 1;
+                if (++count < producers * per)
+                    q.async_pop(consume);
+            };
+        q.async_pop(consume);
+
+        auto threads = std::vector< std::thread >();
+        for (int p = 0; p < producers; ++p)
+            threads.emplace_back([&q, p] {
+                for (int i = 0; i < per; ++i)
+                    q.push(char('a' + p) + std::to_string(i));
+            });
+
+        run(ioc);
+        for (auto &th : threads)
+            th.join();
+
+        CHECK(not failed);
+        CHECK(count == producers * per);
+        CHECK(ordered);
+    }
+}
@@ -0,0 +1,92 @@
+#include "testing/allocation_counter.hpp"
+
+#include <benchmark/benchmark.h>
+#include <notstd/util/async/poly_handler.hpp>
+
+using namespace notstd::util;
+using namespace notstd::util::async;
+using notstd::util::testing::allocation_counter;
+
+namespace
+{
+    // models the shape of a coroutine handler wrapped with work guards on
+    // two executors
+    template < std::size_t Padding >
+    struct handler
+    {
+        using executor_type = net::io_context::executor_type;
+
+        auto get_executor() const -> executor_type { return exec_; }
+
+        void operator()(int x) { *target_ += x; }
+
+        executor_type exec_;
+        int *         target_;
+        char          padding_[Padding] = {};
+    };
+
+    template < std::size_t Padding >
+    void poly_handler_construct_invoke(benchmark::State &state)
+    {
+        auto ioc    = net::io_context();
+        int  target = 0;
+        auto f      = poly_handler< void(int) >();
+
+        auto counter = allocation_counter(state);
+        for (auto _ : state)
+        {
+            f = handler< Padding > { .exec_   = ioc.get_executor(),
+                                     .target_ = &target };
+            f(1);
+        }
+        benchmark::DoNotOptimize(target);
+    }
+
+    template < std::size_t Padding >
+    void poly_handler_move(benchmark::State &state)
+    {
+        auto ioc    = net::io_context(1);
+        int  target = 0;
+        auto f      = poly_handler< void(int) >(handler< Padding > {
+            .exec_ = ioc.get_executor(), .target_ = &target });
+        auto g = poly_handler< void(int) >();
+
+        auto counter = allocation_counter(state);
+        for (auto _ : state)
+        {
+            g = std::move(f);
+            f = std::move(g);
+        }
+        benchmark::DoNotOptimize(f);
+    }
+
+    template < std::size_t Padding >
+    void poly_handler_post_completion(benchmark::State &state)
+    {
+        auto ioc    = net::io_context(1);
+        int  target = 0;
+        auto f      = poly_handler< void(int) >();
+
+        auto counter = allocation_counter(state);
+        for (auto _ : state)
+        {
+            f = handler< Padding > { .exec_   = ioc.get_executor(),
+                                     .target_ = &target };
+            f.post_completion(1);
+            ioc.restart();
+            ioc.run();
+        }
+        benchmark::DoNotOptimize(target);
+    }
+}   // namespace
+
+BENCHMARK_TEMPLATE(poly_handler_construct_invoke, 8)->Name("poly_handler/small");
+BENCHMARK_TEMPLATE(poly_handler_construct_invoke, 96)->Name("poly_handler/big");
+BENCHMARK_TEMPLATE(poly_handler_construct_invoke, 1024)
+    ->Name("poly_handler/huge");
+BENCHMARK_TEMPLATE(poly_handler_move, 8)->Name("poly_handler/move/small");
+BENCHMARK_TEMPLATE(poly_handler_move, 96)->Name("poly_handler/move/big");
+BENCHMARK_TEMPLATE(poly_handler_post_completion, 8)
+    ->Name("poly_handler/post_completion/small");
+BENCHMARK_TEMPLATE(poly_handler_post_completion, 96)
+    ->Name("poly_handler/post_completion/big");
@@ -1,5 +1,6 @@
-#include <catch2/catch.hpp>
+#include "testing/allocation_count.hpp"
 
+#include <catch2/catch.hpp>
 #include <notstd/util/async/poly_handler.hpp>
 
 using namespace notstd::util::async;
@@ -42,4 +43,195 @@ TEST_CASE("notstd::util::async::poly_handler", "[notstd::util::async::poly_handl
     CHECK(target == "test xyz");
     CHECK(f.has_value() == false);
 
-}
\ No newline at end of file
+}
+namespace
+{
+    template < class T >
+    struct counting_allocator
+    {
+        using value_type = T;
+
+        counting_allocator(std::size_t &allocs, std::size_t &deallocs)
+        : allocs_(&allocs)
+        , deallocs_(&deallocs)
+        {
+        }
+
+        template < class U >
+        counting_allocator(counting_allocator< U > const &other)
+        : allocs_(other.allocs_)
+        , deallocs_(other.deallocs_)
+        {
+        }
+
+        T *allocate(std::size_t n)
+        {
+            ++*allocs_;
+            return std::allocator< T >().allocate(n);
+        }
+
+        void deallocate(T *p, std::size_t n)
+        {
+            ++*deallocs_;
+            std::allocator< T >().deallocate(p, n);
+        }
+
+        std::size_t *allocs_;
+        std::size_t *deallocs_;
+    };
+
+    struct big_allocating_handler
+    {
+        using executor_type  = net::io_context::executor_type;
+        using allocator_type = counting_allocator< void >;
+
+        auto get_executor() const -> executor_type { return exec_; }
+        auto get_allocator() const -> allocator_type { return alloc_; }
+
+        void operator()(std::string s) { *target_ = s; }
+
+        executor_type  exec_;
+        allocator_type alloc_;
+        std::string *  target_;
+        char           padding_[64] = {};
+    };
+}   // namespace
+
+TEST_CASE("notstd::util::async::poly_handler uses associated allocator",
+          "[notstd::util::async::poly_handler]")
+{
+    std::string target;
+    std::size_t allocs = 0, deallocs = 0;
+    auto        ioc = net::io_context();
+
+    auto f = poly_handler< void(std::string) >(big_allocating_handler {
+        .exec_   = ioc.get_executor(),
+        .alloc_  = counting_allocator< void >(allocs, deallocs),
+        .target_ = &target });
+    CHECK(allocs == 1);
+    CHECK(deallocs == 0);
+
+    SECTION("invoke")
+    {
+        f("test"s);
+        CHECK(target == "test");
+        CHECK(deallocs == 1);
+    }
+
+    SECTION("move then destroy")
+    {
+        auto g = std::move(f);
+        CHECK(allocs == 1);
+        g = poly_handler< void(std::string) >();
+        CHECK(deallocs == 1);
+        CHECK(target.empty());
+    }
+}
+
+TEST_CASE("notstd::util::async::poly_handler inline capacity",
+          "[notstd::util::async::poly_handler]")
+{
+    auto ioc = net::io_context();
+    auto e   = ioc.get_executor();
+
+    // records where it was last moved to, i.e. where poly_handler stores it
+    struct alignas(64) over_aligned
+    {
+        using executor_type = net::io_context::executor_type;
+
+        over_aligned(executor_type exec, std::uintptr_t &stored)
+        : exec_(exec)
+        , stored_(&stored)
+        {
+            record();
+        }
+
+        over_aligned(over_aligned &&other) noexcept
+        : exec_(other.exec_)
+        , stored_(other.stored_)
+        {
+            record();
+        }
+
+        auto get_executor() const -> executor_type { return exec_; }
+
+        void operator()(std::uintptr_t &) {}
+
+        auto record() -> void
+        {
+            *stored_ = reinterpret_cast< std::uintptr_t >(this);
+        }
+
+        executor_type    exec_;
+        std::uintptr_t *stored_;
+    };
+
+    using padded = decltype(net::bind_executor(
+        e, [x = std::array< char, 100 >()](std::uintptr_t &) {}));
+
+    using default_handler = poly_handler< void(std::uintptr_t &) >;
+    using wide_handler    = poly_handler< void(std::uintptr_t &), 128, 64 >;
+
+    STATIC_REQUIRE(not is_stored_inline_v< default_handler, padded >);
+    STATIC_REQUIRE(is_stored_inline_v< wide_handler, padded >);
+    STATIC_REQUIRE(not is_stored_inline_v< default_handler, over_aligned >);
+    STATIC_REQUIRE(is_stored_inline_v< wide_handler, over_aligned >);
+    STATIC_REQUIRE(
+        is_stored_inline_v< poly_handler_for< void(std::uintptr_t &), padded >,
+                            padded >);
+
+    std::uintptr_t stored = 0;
+    std::uintptr_t unused = 0;
+
+    auto within = [](auto const &handler, std::uintptr_t addr) {
+        auto const base = reinterpret_cast< std::uintptr_t >(&handler);
+        return addr >= base and addr < base + sizeof(handler);
+    };
+
+    SECTION("over-aligned handler stored out of line")
+    {
+        auto f = default_handler(over_aligned(e, stored));
+        CHECK(stored % 64 == 0);
+        CHECK(not within(f, stored));
+        f(unused);
+    }
+
+    SECTION("over-aligned handler stored inline")
+    {
+        auto f = wide_handler(over_aligned(e, stored));
+        CHECK(stored % 64 == 0);
+        CHECK(within(f, stored));
+        auto g = std::move(f);
+        CHECK(stored % 64 == 0);
+        CHECK(within(g, stored));
+        g(unused);
+    }
+}
+
+TEST_CASE("notstd::util::async::poly_handler post_completion does not allocate",
+          "[notstd::util::async::poly_handler]")
+{
+    auto ioc = net::io_context(1);
+    auto e   = ioc.get_executor();
+
+    std::size_t total = 0;
+    auto        f     = poly_handler< void(error_code, std::string) >();
+
+    auto complete_once = [&] {
+        f = net::bind_executor(
+            e, [&total](error_code, std::string s) { total += s.size(); });
+        f.post_completion(error_code(), "x"s);
+        CHECK(not f.has_value());
+        ioc.restart();
+        return ioc.run();
+    };
+
+    // prime the thread's recycling cache
+    CHECK(complete_once() == 1);
+
+    auto before = testing::allocation_count();
+    for (int i = 0; i < 100; ++i)
+        complete_once();
+    CHECK(testing::allocation_count() - before == 0);
+    CHECK(total == 101);
+}
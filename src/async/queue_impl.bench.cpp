@@ -0,0 +1,62 @@
+#include "testing/allocation_counter.hpp"
+
+#include <benchmark/benchmark.h>
+#include <notstd/util/async/queue_impl.hpp>
+
+using namespace notstd::util;
+using namespace notstd::util::async;
+using notstd::util::testing::allocation_counter;
+
+namespace
+{
+    using executor = net::io_context::executor_type;
+
+    // a consumer parked in async_pop is completed by push
+    void queue_impl_parked_pop(benchmark::State &state)
+    {
+        auto ioc = net::io_context(1);
+        auto q   = queue_impl< int, executor >(ioc.get_executor());
+        auto sum = 0;
+
+        auto counter = allocation_counter(state);
+        for (auto _ : state)
+        {
+            q.async_pop(
+                net::bind_executor(ioc, [&](error_code, int v) { sum += v; }));
+            q.push(1);
+            ioc.restart();
+            ioc.poll();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+
+    // values pushed while no consumer waits are drained in batches of
+    // state.range(0)
+    void queue_impl_pop_some(benchmark::State &state)
+    {
+        auto const batch = std::size_t(state.range(0));
+
+        auto ioc = net::io_context(1);
+        auto q   = queue_impl< int, executor >(ioc.get_executor());
+        auto sum = std::size_t(0);
+
+        auto counter = allocation_counter(state);
+        for (auto _ : state)
+        {
+            for (std::size_t i = 0; i < batch; ++i)
+                q.push(1);
+            q.async_pop_some(batch,
+                             net::bind_executor(
+                                 ioc, [&](error_code, std::vector< int > vs) {
+                                     sum += vs.size();
+                                 }));
+            ioc.restart();
+            ioc.poll();
+        }
+        state.SetItemsProcessed(state.iterations() * batch);
+        benchmark::DoNotOptimize(sum);
+    }
+}   // namespace
+
+BENCHMARK(queue_impl_parked_pop)->Name("queue_impl/parked_pop");
+BENCHMARK(queue_impl_pop_some)->Name("queue_impl/pop_some")->Arg(1)->Arg(64);
@@ -0,0 +1,92 @@
+#include <catch2/catch.hpp>
+#include <notstd/util/async/queue_impl.hpp>
+
+using namespace notstd::util;
+using namespace notstd::util::async;
+
+TEST_CASE("notstd::util::async::queue_impl",
+          "[notstd::util::async::queue_impl]")
+{
+    auto ioc = net::io_context(1);
+    auto e   = ioc.get_executor();
+    auto q   = queue_impl< std::string, decltype(e) >(e);
+
+    auto poll = [](net::io_context &ioc) {
+        if (ioc.stopped())
+            ioc.restart();
+        return ioc.poll();
+    };
+
+    error_code                 error;
+    std::string                value;
+    std::vector< std::string > values;
+
+    auto pop = [&] {
+        q.async_pop([&](error_code ec, std::string s) {
+            error = ec;
+            value = s;
+        });
+    };
+
+    auto pop_some = [&](std::size_t max) {
+        q.async_pop_some(max,
+                         [&](error_code ec, std::vector< std::string > vs) {
+                             error  = ec;
+                             values = std::move(vs);
+                         });
+    };
+
+    SECTION("pop consumes queued values in order")
+    {
+        q.push("a");
+        q.push("b");
+
+        pop();
+        CHECK(poll(ioc) == 1);
+        CHECK(value == "a");
+        pop();
+        CHECK(poll(ioc) == 1);
+        CHECK(value == "b");
+        pop();
+        CHECK(poll(ioc) == 0);
+        q.push("c");
+        CHECK(poll(ioc) == 1);
+        CHECK(value == "c");
+    }
+
+    SECTION("pop some")
+    {
+        q.push_range({ "a", "b", "c" });
+        pop_some(2);
+        CHECK(poll(ioc) == 1);
+        CHECK(values == std::vector< std::string > { "a", "b" });
+
+        pop_some(2);
+        CHECK(poll(ioc) == 1);
+        CHECK(values == std::vector< std::string > { "c" });
+
+        // a parked waiter takes a whole range in one completion
+        pop_some(4);
+        CHECK(poll(ioc) == 0);
+        q.push_range({ "d", "e" });
+        CHECK(poll(ioc) == 1);
+        CHECK(values == std::vector< std::string > { "d", "e" });
+
+        pop_some(1);
+        q.push_range({ "f", "g" });
+        CHECK(poll(ioc) == 1);
+        CHECK(values == std::vector< std::string > { "f" });
+        pop();
+        CHECK(poll(ioc) == 1);
+        CHECK(value == "g");
+    }
+
+    SECTION("cancel")
+    {
+        pop_some(4);
+        q.cancel();
+        CHECK(poll(ioc) == 1);
+        CHECK(error == net::error::operation_aborted);
+        CHECK(values.empty());
+    }
+}
@@ -0,0 +1,107 @@
+#include <catch2/catch.hpp>
+#include <notstd/util/async/detail/recycling_allocator.hpp>
+#include <cstring>
+#include <thread>
+
+using namespace notstd::util::async::detail;
+
+TEST_CASE("notstd::util::async::detail::recycling_cache")
+{
+    auto &cache = recycling_cache::this_thread();
+
+    SECTION("size classes")
+    {
+        CHECK(recycling_cache::size_class(1) == 0);
+        CHECK(recycling_cache::size_class(64) == 0);
+        CHECK(recycling_cache::size_class(65) == 1);
+        CHECK(recycling_cache::size_class(recycling_cache::max_block_size) ==
+              recycling_cache::class_count - 1);
+        CHECK(recycling_cache::size_class(recycling_cache::max_block_size +
+                                          1) == recycling_cache::class_count);
+    }
+
+    SECTION("released block is reused by the same size class")
+    {
+        auto p1 = cache.allocate(100);
+        cache.deallocate(p1, 100);
+        auto p2 = cache.allocate(120);
+        CHECK(p1 == p2);
+        cache.deallocate(p2, 120);
+    }
+
+    SECTION("blocks are not shared between size classes")
+    {
+        auto p1 = cache.allocate(100);
+        cache.deallocate(p1, 100);
+        auto p2 = cache.allocate(200);
+        CHECK(p1 != p2);
+        cache.deallocate(p2, 200);
+    }
+
+    SECTION("allocator")
+    {
+        auto alloc = recycling_allocator< std::string >();
+        auto p1    = alloc.allocate(1);
+        alloc.deallocate(p1, 1);
+        auto other = recycling_allocator< std::uint64_t >(alloc);
+        auto p2    = other.allocate(4);
+        CHECK(static_cast< void * >(p1) == static_cast< void * >(p2));
+        other.deallocate(p2, 4);
+        CHECK(alloc == other);
+    }
+}
+
+namespace
+{
+    // a thread_local which outlives the thread's cache, because it is
+    // constructed first, and frees its block in its destructor
+    struct late_release
+    {
+        ~late_release()
+        {
+            destroyed_first = recycling_cache::this_thread_destroyed();
+            recycling_allocator< std::string >().deallocate(block, 1);
+        }
+
+        std::string *      block           = nullptr;
+        static inline bool destroyed_first = false;
+    };
+
+    // a thread_local which allocates once the thread's cache is gone
+    struct late_allocate
+    {
+        ~late_allocate() { block = recycling_cache::thread_allocate(100, 8); }
+
+        static inline void *block = nullptr;
+    };
+}   // namespace
+
+TEST_CASE("notstd::util::async::detail::recycling_cache teardown")
+{
+    std::thread([] {
+        static thread_local late_release late;
+        CHECK(not recycling_cache::this_thread_destroyed());
+        late.block = recycling_allocator< std::string >().allocate(1);
+    }).join();
+    CHECK(late_release::destroyed_first);
+}
+
+TEST_CASE(
+    "notstd::util::async::detail::recycling_cache released after teardown")
+{
+    std::thread([] {
+        static thread_local late_allocate late;
+        recycling_cache::this_thread();
+    }).join();
+    REQUIRE(late_allocate::block);
+
+    // released to this thread's cache, the block is handed out again as a
+    // whole one of its class
+    auto &cache = recycling_cache::this_thread();
+    auto  size  = recycling_cache::block_size(recycling_cache::size_class(100));
+    cache.deallocate(late_allocate::block, 100);
+    auto p = cache.allocate(size);
+    CHECK(p == late_allocate::block);
+    std::memset(p, 0xff, size);
+    cache.deallocate(p, size);
+}
@@ -0,0 +1,90 @@
+#include <catch2/catch.hpp>
+#include <notstd/util/async/supervised_websocket.hpp>
+#include <notstd/util/async/websocket_acceptor.hpp>
+
+using namespace notstd::util;
+using namespace std::literals;
+
+namespace
+{
+    using executor_type = net::io_context::executor_type;
+    using socket_type = net::basic_stream_socket< net::ip::tcp, executor_type >;
+    using server_type  = async::websocket_acceptor< socket_type >;
+    using client_type  = async::supervised_websocket< socket_type >;
+    using session_type = server_type::state_type;
+}   // namespace
+
+TEST_CASE("notstd::util::async::supervised_websocket",
+          "[notstd::util::async::supervised_websocket]")
+{
+    // echoes text, and closes the connection when asked to
+    auto threads = io_context_pool(1);
+    auto server  = server_type(
+        threads,
+        net::ip::tcp::endpoint(net::ip::address_v4::loopback(), 0),
+        server_type::options {});
+    server.start([](session_type &state) -> session_type::awaitable {
+        co_await state([&state](std::span< char > text) {
+            auto s = std::string(text.begin(), text.end());
+            if (s == "bye")
+                state.close();
+            else
+                state.send_text(std::move(s));
+        });
+    });
+
+    auto ioc    = net::io_context(1);
+    auto client = client_type(
+        ioc.get_executor(),
+        client_type::options {
+            .reconnect = backoff_policy { .initial = 10ms, .max = 50ms },
+            .max_buffered_frames = 3 });
+
+    auto received = std::vector< std::string >();
+    auto done     = false;
+    client.set_on_connected([&](client_type::state_type &state) {
+        state.send_text("subscribe");
+    });
+    auto on_text = [&](std::span< char > s) {
+        received.emplace_back(s.begin(), s.end());
+    };
+    net::co_spawn(
+        ioc, client(on_text), [&](std::exception_ptr) { done = true; });
+
+    auto run_until = [&](auto pred) {
+        auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (not pred() and std::chrono::steady_clock::now() < deadline)
+            ioc.run_one_for(10ms);
+        return pred();
+    };
+
+    // frames sent before the connection is up are held, up to the limit
+    client.send_text("one");
+    client.send_text("two");
+    client.send_text("three");
+    CHECK_THROWS_AS(client.send_text("four"), system_error);
+    CHECK(client.buffered_frames() == 3);
+
+    client.connect(
+        "127.0.0.1", std::to_string(server.local_endpoint().port()), "/");
+    REQUIRE(run_until([&] { return received.size() == 4; }));
+    CHECK(received == std::vector< std::string > {
+                          "subscribe", "one", "two", "three" });
+    CHECK(client.buffered_frames() == 0);
+    CHECK(client.connects() == 1);
+
+    SECTION("a dropped connection is remade and resubscribed")
+    {
+        client.send_text("bye");
+        REQUIRE(run_until([&] { return not client.connected(); }));
+        client.send_text("while away");
+        REQUIRE(run_until([&] { return received.size() == 6; }));
+        CHECK(client.connects() == 2);
+        CHECK(received[4] == "subscribe");
+        CHECK(received[5] == "while away");
+    }
+
+    client.close();
+    REQUIRE(run_until([&] { return done; }));
+    CHECK_THROWS_AS(client.send_text("late"), system_error);
+}
@@ -57,4 +57,103 @@ TEST_CASE("notstd::util::async::tcp_resolve_state_impl")
         CHECK(not run_exception);
         CHECK(not run_results.empty());
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("notstd::util::async::tcp_resolve_state_impl with a cache")
+{
+    auto ioc            = net::io_context();
+    using executor_type = net::io_context::executor_type;
+    using state_type    = async::tcp_resolve_state_impl< executor_type >;
+
+    auto cache  = std::make_shared< resolve_cache >();
+    auto states = std::vector< std::unique_ptr< state_type > >();
+    auto errors = std::vector< error_code >();
+
+    auto spawn_runs = [&](std::size_t n) {
+        states.clear();
+        errors.assign(n, error_code());
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            auto &state = *states.emplace_back(
+                std::make_unique< state_type >(ioc.get_executor()));
+            state.set_cache(cache);
+            net::co_spawn(
+                ioc.get_executor(),
+                [&state]() -> net::awaitable< state_type::results_type,
+                                              executor_type > {
+                    co_return co_await state("localhost", "443");
+                },
+                [&, i](std::exception_ptr ep, state_type::results_type res) {
+                    if (ep)
+                        errors[i] = net::error::operation_aborted;
+                    else
+                        CHECK(not res.empty());
+                });
+        }
+    };
+
+    SECTION("identical lookups share one resolve")
+    {
+        spawn_runs(8);
+        ioc.run();
+        CHECK(std::count(errors.begin(), errors.end(), error_code()) == 8);
+        CHECK(cache->stats().misses == 1);
+        CHECK(cache->stats().coalesced == 7);
+
+        SECTION("and later lookups hit")
+        {
+            ioc.restart();
+            spawn_runs(2);
+            ioc.run();
+            CHECK(cache->stats().misses == 1);
+            CHECK(cache->stats().hits == 2);
+        }
+    }
+
+    SECTION("a waiter takes over from a cancelled leader")
+    {
+        spawn_runs(2);
+        net::post(ioc, [&] { states[0]->cancel(); });
+        ioc.run();
+        CHECK(errors[0] == net::error::operation_aborted);
+        CHECK(errors[1] == error_code());
+        CHECK(cache->stats().misses == 2);
+    }
+
+    SECTION("a leader destroyed mid lookup releases the host")
+    {
+        {
+            auto other  = std::make_unique< net::io_context >();
+            auto leader = state_type(other->get_executor());
+            leader.set_cache(cache);
+            net::co_spawn(
+                *other,
+                [&]() -> net::awaitable< state_type::results_type,
+                                         executor_type > {
+                    co_return co_await leader("localhost", "443");
+                },
+                net::detached);
+
+            // start the lookup, then destroy its suspended frame along with
+            // the context
+            other->run_one();
+            other.reset();
+        }
+
+        spawn_runs(1);
+        ioc.run();
+        CHECK(errors[0] == error_code());
+        CHECK(cache->stats().misses == 2);
+        CHECK(cache->stats().coalesced == 0);
+    }
+
+    SECTION("a cancelled waiter does not disturb the leader")
+    {
+        spawn_runs(2);
+        net::post(ioc, [&] { states[1]->cancel(); });
+        ioc.run();
+        CHECK(errors[0] == error_code());
+        CHECK(errors[1] == net::error::operation_aborted);
+        CHECK(cache->stats().misses == 1);
+    }
+}
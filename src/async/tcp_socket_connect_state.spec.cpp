@@ -0,0 +1,167 @@
+#include <catch2/catch.hpp>
+#include <notstd/util/async/tcp_socket_connect_state_impl.hpp>
+
+using namespace notstd::util;
+using namespace std::literals;
+
+namespace
+{
+    using executor_type = net::io_context::executor_type;
+    using socket_type = net::basic_stream_socket< net::ip::tcp, executor_type >;
+    using state_type =
+        async::basic_tcp_socket_connect_state_impl< executor_type >;
+    using endpoint_type = net::ip::tcp::endpoint;
+
+    auto loopback(int n) -> net::ip::address
+    {
+        return net::ip::address_v4(0x7f000000 + n);
+    }
+
+    // a loopback listener which leaves its connections queued
+    struct listener
+    {
+        listener(net::io_context &ioc, net::ip::address addr)
+        : acceptor(ioc, { addr, 0 })
+        {
+        }
+
+        auto endpoint() const -> endpoint_type
+        {
+            return acceptor.local_endpoint();
+        }
+
+        net::ip::tcp::acceptor acceptor;
+    };
+
+    // a loopback listener whose queue is full, so that connection attempts
+    // go unanswered
+    struct blackhole
+    {
+        blackhole(net::io_context &ioc, net::ip::address addr)
+        : acceptor(ioc, { addr, 0 }, true)
+        , filler(ioc)
+        {
+            acceptor.listen(0);
+            filler.connect(acceptor.local_endpoint());
+        }
+
+        auto endpoint() const -> endpoint_type
+        {
+            return acceptor.local_endpoint();
+        }
+
+        net::ip::tcp::acceptor acceptor;
+        net::ip::tcp::socket   filler;
+    };
+
+    // an address with nothing listening
+    auto refused(net::io_context &ioc, net::ip::address addr) -> endpoint_type
+    {
+        auto acceptor = net::ip::tcp::acceptor(ioc, { addr, 0 });
+        return acceptor.local_endpoint();
+    }
+}   // namespace
+
+TEST_CASE("notstd::util::happy_eyeballs_order")
+{
+    auto v4 = [](int n) { return endpoint_type(loopback(n), 443); };
+    auto v6 = [](int n) {
+        auto bytes = net::ip::address_v6::bytes_type();
+        bytes[15]  = static_cast< unsigned char >(n);
+        return endpoint_type(net::ip::address_v6(bytes), 443);
+    };
+
+    CHECK(happy_eyeballs_order({}).empty());
+    CHECK(happy_eyeballs_order({ v6(1), v6(2), v4(1), v4(2), v4(3) }) ==
+          std::vector { v6(1), v4(1), v6(2), v4(2), v4(3) });
+    CHECK(happy_eyeballs_order({ v4(1), v6(1), v6(2) }) ==
+          std::vector { v4(1), v6(1), v6(2) });
+    CHECK(happy_eyeballs_order({ v4(1), v4(2) }) ==
+          std::vector { v4(1), v4(2) });
+}
+
+TEST_CASE("notstd::util::async::tcp_socket_connect_state_impl")
+{
+    auto ioc   = net::io_context();
+    auto sock  = socket_type(ioc.get_executor());
+    auto state = async::make_connect_state_impl(sock);
+
+    std::exception_ptr run_exception = nullptr;
+    endpoint_type      run_result;
+
+    auto run = [&](std::vector< endpoint_type > endpoints) {
+        net::co_spawn(
+            ioc.get_executor(),
+            [&, endpoints]() -> state_type::awaitable {
+                co_return co_await state(endpoints);
+            },
+            [&](std::exception_ptr ep, endpoint_type result) {
+                run_exception = ep;
+                run_result    = result;
+            });
+        auto const start = std::chrono::steady_clock::now();
+        ioc.run();
+        return std::chrono::steady_clock::now() - start;
+    };
+
+    auto error = [&] {
+        try
+        {
+            if (run_exception)
+                std::rethrow_exception(run_exception);
+        }
+        catch (system_error &e)
+        {
+            return e.code();
+        }
+        return error_code();
+    };
+
+    auto good = listener(ioc, loopback(1));
+    auto hole = blackhole(ioc, loopback(2));
+
+    SECTION("an unanswered address costs only the attempt delay")
+    {
+        state.set_connect_options({ .attempt_delay = 50ms });
+        auto elapsed = run({ hole.endpoint(), good.endpoint() });
+        REQUIRE(not run_exception);
+        CHECK(run_result == good.endpoint());
+        CHECK(sock.remote_endpoint() == good.endpoint());
+        CHECK(elapsed >= 50ms);
+        CHECK(elapsed < 1s);
+    }
+
+    SECTION("a refused address starts the next attempt at once")
+    {
+        state.set_connect_options({ .attempt_delay = 10s });
+        auto elapsed = run({ refused(ioc, loopback(3)), good.endpoint() });
+        REQUIRE(not run_exception);
+        CHECK(run_result == good.endpoint());
+        CHECK(elapsed < 1s);
+    }
+
+    SECTION("an attempt which takes too long times out")
+    {
+        state.set_connect_options({ .attempt_timeout = 100ms });
+        auto elapsed = run({ hole.endpoint() });
+        CHECK(error() == net::error::timed_out);
+        CHECK(not sock.is_open());
+        CHECK(elapsed < 1s);
+    }
+
+    SECTION("the last error is reported when every attempt fails")
+    {
+        run({ refused(ioc, loopback(3)), refused(ioc, loopback(4)) });
+        CHECK(error() == net::error::connection_refused);
+    }
+
+    SECTION("cancel abandons every attempt")
+    {
+        state.set_connect_options({ .attempt_delay = 0s });
+        auto timer = net::steady_timer(ioc, 20ms);
+        timer.async_wait([&](error_code) { state.cancel(); });
+        run({ hole.endpoint(), hole.endpoint() });
+        CHECK(error() == net::error::operation_aborted);
+        CHECK(not sock.is_open());
+    }
+}
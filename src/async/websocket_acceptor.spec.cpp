@@ -0,0 +1,123 @@
+#include <catch2/catch.hpp>
+#include <notstd/util/async/websocket_acceptor.hpp>
+#include <thread>
+
+using namespace notstd::util;
+using namespace std::literals;
+
+namespace
+{
+    using executor_type = net::io_context::executor_type;
+    using socket_type = net::basic_stream_socket< net::ip::tcp, executor_type >;
+    using client_type = websocket::stream< socket_type >;
+    using acceptor_type = async::websocket_acceptor< socket_type >;
+    using state_type    = acceptor_type::state_type;
+
+    // a client which sends one message, then reads until the connection
+    // ends, recording the echo and how the connection ended
+    struct client
+    {
+        client(net::io_context &ioc)
+        : ws(ioc.get_executor())
+        {
+        }
+
+        auto run(net::ip::tcp::endpoint ep, std::string message)
+            -> net::awaitable< void, executor_type >
+        {
+            auto const use_awaitable = net::use_awaitable_t< executor_type >();
+            co_await ws.next_layer().async_connect(ep, use_awaitable);
+            co_await ws.async_handshake("localhost", "/", use_awaitable);
+            co_await ws.async_write(net::buffer(message), use_awaitable);
+            auto buf = beast::flat_buffer();
+            co_await ws.async_read(buf, use_awaitable);
+            echo = beast::buffers_to_string(buf.data());
+            buf.consume(buf.size());
+            auto ec = error_code();
+            co_await ws.async_read(buf, net::redirect_error(use_awaitable, ec));
+            ended = ec;
+        }
+
+        client_type ws;
+        std::string echo;
+        error_code  ended;
+    };
+}   // namespace
+
+TEST_CASE("notstd::util::async::websocket_acceptor",
+          "[notstd::util::async::websocket_acceptor]")
+{
+    auto threads  = io_context_pool(2);
+    auto acceptor = std::make_unique< acceptor_type >(
+        threads,
+        net::ip::tcp::endpoint(net::ip::address_v4::loopback(), 0),
+        acceptor_type::options { .max_accept_batch = 4 });
+
+    acceptor->start([](state_type &state) -> state_type::awaitable {
+        co_await state([&state](std::span< char > text) {
+            state.send_text(std::string(text.begin(), text.end()));
+        });
+    });
+
+    auto ioc     = net::io_context(1);
+    auto clients = std::vector< std::unique_ptr< client > >();
+    for (int i = 0; i < 32; ++i)
+    {
+        auto &c = *clients.emplace_back(std::make_unique< client >(ioc));
+        net::co_spawn(ioc,
+                      c.run(acceptor->local_endpoint(), std::to_string(i)),
+                      net::detached);
+    }
+
+    // run the clients until every echo is back
+    auto echoed = [&] {
+        return std::all_of(clients.begin(), clients.end(), [](auto &c) {
+            return not c->echo.empty();
+        });
+    };
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (not echoed() and std::chrono::steady_clock::now() < deadline)
+        ioc.run_one_for(10ms);
+
+    REQUIRE(echoed());
+    for (std::size_t i = 0; i < clients.size(); ++i)
+        CHECK(clients[i]->echo == std::to_string(i));
+    CHECK(acceptor->accepted() == 32);
+    CHECK(acceptor->established() == 32);
+
+    SECTION("stopping closes every connection")
+    {
+        auto closer = std::thread([&] { acceptor.reset(); });
+        ioc.run_for(2s);
+        closer.join();
+        for (auto &c : clients)
+            CHECK(c->ended == websocket::error::closed);
+    }
+}
+
+TEST_CASE("notstd::util::async::websocket_acceptor stopped while accepting",
+          "[notstd::util::async::websocket_acceptor]")
+{
+    // connections still being accepted when the acceptor is destroyed must
+    // be waited for
+    for (int round = 0; round < 20; ++round)
+    {
+        auto threads  = io_context_pool(2);
+        auto acceptor = std::make_unique< acceptor_type >(
+            threads,
+            net::ip::tcp::endpoint(net::ip::address_v4::loopback(), 0),
+            acceptor_type::options {});
+        acceptor->start([](state_type &state) -> state_type::awaitable {
+            co_await state([](std::span< char >) {});
+        });
+
+        auto ioc     = net::io_context(1);
+        auto sockets = std::vector< socket_type >();
+        for (int i = 0; i < 16; ++i)
+            sockets.emplace_back(ioc.get_executor())
+                .async_connect(acceptor->local_endpoint(), [](error_code) {});
+        ioc.run_for(std::chrono::milliseconds(round % 4));
+        acceptor.reset();
+        CHECK(not acceptor);
+    }
+}
@@ -0,0 +1,175 @@
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <list>
+#include <mutex>
+#include <notstd/util/async/websocket_client_pool.hpp>
+#include <thread>
+
+using namespace notstd::util;
+using namespace std::literals;
+
+namespace
+{
+    using executor_type = net::io_context::executor_type;
+    using socket_type = net::basic_stream_socket< net::ip::tcp, executor_type >;
+
+    // a loopback websocket server on its own thread which echoes every frame
+    struct echo_server
+    {
+        echo_server()
+        : acceptor(ioc, { net::ip::address_v4::loopback(), 0 })
+        {
+            net::co_spawn(ioc.get_executor(), accept(), net::detached);
+            thread = std::thread([this] { ioc.run(); });
+        }
+
+        ~echo_server()
+        {
+            ioc.stop();
+            thread.join();
+        }
+
+        auto port() const -> std::string
+        {
+            return std::to_string(acceptor.local_endpoint().port());
+        }
+
+        // drop every connection without a closing handshake
+        auto drop_all() -> void
+        {
+            net::post(ioc, [this] {
+                for (auto &ws : sessions)
+                    beast::get_lowest_layer(ws).close();
+            });
+        }
+
+        auto accept() -> net::awaitable< void, executor_type >
+        {
+            auto const use_awaitable = net::use_awaitable_t< executor_type >();
+            for (;;)
+            {
+                auto &ws = sessions.emplace_back(ioc.get_executor());
+                co_await acceptor.async_accept(ws.next_layer(), use_awaitable);
+                ++accepted;
+                net::co_spawn(ioc.get_executor(), echo(ws), net::detached);
+            }
+        }
+
+        auto echo(websocket::stream< socket_type > &ws)
+            -> net::awaitable< void, executor_type >
+        {
+            auto const use_awaitable = net::use_awaitable_t< executor_type >();
+            co_await ws.async_accept(use_awaitable);
+            auto buf = beast::flat_buffer();
+            for (;;)
+            {
+                co_await ws.async_read(buf, use_awaitable);
+                ws.text(ws.got_text());
+                co_await ws.async_write(buf.data(), use_awaitable);
+                buf.consume(buf.size());
+            }
+        }
+
+        net::io_context                                ioc { 1 };
+        net::ip::tcp::acceptor                         acceptor;
+        std::list< websocket::stream< socket_type > > sessions;
+        std::atomic< std::size_t >                     accepted { 0 };
+        std::thread                                    thread;
+    };
+
+    template < class Pred >
+    auto eventually(Pred pred) -> bool
+    {
+        auto const deadline = std::chrono::steady_clock::now() + 5s;
+        while (not pred())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+            std::this_thread::sleep_for(1ms);
+        }
+        return true;
+    }
+}   // namespace
+
+TEST_CASE("notstd::util::async::websocket_client_pool",
+          "[notstd::util::async::websocket_client_pool]")
+{
+    auto server  = echo_server();
+    auto threads = io_context_pool(2);
+
+    using pool_type = async::websocket_client_pool< socket_type >;
+    auto opts       = pool_type::options {
+        .connections = 4,
+        .reconnect   = backoff_policy { .initial = 10ms, .max = 100ms }
+    };
+
+    auto mutex    = std::mutex();
+    auto received = std::vector< std::string >();
+    auto on_text  = [&](std::span< char > s) {
+        auto lock = std::lock_guard(mutex);
+        received.emplace_back(s.begin(), s.end());
+    };
+    auto count = [&] {
+        auto lock = std::lock_guard(mutex);
+        return received.size();
+    };
+
+    auto pool = pool_type(threads, opts);
+    CHECK_THROWS_AS(pool.send_text("early"), system_error);
+
+    pool.start("127.0.0.1", server.port(), "/", on_text);
+    REQUIRE(eventually([&] { return pool.connected() == 4; }));
+    CHECK(server.accepted == 4);
+
+    SECTION("frames are spread over the members and all arrive")
+    {
+        for (int i = 0; i < 200; ++i)
+            pool.send_text(std::string(100, 'x'));
+        REQUIRE(eventually([&] { return count() == 200; }));
+        for (std::size_t i = 0; i < pool.size(); ++i)
+            CHECK(eventually([&] { return pool.outstanding_bytes(i) == 0; }));
+    }
+
+    SECTION("frames with the same key arrive in order")
+    {
+        for (int i = 0; i < 100; ++i)
+            pool.send_text_by_key("BTC-USD"s, std::to_string(i));
+        REQUIRE(eventually([&] { return count() == 100; }));
+        auto lock = std::lock_guard(mutex);
+        for (int i = 0; i < 100; ++i)
+            CHECK(received[i] == std::to_string(i));
+    }
+
+    SECTION("members reconnect after their connections drop")
+    {
+        server.drop_all();
+        REQUIRE(eventually([&] { return server.accepted == 8; }));
+        REQUIRE(eventually([&] { return pool.connected() == 4; }));
+        pool.send_text("after");
+        CHECK(eventually([&] { return count() == 1; }));
+    }
+
+    SECTION("nothing may be sent once stopped")
+    {
+        pool.stop();
+        REQUIRE(eventually([&] { return pool.connected() == 0; }));
+        CHECK_THROWS_AS(pool.send_text_by_key("BTC-USD"s, "late"),
+                        system_error);
+    }
+}
+
+TEST_CASE("notstd::util::async::websocket_client_pool destroyed with sends "
+          "queued",
+          "[notstd::util::async::websocket_client_pool]")
+{
+    auto threads = io_context_pool(2);
+
+    // sends posted to the members must run before the members are freed
+    using pool_type = async::websocket_client_pool< socket_type >;
+    for (int round = 0; round < 20; ++round)
+    {
+        auto pool = pool_type(threads, pool_type::options { .connections = 4 });
+        for (int i = 0; i < 100; ++i)
+            pool.send_text_by_key(i, std::to_string(i));
+    }
+}
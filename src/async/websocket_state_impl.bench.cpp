@@ -0,0 +1,386 @@
+#include "testing/allocation_counter.hpp"
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <functional>
+#include <notstd/util/async/websocket_state_impl.hpp>
+#include <string>
+#include <vector>
+
+using namespace notstd::util;
+using namespace notstd::util::async;
+using notstd::util::testing::allocation_counter;
+
+namespace
+{
+    using executor_type = net::io_context::executor_type;
+    using socket_type = net::basic_stream_socket< net::ip::tcp, executor_type >;
+    using clock_type  = std::chrono::steady_clock;
+
+    constexpr std::size_t burst_size   = 256;
+    constexpr std::size_t message_size = 64;
+
+    // a text message carrying its send time, padded to message_size
+    auto make_message(clock_type::time_point t) -> std::string
+    {
+        auto s = std::to_string(t.time_since_epoch().count());
+        s.resize(message_size, ' ');
+        return s;
+    }
+
+    auto sent_at(std::string_view message) -> clock_type::time_point
+    {
+        auto ticks = std::stoll(std::string(message.substr(0, 20)));
+        return clock_type::time_point(clock_type::duration(ticks));
+    }
+
+    // a websocket server on the loopback interface which records the
+    // latency of every text message it receives, and counts binary messages
+    struct loopback_server
+    {
+        loopback_server(net::io_context &ioc)
+        : acceptor_(ioc,
+                    net::ip::tcp::endpoint(net::ip::address_v4::loopback(),
+                                           0))
+        , ws_(ioc)
+        {
+        }
+
+        auto port() const -> std::string
+        {
+            return std::to_string(acceptor_.local_endpoint().port());
+        }
+
+        void start()
+        {
+            acceptor_.async_accept(ws_.next_layer(), [this](error_code ec) {
+                if (ec)
+                    return;
+                ws_.async_accept([this](error_code ec) {
+                    if (not ec)
+                        read();
+                });
+            });
+        }
+
+        // send count binary frames of the given payload, one at a time
+        void send(std::size_t count, std::string const &payload)
+        {
+            if (count == 0)
+                return;
+            ws_.binary(true);
+            ws_.async_write(net::buffer(payload),
+                            [this, count, &payload](error_code ec,
+                                                    std::size_t) {
+                                if (not ec)
+                                    send(count - 1, payload);
+                            });
+        }
+
+        void read()
+        {
+            ws_.async_read(rxbuf_, [this](error_code ec, std::size_t) {
+                if (ec)
+                    return;
+                if (ws_.got_text())
+                {
+                    auto now  = clock_type::now();
+                    auto text = beast::buffers_to_string(rxbuf_.data());
+                    latencies_.push_back(now - sent_at(text));
+                }
+                else
+                    ++binary_received_;
+                rxbuf_.consume(rxbuf_.size());
+                read();
+            });
+        }
+
+        net::ip::tcp::acceptor              acceptor_;
+        websocket::stream< socket_type >    ws_;
+        beast::flat_buffer                  rxbuf_;
+        std::vector< clock_type::duration > latencies_;
+        std::size_t                         binary_received_ = 0;
+    };
+
+    // bursts of small text frames sent through websocket_state_impl to a
+    // server on the same io_context. state.range(0) is the most frames
+    // coalesced into one write; 1 disables coalescing
+    void websocket_state_impl_send_burst(benchmark::State &state)
+    {
+        auto ioc    = net::io_context(1);
+        auto server = loopback_server(ioc);
+        auto ws     = websocket_state_impl< socket_type >(ioc.get_executor());
+        server.start();
+
+        auto opts                 = decltype(ws)::write_options();
+        opts.max_frames_per_batch = std::size_t(state.range(0));
+        ws.set_write_options(opts);
+
+        auto run_done = false;
+        net::co_spawn(
+            ioc.get_executor(),
+            [&]() -> net::awaitable< void, executor_type > {
+                co_await ws([](std::span< char >) {});
+            },
+            [&](std::exception_ptr) { run_done = true; });
+
+        auto connected = false;
+        net::co_spawn(
+            ioc.get_executor(),
+            [&]() -> net::awaitable< void, executor_type > {
+                co_await ws.connect("127.0.0.1", server.port(), "/");
+            },
+            [&](std::exception_ptr ep) {
+                if (ep)
+                    state.SkipWithError("connect failed");
+                connected = true;
+            });
+        while (not connected)
+            ioc.run_one();
+
+        for (auto _ : state)
+        {
+            auto expected = server.latencies_.size() + burst_size;
+            for (std::size_t i = 0; i < burst_size; ++i)
+                ws.send_text(make_message(clock_type::now()));
+            while (server.latencies_.size() < expected)
+                ioc.run_one();
+        }
+        state.SetItemsProcessed(state.iterations() * burst_size);
+
+        auto &l = server.latencies_;
+        if (not l.empty())
+        {
+            auto p99 = l.begin() + std::ptrdiff_t(l.size() * 99 / 100);
+            std::nth_element(l.begin(), p99, l.end());
+            state.counters["p99_us"] =
+                std::chrono::duration< double, std::micro >(*p99).count();
+        }
+
+        ws.close();
+        while (not run_done)
+            ioc.run_one();
+    }
+
+    // the latency of a text message queued behind a burst of 4 KiB binary
+    // frames, sent in the bulk lane or, if state.range(0) is non-zero, the
+    // urgent lane
+    void websocket_state_impl_urgent_behind_bulk(benchmark::State &state)
+    {
+        auto const priority =
+            state.range(0) ? send_priority::urgent : send_priority::bulk;
+        auto const bulk = std::string(4 * 1024, 'x');
+
+        auto ioc    = net::io_context(1);
+        auto server = loopback_server(ioc);
+        auto ws     = websocket_state_impl< socket_type >(ioc.get_executor());
+        server.start();
+
+        auto run_done = false;
+        net::co_spawn(
+            ioc.get_executor(),
+            [&]() -> net::awaitable< void, executor_type > {
+                co_await ws([](std::span< char >) {});
+            },
+            [&](std::exception_ptr) { run_done = true; });
+
+        auto connected = false;
+        net::co_spawn(
+            ioc.get_executor(),
+            [&]() -> net::awaitable< void, executor_type > {
+                co_await ws.connect("127.0.0.1", server.port(), "/");
+            },
+            [&](std::exception_ptr ep) {
+                if (ep)
+                    state.SkipWithError("connect failed");
+                connected = true;
+            });
+        while (not connected)
+            ioc.run_one();
+
+        for (auto _ : state)
+        {
+            auto expected = server.binary_received_ + burst_size;
+            for (std::size_t i = 0; i < burst_size; ++i)
+                ws.send_binary(bulk);
+            // let the writer take its first batch, as it would on a busy
+            // connection
+            ioc.poll_one();
+            ws.send_text(make_message(clock_type::now()), priority);
+            while (server.binary_received_ < expected)
+                ioc.run_one();
+        }
+
+        auto &l = server.latencies_;
+        if (not l.empty())
+        {
+            auto p50 = l.begin() + std::ptrdiff_t(l.size() / 2);
+            std::nth_element(l.begin(), p50, l.end());
+            state.counters["p50_us"] =
+                std::chrono::duration< double, std::micro >(*p50).count();
+        }
+
+        ws.close();
+        while (not run_done)
+            ioc.run_one();
+    }
+
+    // a connected websocket_state_impl, reading from a loopback server, with
+    // the given frame handlers
+    template < class OnBinaryFrame >
+    struct loopback_client
+    {
+        loopback_client(net::io_context &ioc, OnBinaryFrame on_binary)
+        : ioc_(ioc)
+        , server_(ioc)
+        , ws_(ioc.get_executor())
+        {
+            server_.start();
+            net::co_spawn(
+                ioc.get_executor(),
+                [this, on_binary]() -> net::awaitable< void, executor_type > {
+                    co_await ws_(websocket_state_impl<
+                                     socket_type >::null_frame_handler(),
+                                 on_binary);
+                },
+                [this](std::exception_ptr) { run_done_ = true; });
+
+            auto connected = false;
+            net::co_spawn(
+                ioc.get_executor(),
+                [this]() -> net::awaitable< void, executor_type > {
+                    co_await ws_.connect("127.0.0.1", server_.port(), "/");
+                },
+                [&](std::exception_ptr) { connected = true; });
+            while (not connected)
+                ioc.run_one();
+        }
+
+        ~loopback_client()
+        {
+            ws_.close();
+            while (not run_done_)
+                ioc_.run_one();
+        }
+
+        net::io_context &                    ioc_;
+        loopback_server                      server_;
+        websocket_state_impl< socket_type > ws_;
+        bool                                 run_done_ = false;
+    };
+
+    // bursts of binary frames of state.range(0) bytes, each of which the
+    // handler keeps beyond the callback, as a fan-out to other threads
+    // would. With a span handler that means a copy; a pooled_buffer handler
+    // keeps the buffer the frame was read into
+    // the per-frame cost of calling the frame handlers, alternating text and
+    // binary frames. Erased holds the handlers in std::function, as the read
+    // loop once did; otherwise they are called directly
+    template < bool Erased >
+    void websocket_state_impl_frame_dispatch(benchmark::State &state)
+    {
+        auto frame  = std::string(64, 'x');
+        auto text   = std::size_t(0);
+        auto binary = std::size_t(0);
+
+        // captures sized like a typical handler's: a session and a router
+        auto session   = &text;
+        auto router    = &binary;
+        auto on_text   = [session, router](std::span< char > f) {
+            *session += f.size();
+            benchmark::DoNotOptimize(router);
+        };
+        auto on_binary = [session, router](std::span< char > f) {
+            *router += f.size();
+            benchmark::DoNotOptimize(session);
+        };
+        using text_handler   = std::conditional_t< Erased,
+                                                 std::function< void(
+                                                     std::span< char >) >,
+                                                 decltype(on_text) >;
+        using binary_handler = std::conditional_t< Erased,
+                                                   std::function< void(
+                                                       std::span< char >) >,
+                                                   decltype(on_binary) >;
+        auto th = text_handler(on_text);
+        auto bh = binary_handler(on_binary);
+
+        auto counter = allocation_counter(state);
+        auto is_text = false;
+        for (auto _ : state)
+        {
+            is_text = not is_text;
+            async::detail::dispatch_frame(
+                is_text, std::span< char >(frame), th, bh);
+        }
+        benchmark::DoNotOptimize(text);
+        benchmark::DoNotOptimize(binary);
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    template < bool Pooled >
+    void websocket_state_impl_receive_burst(benchmark::State &state)
+    {
+        auto const payload = std::string(std::size_t(state.range(0)), 'x');
+
+        auto ioc      = net::io_context(1);
+        auto received = std::size_t(0);
+        auto kept     = std::vector< std::string >(burst_size);
+        auto kept_buf = std::vector< pooled_buffer >(burst_size);
+        auto on_span  = [&](std::span< char > frame) {
+            kept[received++ % burst_size].assign(frame.begin(), frame.end());
+        };
+        auto on_pooled = [&](pooled_buffer frame) {
+            kept_buf[received++ % burst_size] = std::move(frame);
+        };
+        using handler_type = std::
+            conditional_t< Pooled, decltype(on_pooled), decltype(on_span) >;
+        auto client = loopback_client< handler_type >(ioc, [&] {
+            if constexpr (Pooled)
+                return on_pooled;
+            else
+                return on_span;
+        }());
+
+        for (auto _ : state)
+        {
+            auto expected = received + burst_size;
+            client.server_.send(burst_size, payload);
+            while (received < expected)
+                ioc.run_one();
+        }
+        state.SetItemsProcessed(state.iterations() * burst_size);
+        state.SetBytesProcessed(state.iterations() * burst_size *
+                                payload.size());
+    }
+
+    BENCHMARK(websocket_state_impl_send_burst)
+        ->Name("websocket_state_impl/send_burst")
+        ->Arg(1)
+        ->Arg(64)
+        ->UseRealTime();
+
+    BENCHMARK(websocket_state_impl_urgent_behind_bulk)
+        ->Name("websocket_state_impl/urgent_behind_bulk")
+        ->ArgName("urgent")
+        ->Arg(0)
+        ->Arg(1)
+        ->UseRealTime();
+
+    BENCHMARK_TEMPLATE(websocket_state_impl_frame_dispatch, true)
+        ->Name("websocket_state_impl/frame_dispatch/erased");
+    BENCHMARK_TEMPLATE(websocket_state_impl_frame_dispatch, false)
+        ->Name("websocket_state_impl/frame_dispatch/direct");
+
+    BENCHMARK_TEMPLATE(websocket_state_impl_receive_burst, false)
+        ->Name("websocket_state_impl/receive_burst/copy")
+        ->Arg(256)
+        ->Arg(16 * 1024)
+        ->UseRealTime();
+    BENCHMARK_TEMPLATE(websocket_state_impl_receive_burst, true)
+        ->Name("websocket_state_impl/receive_burst/pooled")
+        ->Arg(256)
+        ->Arg(16 * 1024)
+        ->UseRealTime();
+}   // namespace
@@ -2,6 +2,115 @@
 #include <notstd/util/async/websocket_state_impl.hpp>
 
 using namespace notstd::util;
+using namespace std::literals;
+
+namespace
+{
+    using executor_type = net::io_context::executor_type;
+    using socket_type = net::basic_stream_socket< net::ip::tcp, executor_type >;
+    using loopback_state_type = async::websocket_state_impl< socket_type >;
+    using peer_type           = websocket::stream< socket_type >;
+
+    // a state connected over loopback to a plain websocket stream, which the
+    // test may leave unread
+    struct loopback
+    {
+        loopback()
+        : acceptor(ioc, { net::ip::address_v4::loopback(), 0 })
+        , state(ioc.get_executor())
+        , peer(ioc.get_executor())
+        {
+        }
+
+        // run the state and connect it to the peer, which then reads
+        // everything sent if reading
+        auto start(bool reading = true) -> void
+        {
+            net::co_spawn(ioc,
+                          state(loopback_state_type::null_frame_handler()),
+                          [this](std::exception_ptr ep) {
+                              run_exception = ep;
+                              run_completed = true;
+                          });
+
+            auto connected = false;
+            auto accepted  = false;
+            net::co_spawn(
+                ioc,
+                state.connect(
+                    "127.0.0.1",
+                    std::to_string(acceptor.local_endpoint().port()),
+                    "/"),
+                [&](std::exception_ptr ep) {
+                    REQUIRE(not ep);
+                    connected = true;
+                });
+            acceptor.async_accept(peer.next_layer(), [&](error_code ec) {
+                REQUIRE(not ec);
+                peer.async_accept([&](error_code ec) {
+                    REQUIRE(not ec);
+                    accepted = true;
+                });
+            });
+            REQUIRE(run_until([&] { return connected and accepted; }));
+
+            if (reading)
+                read();
+        }
+
+        // close the state and wait for the run to end
+        auto stop() -> void
+        {
+            state.close(websocket::close_code::normal);
+            REQUIRE(run_until([&] { return run_completed and peer_error; }));
+            CHECK(not run_exception);
+            CHECK(peer_error == websocket::error::closed);
+        }
+
+        // run until pred holds, or for a few seconds
+        template < class Pred >
+        auto run_until(Pred pred) -> bool
+        {
+            auto deadline = std::chrono::steady_clock::now() + 5s;
+            while (not pred() and std::chrono::steady_clock::now() < deadline)
+            {
+                // running out of work stops the context
+                ioc.restart();
+                ioc.run_one_for(10ms);
+            }
+            return pred();
+        }
+
+        auto read() -> void
+        {
+            peer.async_read(rxbuf, [this](error_code ec, std::size_t) {
+                if (ec)
+                {
+                    peer_error = ec;
+                    return;
+                }
+                received.push_back(beast::buffers_to_string(rxbuf.data()));
+                binary.push_back(peer.got_binary());
+                rxbuf.consume(rxbuf.size());
+                read();
+            });
+        }
+
+        net::io_context        ioc { 1 };
+        net::ip::tcp::acceptor acceptor;
+        loopback_state_type    state;
+        peer_type              peer;
+
+        std::exception_ptr run_exception = nullptr;
+        bool               run_completed = false;
+
+        // what the peer has read, and how its reading ended
+        beast::flat_buffer         rxbuf;
+        std::vector< std::string > received;
+        std::vector< bool >        binary;
+        error_code                 peer_error;
+    };
+}   // namespace
 
 TEST_CASE("notstd::util::async::websocket_state_impl")
 {
@@ -39,7 +148,7 @@ TEST_CASE("notstd::util::async::websocket_state_impl")
         run_completed = false;
         net::co_spawn(
             ioc.get_executor(),
-            [&]() -> state_type::run_awaitable {
+            [&]() -> state_type::awaitable {
                 auto my_exec = co_await net::this_coro::executor;
                 REQUIRE(my_exec == state.get_executor());
 
@@ -69,7 +178,7 @@ TEST_CASE("notstd::util::async::websocket_state_impl")
 
         net::co_spawn(
             ioc.get_executor(),
-            [&]() -> state_type::run_awaitable {
+            [&]() -> state_type::awaitable {
                 auto my_exec = co_await net::this_coro::executor;
                 REQUIRE(my_exec == state.get_executor());
 
@@ -99,4 +208,204 @@ TEST_CASE("notstd::util::async::websocket_state_impl")
             CHECK(run_completed);
         }
         */
-}
\ No newline at end of file
+}
+
+TEST_CASE("notstd::util::async::websocket_state_impl closed while writing",
+          "[notstd::util::async::websocket_state_impl]")
+{
+    auto lo = loopback();
+    lo.peer.read_message_max(64 * 1024 * 1024);
+    lo.start(false);
+
+    // too big for the socket buffers, so the writer is held up in the
+    // first frame until the peer reads
+    auto const big     = std::string(32 * 1024 * 1024, 'x');
+    auto       results = std::vector< error_code >();
+    for (int i = 0; i < 3; ++i)
+        lo.state.async_send_text(
+            big, [&](error_code ec) { results.push_back(ec); });
+    auto const until = std::chrono::steady_clock::now() + 50ms;
+    lo.run_until([&] { return std::chrono::steady_clock::now() >= until; });
+    REQUIRE(results.empty());
+
+    // the writer starts nothing after the frame in hand. Beast may send the
+    // close between that frame's fragments, failing it too
+    lo.read();
+    lo.stop();
+    REQUIRE(lo.run_until([&] { return results.size() == 3; }));
+    CHECK(results[1] == net::error::operation_aborted);
+    CHECK(results[2] == net::error::operation_aborted);
+    CHECK(lo.received.size() == (results[0] ? 0 : 1));
+}
+
+TEST_CASE("notstd::util::async::websocket_state_impl async sends",
+          "[notstd::util::async::websocket_state_impl]")
+{
+    auto lo        = loopback();
+    auto completed = std::vector< std::string >();
+    auto on_sent   = [&](std::string name) {
+        return [&, name](error_code ec) {
+            CHECK(not ec);
+            completed.push_back(name);
+        };
+    };
+
+    // nothing may be sent until connected
+    auto early = error_code();
+    lo.state.async_send_text("early", [&](error_code ec) { early = ec; });
+    REQUIRE(lo.run_until([&] { return bool(early); }));
+    CHECK(early == net::error::not_connected);
+
+    lo.start();
+
+    SECTION("a send completes once its frame is written")
+    {
+        lo.state.async_send_text("one", on_sent("one"));
+        lo.state.async_send_binary("two", async::send_priority::bulk, on_sent("two"));
+        CHECK(lo.state.outstanding_bytes() == 6);
+
+        REQUIRE(lo.run_until([&] { return completed.size() == 2; }));
+        CHECK(completed == std::vector< std::string > { "one", "two" });
+        CHECK(lo.state.outstanding_bytes() == 0);
+
+        REQUIRE(lo.run_until([&] { return lo.received.size() == 2; }));
+        CHECK(lo.received == std::vector< std::string > { "one", "two" });
+    }
+
+    SECTION("the high water mark holds frames back in order")
+    {
+        lo.state.set_write_options({ .high_water_mark = 4 });
+
+        // over the mark, so the async sends after it are held back and do
+        // not count as outstanding
+        lo.state.send_text("plug!!");
+        lo.state.async_send_text("a", on_sent("a"));
+        lo.state.async_send_text("b", on_sent("b"));
+        CHECK(lo.state.outstanding_bytes() == 6);
+
+        REQUIRE(lo.run_until([&] { return completed.size() == 2; }));
+        CHECK(completed == std::vector< std::string > { "a", "b" });
+        CHECK(lo.state.outstanding_bytes() == 0);
+
+        REQUIRE(lo.run_until([&] { return lo.received.size() == 3; }));
+        CHECK(lo.received ==
+              std::vector< std::string > { "plug!!", "a", "b" });
+    }
+
+    lo.stop();
+
+    auto late = error_code();
+    lo.state.async_send_text("late", [&](error_code ec) { late = ec; });
+    REQUIRE(lo.run_until([&] { return bool(late); }));
+    CHECK(late == net::error::not_connected);
+}
+
+TEST_CASE("notstd::util::async::websocket_state_impl pings",
+          "[notstd::util::async::websocket_state_impl]")
+{
+    auto lo = loopback();
+
+    SECTION("pings go out every interval and their pongs are timed")
+    {
+        lo.state.set_keepalive_options({ .ping_interval = 20ms });
+
+        auto pings = 0;
+        lo.peer.control_callback(
+            [&](websocket::frame_type kind, beast::string_view) {
+                if (kind == websocket::frame_type::ping)
+                    ++pings;
+            });
+        auto const start = std::chrono::steady_clock::now();
+        lo.start();
+        REQUIRE(lo.run_until([&] { return pings == 3; }));
+        CHECK(std::chrono::steady_clock::now() - start >= 60ms);
+
+        REQUIRE(lo.run_until(
+            [&] { return lo.state.round_trip_times().count() >= 3; }));
+        CHECK(lo.state.round_trip_times().max() < 1s);
+
+        lo.stop();
+    }
+
+    SECTION("a peer which never reads is failed after the idle timeout")
+    {
+        lo.state.set_keepalive_options({ .idle_timeout = 100ms });
+        auto const start = std::chrono::steady_clock::now();
+        lo.start(false);
+        REQUIRE(lo.run_until([&] { return lo.run_completed; }));
+        CHECK(std::chrono::steady_clock::now() - start >= 100ms);
+        CHECK(not lo.state.connected());
+    }
+}
+
+TEST_CASE("notstd::util::async::websocket_state_impl send lanes",
+          "[notstd::util::async::websocket_state_impl]")
+{
+    auto lo = loopback();
+    lo.start();
+
+    // the idle writer takes the first frame at once. The rest queue, and
+    // the urgent ones overtake the bulk
+    lo.state.send_text("b1");
+    lo.state.send_text("b2");
+    lo.state.send_text("u1", async::send_priority::urgent);
+    lo.state.send_text("b3");
+    lo.state.send_text("u2", async::send_priority::urgent);
+    CHECK(lo.state.queue_depth(async::send_priority::bulk) == 2);
+    CHECK(lo.state.queue_depth(async::send_priority::urgent) == 2);
+
+    REQUIRE(lo.run_until([&] { return lo.received.size() == 5; }));
+    CHECK(lo.received ==
+          std::vector< std::string > { "b1", "u1", "u2", "b2", "b3" });
+    CHECK(lo.state.queue_depth(async::send_priority::bulk) == 0);
+    CHECK(lo.state.queue_depth(async::send_priority::urgent) == 0);
+
+    lo.stop();
+    CHECK(lo.state.queue_depth(async::send_priority::bulk) == 0);
+}
+
+TEST_CASE("notstd::util::async::websocket_state_impl urgent within the "
+          "latency budget",
+          "[notstd::util::async::websocket_state_impl]")
+{
+    auto lo = loopback();
+    lo.state.set_write_options({ .latency_budget = 2s });
+    lo.start();
+
+    // the writer takes b1 and waits out the budget for stragglers
+    lo.state.send_text("b1");
+    auto const until = std::chrono::steady_clock::now() + 50ms;
+    lo.run_until([&] { return std::chrono::steady_clock::now() >= until; });
+    REQUIRE(lo.received.empty());
+
+    // an urgent frame ends the wait, and goes ahead of the batch
+    auto const start = std::chrono::steady_clock::now();
+    lo.state.send_text("b2");
+    lo.state.send_text("u1", async::send_priority::urgent);
+    REQUIRE(lo.run_until([&] { return lo.received.size() == 3; }));
+    CHECK(std::chrono::steady_clock::now() - start < 1s);
+    CHECK(lo.received == std::vector< std::string > { "u1", "b1", "b2" });
+
+    lo.stop();
+}
+
+TEST_CASE("notstd::util::async::websocket_state_impl text and binary",
+          "[notstd::util::async::websocket_state_impl]")
+{
+    auto lo = loopback();
+    lo.start();
+
+    // queued together, so that they are written as one batch
+    lo.state.send_text("t1");
+    lo.state.send_binary("b1");
+    lo.state.send_binary("b2");
+    lo.state.send_text("t2");
+    lo.state.send_binary("b3");
+
+    REQUIRE(lo.run_until([&] { return lo.received.size() == 5; }));
+    CHECK(lo.received ==
+          std::vector< std::string > { "t1", "b1", "b2", "t2", "b3" });
+    CHECK(lo.binary == std::vector< bool > { false, true, true, false, true });
+
+    lo.stop();
+}
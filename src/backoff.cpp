@@ -0,0 +1,43 @@
+#include <algorithm>
+#include <notstd/util/backoff.hpp>
+
+namespace notstd::util
+{
+    backoff::backoff(backoff_policy policy)
+    : backoff(policy, std::random_device()())
+    {
+    }
+
+    backoff::backoff(backoff_policy policy, std::uint64_t seed)
+    : policy_(policy)
+    , limit_(policy.initial)
+    , rng_(std::mt19937::result_type(seed))
+    {
+    }
+
+    auto backoff::next() -> duration
+    {
+        auto const limit  = std::min(limit_, policy_.max);
+        auto const jitter = std::clamp(policy_.jitter, 0.0, 1.0);
+        auto const random =
+            std::uniform_real_distribution< double >(0.0, jitter)(rng_);
+        auto const delay =
+            duration(duration::rep(double(limit.count()) * (1.0 - random)));
+
+        // grow in floating point, so that the limit saturates at max rather
+        // than overflowing
+        auto const grown = double(limit.count()) * policy_.multiplier;
+        limit_           = grown >= double(policy_.max.count())
+                               ? policy_.max
+                               : duration(duration::rep(grown));
+        ++attempts_;
+        return delay;
+    }
+
+    auto backoff::reset() -> void
+    {
+        limit_    = policy_.initial;
+        attempts_ = 0;
+    }
+
+}   // namespace notstd::util
@@ -0,0 +1,54 @@
+#include <catch2/catch.hpp>
+#include <notstd/util/backoff.hpp>
+
+using namespace notstd::util;
+using namespace std::literals;
+
+TEST_CASE("notstd::util::backoff", "[notstd::util::backoff]")
+{
+    SECTION("without jitter, delays double up to the maximum")
+    {
+        auto b = backoff(backoff_policy { .initial = 100ms,
+                                          .max     = 1s,
+                                          .jitter  = 0.0 });
+        CHECK(b.next() == 100ms);
+        CHECK(b.next() == 200ms);
+        CHECK(b.next() == 400ms);
+        CHECK(b.next() == 800ms);
+        CHECK(b.next() == 1s);
+        CHECK(b.next() == 1s);
+        CHECK(b.attempts() == 6);
+
+        b.reset();
+        CHECK(b.attempts() == 0);
+        CHECK(b.next() == 100ms);
+    }
+
+    SECTION("jitter takes up to its fraction off each delay")
+    {
+        auto b = backoff(backoff_policy { .initial = 1s,
+                                          .max     = 1s,
+                                          .jitter  = 0.25 },
+                         42);
+        auto lowest  = backoff::duration::max();
+        auto highest = backoff::duration::zero();
+        for (int i = 0; i < 1000; ++i)
+        {
+            auto d  = b.next();
+            lowest  = std::min(lowest, d);
+            highest = std::max(highest, d);
+        }
+        CHECK(lowest >= 750ms);
+        CHECK(lowest < 760ms);
+        CHECK(highest <= 1s);
+        CHECK(highest > 990ms);
+    }
+
+    SECTION("equal seeds give equal delays")
+    {
+        auto a = backoff(backoff_policy { .jitter = 1.0 }, 7);
+        auto b = backoff(backoff_policy { .jitter = 1.0 }, 7);
+        for (int i = 0; i < 10; ++i)
+            CHECK(a.next() == b.next());
+    }
+}
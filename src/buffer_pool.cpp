@@ -0,0 +1,147 @@
+#include <atomic>
+#include <boost/smart_ptr/intrusive_ref_counter.hpp>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <notstd/util/buffer_pool.hpp>
+#include <vector>
+
+namespace notstd::util::detail
+{
+    struct pooled_block
+    {
+        std::atomic< std::size_t > refs { 0 };
+        beast::flat_buffer         buffer;
+
+        // the owning pool, held only while the block is in use so that idle
+        // blocks do not keep their pool alive
+        boost::intrusive_ptr< buffer_pool_impl > pool;
+    };
+
+    struct buffer_pool_impl
+    : boost::intrusive_ref_counter< buffer_pool_impl,
+                                    boost::thread_safe_counter >
+    {
+        buffer_pool_impl(std::size_t max_idle, std::size_t max_idle_capacity)
+        : max_idle_(max_idle)
+        , max_idle_capacity_(max_idle_capacity)
+        {
+        }
+
+        auto acquire() -> pooled_buffer
+        {
+            auto block = std::unique_ptr< pooled_block >();
+            {
+                auto lock = std::scoped_lock(mutex_);
+                if (not idle_.empty())
+                {
+                    block = std::move(idle_.back());
+                    idle_.pop_back();
+                }
+            }
+            if (not block)
+                block = std::make_unique< pooled_block >();
+
+            block->pool = this;
+            block->refs.store(1, std::memory_order_relaxed);
+            return pooled_buffer(block.release());
+        }
+
+        static auto release(pooled_block *block) -> void
+        {
+            if (block->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                return;
+
+            // keep the pool alive until the block has been returned to it
+            auto pool = std::move(block->pool);
+            block->buffer.clear();
+            if (block->buffer.capacity() > pool->max_idle_capacity_)
+                block->buffer.shrink_to_fit();
+
+            auto owned = std::unique_ptr< pooled_block >(block);
+            auto lock  = std::scoped_lock(pool->mutex_);
+            if (pool->idle_.size() < pool->max_idle_)
+                pool->idle_.push_back(std::move(owned));
+        }
+
+        auto idle() const -> std::size_t
+        {
+            auto lock = std::scoped_lock(mutex_);
+            return idle_.size();
+        }
+
+      private:
+        mutable std::mutex                             mutex_;
+        std::vector< std::unique_ptr< pooled_block > > idle_;
+        std::size_t const                              max_idle_;
+        std::size_t const                              max_idle_capacity_;
+    };
+}   // namespace notstd::util::detail
+
+namespace notstd::util
+{
+    pooled_buffer::pooled_buffer(pooled_buffer const &other) noexcept
+    : block_(other.block_)
+    {
+        if (block_)
+            block_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    pooled_buffer &pooled_buffer::operator=(pooled_buffer const &other) noexcept
+    {
+        auto tmp = pooled_buffer(other);
+        std::swap(block_, tmp.block_);
+        return *this;
+    }
+
+    pooled_buffer &pooled_buffer::operator=(pooled_buffer &&other) noexcept
+    {
+        auto tmp = pooled_buffer(std::move(other));
+        std::swap(block_, tmp.block_);
+        return *this;
+    }
+
+    pooled_buffer::~pooled_buffer()
+    {
+        if (block_)
+            detail::buffer_pool_impl::release(block_);
+    }
+
+    auto pooled_buffer::buffer() -> beast::flat_buffer &
+    {
+        assert(use_count() == 1);
+        return block_->buffer;
+    }
+
+    auto pooled_buffer::data() const -> char const *
+    {
+        return static_cast< char const * >(block_->buffer.data().data());
+    }
+
+    auto pooled_buffer::size() const -> std::size_t
+    {
+        return block_->buffer.size();
+    }
+
+    auto pooled_buffer::use_count() const -> std::size_t
+    {
+        return block_ ? block_->refs.load(std::memory_order_relaxed) : 0;
+    }
+
+    buffer_pool::buffer_pool(std::size_t max_idle,
+                             std::size_t max_idle_capacity)
+    : impl_(new detail::buffer_pool_impl(max_idle, max_idle_capacity))
+    {
+    }
+
+    buffer_pool::buffer_pool(buffer_pool const &other) = default;
+    buffer_pool::buffer_pool(buffer_pool &&other) noexcept = default;
+    buffer_pool &buffer_pool::operator=(buffer_pool const &other) = default;
+    buffer_pool &buffer_pool::operator=(buffer_pool &&other) noexcept = default;
+    buffer_pool::~buffer_pool() = default;
+
+    auto buffer_pool::acquire() -> pooled_buffer { return impl_->acquire(); }
+
+    auto buffer_pool::idle() const -> std::size_t { return impl_->idle(); }
+
+}   // namespace notstd::util
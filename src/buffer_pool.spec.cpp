@@ -0,0 +1,112 @@
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <notstd/util/buffer_pool.hpp>
+#include <notstd/util/net.hpp>
+#include <thread>
+#include <vector>
+
+using namespace notstd::util;
+
+namespace
+{
+    auto fill(pooled_buffer &b, std::string_view s) -> void
+    {
+        auto &buf = b.buffer();
+        auto  mb  = buf.prepare(s.size());
+        net::buffer_copy(mb, net::buffer(s.data(), s.size()));
+        buf.commit(s.size());
+    }
+}   // namespace
+
+TEST_CASE("notstd::util::buffer_pool", "[notstd::util::buffer_pool]")
+{
+    auto pool = buffer_pool(2);
+    CHECK(pool.idle() == 0);
+
+    SECTION("released storage is reused, empty and with its capacity")
+    {
+        auto b = pool.acquire();
+        fill(b, "hello");
+        CHECK(b.view() == "hello");
+        auto const *storage  = b.data();
+        auto const  capacity = b.buffer().capacity();
+
+        b = pooled_buffer();
+        CHECK(pool.idle() == 1);
+
+        auto c = pool.acquire();
+        CHECK(pool.idle() == 0);
+        CHECK(c.size() == 0);
+        CHECK(c.buffer().capacity() == capacity);
+        fill(c, "x");
+        CHECK(c.data() == storage);
+    }
+
+    SECTION("a buffer grown past the idle capacity gives its storage back")
+    {
+        auto big = buffer_pool(2, 1024);
+        auto b   = big.acquire();
+        fill(b, std::string(4096, 'x'));
+        CHECK(b.buffer().capacity() >= 4096);
+
+        b = pooled_buffer();
+        CHECK(big.idle() == 1);
+        auto c = big.acquire();
+        CHECK(c.buffer().capacity() == 0);
+    }
+
+    SECTION("copies share storage, which returns on the last release")
+    {
+        auto b = pool.acquire();
+        fill(b, "shared");
+        auto c = b;
+        CHECK(b.use_count() == 2);
+        CHECK(c.data() == b.data());
+
+        b = pooled_buffer();
+        CHECK(pool.idle() == 0);
+        CHECK(c.view() == "shared");
+        c = pooled_buffer();
+        CHECK(pool.idle() == 1);
+    }
+
+    SECTION("no more than max_idle buffers are kept")
+    {
+        auto bs = std::vector< pooled_buffer >();
+        for (int i = 0; i < 4; ++i)
+            bs.push_back(pool.acquire());
+        bs.clear();
+        CHECK(pool.idle() == 2);
+    }
+
+    SECTION("buffers may outlive the pool handle")
+    {
+        auto b = pool.acquire();
+        fill(b, "survivor");
+        pool = buffer_pool();
+        CHECK(b.view() == "survivor");
+    }
+
+    SECTION("buffers may be released on other threads")
+    {
+        constexpr int per_thread = 1000;
+
+        auto seen    = std::atomic< int >(0);
+        auto threads = std::vector< std::thread >();
+        for (int t = 0; t < 4; ++t)
+            threads.emplace_back([pool, &seen]() mutable {
+                for (int i = 0; i < per_thread; ++i)
+                {
+                    auto b = pool.acquire();
+                    fill(b, "payload");
+                    std::thread([c = std::move(b), &seen] {
+                        seen += c.view() == "payload";
+                    }).join();
+                }
+            });
+        for (auto &t : threads)
+            t.join();
+        CHECK(seen == 4 * per_thread);
+        CHECK(pool.idle() <= 2);
+    }
+}
@@ -0,0 +1,29 @@
+#include <notstd/util/happy_eyeballs.hpp>
+
+namespace notstd::util
+{
+    auto happy_eyeballs_order(std::vector< net::ip::tcp::endpoint > endpoints)
+        -> std::vector< net::ip::tcp::endpoint >
+    {
+        if (endpoints.empty())
+            return endpoints;
+
+        auto const preferred = endpoints.front().protocol();
+        auto       first     = std::vector< net::ip::tcp::endpoint >();
+        auto       second    = std::vector< net::ip::tcp::endpoint >();
+        for (auto &ep : endpoints)
+            (ep.protocol() == preferred ? first : second).push_back(ep);
+
+        auto result = std::vector< net::ip::tcp::endpoint >();
+        result.reserve(endpoints.size());
+        for (std::size_t i = 0; i < first.size() or i < second.size(); ++i)
+        {
+            if (i < first.size())
+                result.push_back(first[i]);
+            if (i < second.size())
+                result.push_back(second[i]);
+        }
+        return result;
+    }
+
+}   // namespace notstd::util
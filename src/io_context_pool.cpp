@@ -0,0 +1,51 @@
+#include <algorithm>
+#include <notstd/util/io_context_pool.hpp>
+
+namespace notstd::util
+{
+    io_context_pool::io_context_pool(std::size_t size)
+    {
+        if (size == 0)
+            size = std::max(1u, std::thread::hardware_concurrency());
+
+        contexts_.reserve(size);
+        work_.reserve(size);
+        threads_.reserve(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            contexts_.push_back(std::make_unique< net::io_context >(1));
+            work_.emplace_back(contexts_.back()->get_executor());
+        }
+        for (auto &ioc : contexts_)
+            threads_.emplace_back([&ctx = *ioc] { ctx.run(); });
+    }
+
+    io_context_pool::~io_context_pool() { stop(); }
+
+    auto io_context_pool::get_executor(std::size_t i) -> executor_type
+    {
+        return contexts_[i % contexts_.size()]->get_executor();
+    }
+
+    auto io_context_pool::release() -> void
+    {
+        for (auto &work : work_)
+            work.reset();
+    }
+
+    auto io_context_pool::stop() -> void
+    {
+        release();
+        for (auto &ioc : contexts_)
+            ioc->stop();
+        join();
+    }
+
+    auto io_context_pool::join() -> void
+    {
+        for (auto &thread : threads_)
+            if (thread.joinable())
+                thread.join();
+    }
+
+}   // namespace notstd::util
@@ -0,0 +1,41 @@
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <notstd/util/io_context_pool.hpp>
+#include <set>
+
+using namespace notstd::util;
+
+TEST_CASE("notstd::util::io_context_pool", "[notstd::util::io_context_pool]")
+{
+    auto pool = io_context_pool(3);
+    REQUIRE(pool.size() == 3);
+    CHECK(pool.get_executor(4) == pool.get_executor(1));
+
+    SECTION("each context runs on its own thread")
+    {
+        auto ids   = std::vector< std::thread::id >(pool.size());
+        auto count = std::atomic< std::size_t >(0);
+        for (std::size_t i = 0; i < pool.size(); ++i)
+            net::post(pool.get_executor(i), [&, i] {
+                ids[i] = std::this_thread::get_id();
+                ++count;
+            });
+        pool.release();
+        pool.join();
+
+        CHECK(count == pool.size());
+        auto distinct = std::set< std::thread::id >(ids.begin(), ids.end());
+        CHECK(distinct.size() == pool.size());
+        CHECK(distinct.count(std::this_thread::get_id()) == 0);
+    }
+
+    SECTION("stop abandons outstanding work")
+    {
+        auto timer = net::steady_timer(pool.get_executor(0));
+        timer.expires_after(std::chrono::hours(1));
+        auto fired = std::atomic< bool >(false);
+        timer.async_wait([&](error_code) { fired = true; });
+        pool.stop();
+        CHECK(not fired);
+    }
+}
@@ -0,0 +1,97 @@
+#include "testing/allocation_counter.hpp"
+
+#include <benchmark/benchmark.h>
+#include <boost/json.hpp>
+#include <fmt/format.h>
+#include <notstd/util/json_rpc/request_map.hpp>
+
+using namespace notstd::util;
+using namespace notstd::util::json_rpc;
+using notstd::util::testing::allocation_counter;
+
+namespace
+{
+    // the outstanding map is flushed with cancel() after this many requests
+    // so that it does not grow without bound
+    constexpr std::int64_t requests_per_flush = 1024;
+
+    auto make_params() -> boost::json::value
+    {
+        return boost::json::value(
+            { { "instrument_name", "BTC-PERPETUAL" }, { "depth", 10 } });
+    }
+
+    // add a request to the map and serialise the resulting frame, as the
+    // connection does before queueing it for the writer
+    void request_map_build(benchmark::State &state)
+    {
+        auto ioc     = net::io_context(1);
+        auto map     = request_map();
+        auto text    = std::string();
+        auto handler = net::bind_executor(ioc.get_executor(),
+                                          [](error_code, remote_result) {});
+
+        auto counter = allocation_counter(state);
+        auto n       = std::int64_t(0);
+        for (auto _ : state)
+        {
+            map.add_async_request(
+                "public/get_order_book",
+                make_params(),
+                [&](boost::json::value frame) {
+                    text = boost::json::serialize(frame);
+                },
+                handler);
+
+            if (++n % requests_per_flush == 0)
+            {
+                state.PauseTiming();
+                map.cancel();
+                ioc.restart();
+                ioc.poll();
+                state.ResumeTiming();
+            }
+        }
+        benchmark::DoNotOptimize(text);
+    }
+
+    // parse a response frame and complete the matching request
+    void request_map_parse(benchmark::State &state)
+    {
+        auto ioc      = net::io_context(1);
+        auto map      = request_map();
+        auto received = std::size_t(0);
+        auto handler  = net::bind_executor(
+            ioc.get_executor(), [&](error_code ec, remote_result r) {
+                if (not ec and r.is_result())
+                    ++received;
+            });
+
+        auto counter = allocation_counter(state);
+        auto id      = std::int64_t(0);
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            map.add_async_request(
+                "public/get_order_book",
+                make_params(),
+                [&](boost::json::value frame) {
+                    id = frame.at("id").as_int64();
+                },
+                handler);
+            auto text = fmt::format(
+                R"({{"jsonrpc":"2.0","id":{},"result":)"
+                R"({{"bids":[[42000.5,1.25]],"asks":[[42001.0,0.5]]}}}})",
+                id);
+            state.ResumeTiming();
+
+            map.async_complete(boost::json::parse(text));
+            ioc.restart();
+            ioc.poll();
+        }
+        benchmark::DoNotOptimize(received);
+    }
+
+    BENCHMARK(request_map_build)->Name("json_rpc/request_map/build");
+    BENCHMARK(request_map_parse)->Name("json_rpc/request_map/parse");
+}   // namespace
@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <notstd/util/latency_histogram.hpp>
+
+namespace notstd::util
+{
+    namespace
+    {
+        auto bucket_of(latency_histogram::duration d) -> std::size_t
+        {
+            using std::chrono::microseconds;
+            auto const us = std::chrono::duration_cast< microseconds >(d);
+            if (us.count() <= 0)
+                return 0;
+            return std::min(
+                std::size_t(std::bit_width(std::uint64_t(us.count()))),
+                latency_histogram::bucket_count - 1);
+        }
+    }   // namespace
+
+    auto latency_histogram::record(duration d) -> void
+    {
+        ++buckets_[bucket_of(d)];
+        ++count_;
+        total_ += d;
+        min_  = std::min(min_, d);
+        max_  = std::max(max_, d);
+        last_ = d;
+    }
+
+    auto latency_histogram::min() const -> duration
+    {
+        return count_ ? min_ : duration();
+    }
+
+    auto latency_histogram::mean() const -> duration
+    {
+        return count_ ? total_ / std::int64_t(count_) : duration();
+    }
+
+    auto latency_histogram::quantile(double q) const -> duration
+    {
+        if (count_ == 0)
+            return duration();
+
+        // the rank of the sample sought, counting from 1
+        auto const rank = std::max(
+            std::uint64_t(1),
+            std::uint64_t(std::ceil(std::clamp(q, 0.0, 1.0) * double(count_))));
+        auto seen = std::uint64_t(0);
+        for (std::size_t i = 0; i + 1 < bucket_count; ++i)
+        {
+            seen += buckets_[i];
+            if (seen >= rank)
+                return std::clamp(bucket_floor(i + 1), min(), max_);
+        }
+        return max_;
+    }
+
+    auto latency_histogram::bucket_floor(std::size_t i) -> duration
+    {
+        if (i == 0)
+            return duration();
+        return std::chrono::microseconds(std::int64_t(1) << (i - 1));
+    }
+
+    auto latency_histogram::reset() -> void
+    {
+        *this = latency_histogram();
+    }
+
+}   // namespace notstd::util
@@ -0,0 +1,59 @@
+#include <catch2/catch.hpp>
+#include <notstd/util/latency_histogram.hpp>
+
+using namespace notstd::util;
+using namespace std::literals;
+
+TEST_CASE("notstd::util::latency_histogram",
+          "[notstd::util::latency_histogram]")
+{
+    auto h = latency_histogram();
+
+    SECTION("an empty histogram reports zero")
+    {
+        CHECK(h.count() == 0);
+        CHECK(h.min() == 0s);
+        CHECK(h.max() == 0s);
+        CHECK(h.mean() == 0s);
+        CHECK(h.quantile(0.5) == 0s);
+    }
+
+    SECTION("samples are counted in power of two microsecond buckets")
+    {
+        h.record(500ns);
+        h.record(1us);
+        h.record(3us);
+        h.record(100us);
+        h.record(1h);
+
+        CHECK(h.count() == 5);
+        CHECK(h.buckets()[0] == 1);
+        CHECK(h.buckets()[1] == 1);
+        CHECK(h.buckets()[2] == 1);
+        CHECK(h.buckets()[7] == 1);
+        CHECK(h.buckets()[latency_histogram::bucket_count - 1] == 1);
+        CHECK(latency_histogram::bucket_floor(7) == 64us);
+        CHECK(h.min() == 500ns);
+        CHECK(h.max() == 1h);
+        CHECK(h.last() == 1h);
+    }
+
+    SECTION("quantiles are bounded by their bucket and the extremes")
+    {
+        for (int i = 0; i < 90; ++i)
+            h.record(100us);
+        for (int i = 0; i < 10; ++i)
+            h.record(5ms);
+
+        CHECK(h.quantile(0.0) == 128us);
+        CHECK(h.quantile(0.5) == 128us);
+        CHECK(h.quantile(0.9) == 128us);
+        CHECK(h.quantile(0.91) == 5ms);
+        CHECK(h.quantile(1.0) == 5ms);
+        CHECK(h.mean() == 590us);
+
+        h.reset();
+        CHECK(h.count() == 0);
+        CHECK(h.buckets()[7] == 0);
+    }
+}
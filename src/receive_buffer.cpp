@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <notstd/util/receive_buffer.hpp>
+
+namespace notstd::util
+{
+    receive_buffer::receive_buffer(receive_buffer_policy policy)
+    : policy_(policy)
+    {
+    }
+
+    auto receive_buffer::set_policy(receive_buffer_policy policy) -> void
+    {
+        policy_ = policy;
+    }
+
+    auto receive_buffer::reserve() -> void
+    {
+        buffer_.max_size(policy_.max_size);
+        buffer_.reserve(std::min(policy_.initial_reserve, policy_.max_size));
+        stats_.high_water = std::max(stats_.high_water, buffer_.capacity());
+        stats_.capacity   = buffer_.capacity();
+    }
+
+    auto receive_buffer::consume_all() -> void
+    {
+        auto const used     = buffer_.size();
+        auto const capacity = buffer_.capacity();
+        buffer_.consume(used);
+
+        if (capacity > stats_.capacity)
+        {
+            ++stats_.grows;
+            stats_.high_water = std::max(stats_.high_water, capacity);
+        }
+        stats_.capacity = capacity;
+
+        if (capacity > policy_.initial_reserve and
+            used * policy_.shrink_ratio < capacity)
+            ++underused_;
+        else
+            underused_ = 0;
+
+        if (policy_.shrink_after != 0 and underused_ >= policy_.shrink_after)
+            shrink();
+    }
+
+    auto receive_buffer::release() -> void
+    {
+        buffer_.clear();
+        buffer_.shrink_to_fit();
+        stats_.capacity = buffer_.capacity();
+        underused_      = 0;
+    }
+
+    auto receive_buffer::stats() const -> receive_buffer_stats
+    {
+        return stats_;
+    }
+
+    auto receive_buffer::shrink() -> void
+    {
+        release();
+        reserve();
+        ++stats_.shrinks;
+    }
+
+}   // namespace notstd::util
@@ -0,0 +1,70 @@
+#include <catch2/catch.hpp>
+#include <notstd/util/net.hpp>
+#include <notstd/util/receive_buffer.hpp>
+
+using namespace notstd::util;
+
+namespace
+{
+    auto read_message(receive_buffer &rx, std::size_t size) -> void
+    {
+        auto &buf = rx.buffer();
+        buf.prepare(size);
+        buf.commit(size);
+        rx.consume_all();
+    }
+}   // namespace
+
+TEST_CASE("notstd::util::receive_buffer", "[notstd::util::receive_buffer]")
+{
+    auto rx = receive_buffer(receive_buffer_policy { .initial_reserve = 1024,
+                                                     .shrink_after    = 3,
+                                                     .shrink_ratio    = 4 });
+    rx.reserve();
+    CHECK(rx.stats().capacity >= 1024);
+
+    SECTION("messages within the initial reserve do not reallocate")
+    {
+        auto const *storage = rx.buffer().data().data();
+        for (int i = 0; i < 10; ++i)
+            read_message(rx, 1000);
+        CHECK(rx.buffer().data().data() == storage);
+        CHECK(rx.stats().grows == 0);
+        CHECK(rx.stats().shrinks == 0);
+    }
+
+    SECTION("a large message grows the buffer, which shrinks once idle")
+    {
+        read_message(rx, 64 * 1024);
+        CHECK(rx.stats().grows == 1);
+        CHECK(rx.stats().capacity >= 64 * 1024);
+        CHECK(rx.stats().high_water >= 64 * 1024);
+
+        read_message(rx, 100);
+        read_message(rx, 100);
+        CHECK(rx.stats().shrinks == 0);
+        read_message(rx, 100);
+        CHECK(rx.stats().shrinks == 1);
+        CHECK(rx.stats().capacity < 64 * 1024);
+        CHECK(rx.stats().high_water >= 64 * 1024);
+    }
+
+    SECTION("a well used buffer is not shrunk")
+    {
+        read_message(rx, 64 * 1024);
+        for (int i = 0; i < 10; ++i)
+        {
+            read_message(rx, 100);
+            read_message(rx, 60 * 1024);
+        }
+        CHECK(rx.stats().shrinks == 0);
+    }
+
+    SECTION("release frees the storage but keeps the counters")
+    {
+        read_message(rx, 64 * 1024);
+        rx.release();
+        CHECK(rx.stats().capacity == 0);
+        CHECK(rx.stats().grows == 1);
+    }
+}
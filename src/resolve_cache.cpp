@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <utility>
+#include <notstd/util/resolve_cache.hpp>
+
+namespace notstd::util
+{
+    resolve_cache::resolve_cache(resolve_cache_options opts)
+    : options_(opts)
+    {
+    }
+
+    auto resolve_cache::key(std::string_view host, std::string_view port)
+        -> std::string
+    {
+        auto k = std::string(host);
+        k += ':';
+        k += port;
+        return k;
+    }
+
+    auto resolve_cache::find(std::string_view host,
+                             std::string_view port,
+                             waiter_type      waiter,
+                             bool &           leader)
+        -> std::optional< resolve_result >
+    {
+        auto const now  = clock_type::now();
+        auto       lock = std::lock_guard(mutex_);
+
+        leader = false;
+        auto it = entries_.find(key(host, port));
+        if (it != entries_.end())
+        {
+            auto &e = it->second;
+            if (e.result and now < e.expires)
+            {
+                ++stats_.hits;
+                return e.result;
+            }
+            if (e.in_flight)
+            {
+                ++stats_.coalesced;
+                e.waiters.push_back(std::move(waiter));
+                return std::nullopt;
+            }
+        }
+        else
+        {
+            if (entries_.size() >= options_.max_entries)
+                evict(now);
+            it = entries_.emplace(key(host, port), entry()).first;
+        }
+
+        ++stats_.misses;
+        it->second.in_flight = true;
+        leader               = true;
+        return std::nullopt;
+    }
+
+    auto resolve_cache::complete(std::string_view host,
+                                 std::string_view port,
+                                 resolve_result   result) -> void
+    {
+        auto const now     = clock_type::now();
+        auto       waiters = std::vector< waiter_type >();
+        {
+            auto lock = std::lock_guard(mutex_);
+            auto it   = entries_.find(key(host, port));
+            if (it == entries_.end())
+            {
+                // invalidated while in flight
+                if (entries_.size() >= options_.max_entries)
+                    evict(now);
+                it = entries_.emplace(key(host, port), entry()).first;
+            }
+
+            auto &e = it->second;
+            waiters.swap(e.waiters);
+            e.in_flight = false;
+
+            auto const ttl =
+                result.error ? options_.negative_ttl : options_.ttl;
+            if (result.error == net::error::operation_aborted or
+                ttl.count() <= 0)
+            {
+                if (not e.result)
+                    entries_.erase(it);
+            }
+            else
+            {
+                e.result  = result;
+                e.stored  = now;
+                e.expires = now + ttl;
+            }
+        }
+
+        for (auto &w : waiters)
+            w(result);
+    }
+
+    resolve_cache::leader_guard::leader_guard(resolve_cache &  cache,
+                                              std::string_view host,
+                                              std::string_view port)
+    : cache_(&cache)
+    , host_(host)
+    , port_(port)
+    {
+    }
+
+    resolve_cache::leader_guard::~leader_guard()
+    {
+        if (cache_)
+            cache_->complete(host_,
+                             port_,
+                             resolve_result {
+                                 .error   = net::error::operation_aborted,
+                                 .results = {} });
+    }
+
+    auto resolve_cache::leader_guard::complete(resolve_result result) -> void
+    {
+        auto *cache = std::exchange(cache_, nullptr);
+        cache->complete(host_, port_, std::move(result));
+    }
+
+    auto resolve_cache::invalidate(std::string_view host, std::string_view port)
+        -> void
+    {
+        auto lock = std::lock_guard(mutex_);
+        auto it   = entries_.find(key(host, port));
+        if (it == entries_.end())
+            return;
+        if (it->second.in_flight)
+            it->second.result.reset();
+        else
+            entries_.erase(it);
+    }
+
+    auto resolve_cache::invalidate_all() -> void
+    {
+        auto lock = std::lock_guard(mutex_);
+        for (auto it = entries_.begin(); it != entries_.end();)
+        {
+            if (it->second.in_flight)
+            {
+                it->second.result.reset();
+                ++it;
+            }
+            else
+                it = entries_.erase(it);
+        }
+    }
+
+    auto resolve_cache::stats() const -> resolve_cache_stats
+    {
+        auto lock = std::lock_guard(mutex_);
+        return stats_;
+    }
+
+    auto resolve_cache::evict(clock_type::time_point now) -> void
+    {
+        std::erase_if(entries_, [now](auto &kv) {
+            return not kv.second.in_flight and now >= kv.second.expires;
+        });
+        if (entries_.size() < options_.max_entries)
+            return;
+
+        auto oldest = entries_.end();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it)
+            if (not it->second.in_flight and
+                (oldest == entries_.end() or
+                 it->second.stored < oldest->second.stored))
+                oldest = it;
+        if (oldest != entries_.end())
+            entries_.erase(oldest);
+    }
+
+}   // namespace notstd::util
@@ -0,0 +1,124 @@
+#include <catch2/catch.hpp>
+#include <notstd/util/resolve_cache.hpp>
+#include <thread>
+
+using namespace notstd::util;
+using namespace std::literals;
+
+namespace
+{
+    auto addresses(std::string const &host, unsigned short port)
+        -> resolve_result
+    {
+        auto ep = net::ip::tcp::endpoint(net::ip::address_v4::loopback(), port);
+        return resolve_result {
+            .error   = {},
+            .results = resolve_result::results_type::create(
+                ep, host, std::to_string(port))
+        };
+    }
+}   // namespace
+
+TEST_CASE("notstd::util::resolve_cache")
+{
+    auto cache = resolve_cache(resolve_cache_options {
+        .ttl = 50ms, .negative_ttl = 20ms, .max_entries = 2 });
+
+    auto leader   = false;
+    auto received = std::vector< resolve_result >();
+    auto waiter   = [&](resolve_result r) { received.push_back(r); };
+
+    // the first lookup leads, the next waits for it
+    REQUIRE(not cache.find("a", "80", waiter, leader));
+    CHECK(leader);
+    REQUIRE(not cache.find("a", "80", waiter, leader));
+    CHECK(not leader);
+    CHECK(received.empty());
+
+    cache.complete("a", "80", addresses("a", 80));
+    REQUIRE(received.size() == 1);
+    CHECK(received[0].results.begin()->endpoint().port() == 80);
+
+    SECTION("a stored outcome is a hit until it expires")
+    {
+        auto hit = cache.find("a", "80", waiter, leader);
+        REQUIRE(hit);
+        CHECK(not leader);
+        CHECK(hit->results.size() == 1);
+
+        std::this_thread::sleep_for(60ms);
+        CHECK(not cache.find("a", "80", waiter, leader));
+        CHECK(leader);
+
+        auto stats = cache.stats();
+        CHECK(stats.hits == 1);
+        CHECK(stats.misses == 2);
+        CHECK(stats.coalesced == 1);
+    }
+
+    SECTION("failures are cached for the negative ttl")
+    {
+        REQUIRE(not cache.find("b", "80", waiter, leader));
+        cache.complete("b",
+                       "80",
+                       resolve_result { .error   = net::error::host_not_found,
+                                        .results = {} });
+        auto hit = cache.find("b", "80", waiter, leader);
+        REQUIRE(hit);
+        CHECK(hit->error == net::error::host_not_found);
+
+        std::this_thread::sleep_for(30ms);
+        CHECK(not cache.find("b", "80", waiter, leader));
+        CHECK(leader);
+    }
+
+    SECTION("an aborted lookup is passed on but not stored")
+    {
+        REQUIRE(not cache.find("b", "80", waiter, leader));
+        REQUIRE(not cache.find("b", "80", waiter, leader));
+        cache.complete("b",
+                       "80",
+                       resolve_result { .error = net::error::operation_aborted,
+                                        .results = {} });
+        REQUIRE(received.size() == 2);
+        CHECK(received[1].error == net::error::operation_aborted);
+
+        // the waiter may now lead
+        CHECK(not cache.find("b", "80", waiter, leader));
+        CHECK(leader);
+    }
+
+    SECTION("invalidate forgets an outcome")
+    {
+        cache.invalidate("a", "80");
+        CHECK(not cache.find("a", "80", waiter, leader));
+        CHECK(leader);
+    }
+
+    SECTION("invalidate_all leaves lookups in flight alone")
+    {
+        REQUIRE(not cache.find("b", "80", waiter, leader));
+        cache.invalidate_all();
+        CHECK(not cache.find("a", "80", waiter, leader));
+        CHECK(leader);
+
+        // b is still in flight, so this waits
+        CHECK(not cache.find("b", "80", waiter, leader));
+        CHECK(not leader);
+        cache.complete("b", "80", addresses("b", 81));
+        CHECK(received.size() == 2);
+        CHECK(cache.find("b", "80", waiter, leader));
+    }
+
+    SECTION("the oldest entry makes way when full")
+    {
+        REQUIRE(not cache.find("b", "80", waiter, leader));
+        cache.complete("b", "80", addresses("b", 81));
+        REQUIRE(not cache.find("c", "80", waiter, leader));
+        cache.complete("c", "80", addresses("c", 82));
+
+        CHECK(not cache.find("a", "80", waiter, leader));
+        CHECK(leader);
+        CHECK(cache.find("c", "80", waiter, leader));
+    }
+}
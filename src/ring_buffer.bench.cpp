@@ -0,0 +1,76 @@
+#include "testing/allocation_counter.hpp"
+
+#include <benchmark/benchmark.h>
+#include <deque>
+#include <notstd/util/json.hpp>
+#include <notstd/util/ring_buffer.hpp>
+#include <string>
+#include <vector>
+
+using namespace notstd::util;
+using notstd::util::testing::allocation_counter;
+
+namespace
+{
+    struct small_pod
+    {
+        int    id;
+        double price;
+    };
+
+    template < class T >
+    auto make_value(std::size_t i) -> T
+    {
+        if constexpr (std::is_same_v< T, small_pod >)
+            return small_pod { int(i), double(i) };
+        else
+            // long enough to defeat the small string optimisation
+            return T(std::string(32, char('a' + i % 26)).c_str());
+    }
+
+    // push then pop a burst of state.range(0) values, as a queue does when a
+    // producer outpaces its consumer for a while
+    template < class Container >
+    void container_push_pop(benchmark::State &state)
+    {
+        using value_type = typename Container::value_type;
+
+        auto const burst = std::size_t(state.range(0));
+        auto       c     = Container();
+
+        // values are moved in and out so that only the container allocates
+        auto values = std::vector< value_type >();
+        for (std::size_t i = 0; i < burst; ++i)
+            values.push_back(make_value< value_type >(i));
+
+        auto counter = allocation_counter(state);
+        for (auto _ : state)
+        {
+            for (auto &v : values)
+                c.push_back(std::move(v));
+            for (auto &v : values)
+            {
+                v = std::move(c.front());
+                c.pop_front();
+            }
+            benchmark::DoNotOptimize(values.data());
+        }
+        state.SetItemsProcessed(state.iterations() * burst);
+    }
+
+#define NOTSTD_CONTAINER_BENCHMARK(T)                                        \
+    BENCHMARK_TEMPLATE(container_push_pop, std::deque< T >)                  \
+        ->Name("std::deque<" #T ">/push_pop")                                \
+        ->Arg(8)                                                             \
+        ->Arg(1024);                                                         \
+    BENCHMARK_TEMPLATE(container_push_pop, ring_buffer< T >)                 \
+        ->Name("ring_buffer<" #T ">/push_pop")                               \
+        ->Arg(8)                                                             \
+        ->Arg(1024);
+
+    NOTSTD_CONTAINER_BENCHMARK(small_pod)
+    NOTSTD_CONTAINER_BENCHMARK(std::string)
+    NOTSTD_CONTAINER_BENCHMARK(json::string)
+
+#undef NOTSTD_CONTAINER_BENCHMARK
+}   // namespace
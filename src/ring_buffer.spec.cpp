@@ -0,0 +1,96 @@
+#include "testing/allocation_count.hpp"
+
+#include <catch2/catch.hpp>
+#include <notstd/util/ring_buffer.hpp>
+#include <queue>
+#include <string>
+#include <vector>
+
+using namespace notstd::util;
+
+TEST_CASE("notstd::util::ring_buffer", "[notstd::util::ring_buffer]")
+{
+    auto rb = ring_buffer< std::string >();
+    CHECK(rb.empty());
+    CHECK(rb.capacity() == 0);
+
+    auto contents = [&] {
+        return std::vector< std::string >(rb.begin(), rb.end());
+    };
+
+    SECTION("fifo order across wrap and growth")
+    {
+        // advance the head so that growth happens on a wrapped ring
+        for (int i = 0; i < 10; ++i)
+        {
+            rb.push_back(std::to_string(i));
+            rb.pop_front();
+        }
+        for (int i = 0; i < 40; ++i)
+            rb.push_back(std::to_string(i));
+        CHECK(rb.size() == 40);
+        CHECK(rb.capacity() == 64);
+
+        for (int i = 0; i < 40; ++i)
+        {
+            REQUIRE(rb.front() == std::to_string(i));
+            rb.pop_front();
+        }
+        CHECK(rb.empty());
+        CHECK(rb.capacity() == 64);
+    }
+
+    SECTION("push of own element during growth")
+    {
+        rb.push_back("a");
+        for (int i = 0; i < 20; ++i)
+            rb.push_back(rb.front());
+        CHECK(rb.size() == 21);
+        CHECK(rb.back() == "a");
+    }
+
+    SECTION("copy and move")
+    {
+        rb.push_back("a");
+        rb.push_back("b");
+        auto copy = rb;
+        CHECK(std::vector< std::string >(copy.begin(), copy.end()) ==
+              contents());
+
+        auto moved = std::move(copy);
+        CHECK(copy.empty());
+        CHECK(moved.size() == 2);
+        CHECK(moved.front() == "a");
+
+        rb = std::move(moved);
+        CHECK(contents() == std::vector< std::string > { "a", "b" });
+    }
+
+    SECTION("clear retains capacity")
+    {
+        for (int i = 0; i < 17; ++i)
+            rb.emplace_back(10, 'x');
+        rb.clear();
+        CHECK(rb.empty());
+        CHECK(rb.capacity() == 32);
+    }
+
+    SECTION("steady state does not allocate")
+    {
+        auto q = std::queue< int, ring_buffer< int > >();
+        for (int i = 0; i < 100; ++i)
+            q.push(i);
+        while (not q.empty())
+            q.pop();
+
+        auto before = testing::allocation_count();
+        for (int burst = 0; burst < 10; ++burst)
+        {
+            for (int i = 0; i < 100; ++i)
+                q.push(i);
+            while (not q.empty())
+                q.pop();
+        }
+        CHECK(testing::allocation_count() == before);
+    }
+}
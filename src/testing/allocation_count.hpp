@@ -0,0 +1,10 @@
+#pragma once
+#include <cstddef>
+
+namespace notstd::util::testing
+{
+    /// The number of calls to the global operator new made by this process
+    /// so far. Tests and benchmarks sample this before and after a run to
+    /// report allocations per operation.
+    auto allocation_count() noexcept -> std::size_t;
+}   // namespace notstd::util::testing
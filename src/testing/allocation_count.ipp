@@ -0,0 +1,49 @@
+// Replaces the global allocation functions with counting versions. Included
+// once into each executable which needs testing::allocation_count()
+#include "allocation_count.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace notstd::util::testing
+{
+    namespace
+    {
+        std::atomic< std::size_t > allocations { 0 };
+    }
+
+    auto allocation_count() noexcept -> std::size_t
+    {
+        return allocations.load(std::memory_order_relaxed);
+    }
+}   // namespace notstd::util::testing
+
+void *operator new(std::size_t size)
+{
+    notstd::util::testing::allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) { return ::operator new(size); }
+
+void *operator new(std::size_t size, std::align_val_t align)
+{
+    notstd::util::testing::allocations.fetch_add(1, std::memory_order_relaxed);
+    auto a = static_cast< std::size_t >(align);
+    if (auto p = std::aligned_alloc(a, (size + a - 1) / a * a))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
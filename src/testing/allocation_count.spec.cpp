@@ -0,0 +1 @@
+#include "allocation_count.ipp"
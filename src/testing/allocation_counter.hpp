@@ -0,0 +1,33 @@
+#pragma once
+#include "testing/allocation_count.hpp"
+
+#include <benchmark/benchmark.h>
+
+namespace notstd::util::testing
+{
+    /// Reports the mean number of global heap allocations per benchmark
+    /// iteration as the counter "allocs_per_op", sampled over the lifetime of
+    /// this object
+    struct allocation_counter
+    {
+        explicit allocation_counter(benchmark::State &state)
+        : state_(state)
+        , start_(allocation_count())
+        {
+        }
+
+        allocation_counter(allocation_counter const &) = delete;
+        allocation_counter &operator=(allocation_counter const &) = delete;
+
+        ~allocation_counter()
+        {
+            state_.counters["allocs_per_op"] =
+                benchmark::Counter(double(allocation_count() - start_),
+                                   benchmark::Counter::kAvgIterations);
+        }
+
+      private:
+        benchmark::State &state_;
+        std::size_t       start_;
+    };
+}   // namespace notstd::util::testing
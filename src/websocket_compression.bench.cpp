@@ -0,0 +1,147 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <limits>
+#include <notstd/util/websocket_compression.hpp>
+#include <string>
+#include <vector>
+
+using namespace notstd::util;
+
+namespace
+{
+    using executor_type = net::io_context::executor_type;
+    using socket_type = net::basic_stream_socket< net::ip::tcp, executor_type >;
+
+    // counts the bytes a beast::basic_stream reads, without limiting them
+    struct counting_rate_policy
+    {
+        auto available_read_bytes() const -> std::size_t
+        {
+            return std::numeric_limits< std::size_t >::max();
+        }
+        auto available_write_bytes() const -> std::size_t
+        {
+            return std::numeric_limits< std::size_t >::max();
+        }
+        void transfer_read_bytes(std::size_t n) { read += n; }
+        void transfer_write_bytes(std::size_t) {}
+        void on_timer() {}
+
+        std::size_t read = 0;
+    };
+
+    using counting_stream = beast::
+        basic_stream< net::ip::tcp, executor_type, counting_rate_policy >;
+
+    // a market data update of roughly the given size. Prices and quantities
+    // vary from message to message, the structure and keys do not
+    auto make_json(std::size_t size, std::uint32_t &seed) -> std::string
+    {
+        auto next = [&seed] {
+            seed = seed * 1664525u + 1013904223u;
+            return seed >> 8;
+        };
+        auto s = std::string(R"({"type":"l2update","product_id":"BTC-USD",)");
+        s += R"("time":"2024-03-01T12:00:)" + std::to_string(next() % 60) +
+             R"(.)" + std::to_string(next() % 1000000) + R"(Z","changes":[)";
+        auto first = true;
+        while (s.size() + 40 < size)
+        {
+            if (not first)
+                s += ',';
+            first = false;
+            s += next() % 2 ? R"(["buy",")" : R"(["sell",")";
+            s += std::to_string(60000 + next() % 1000) + '.' +
+                 std::to_string(next() % 100) + R"(",")";
+            s += "0." + std::to_string(next() % 100000000) + R"("])";
+        }
+        s += "]}";
+        return s;
+    }
+
+    // JSON messages of state.range(0) bytes sent over a loopback websocket
+    // at deflate level state.range(1), or uncompressed if it is negative.
+    // state.range(2) is non-zero to keep the window between messages.
+    // Reports the bytes on the wire as a fraction of the payload
+    void websocket_compression_json(benchmark::State &state)
+    {
+        auto const size     = std::size_t(state.range(0));
+        auto const level    = int(state.range(1));
+        auto const takeover = state.range(2) != 0;
+
+        auto opts             = compression_options();
+        opts.enable           = level >= 0;
+        opts.level            = level >= 0 ? level : 0;
+        opts.context_takeover = takeover;
+
+        auto ioc      = net::io_context(1);
+        auto work     = net::make_work_guard(ioc);
+        auto acceptor = net::ip::tcp::acceptor(
+            ioc, net::ip::tcp::endpoint(net::ip::address_v4::loopback(), 0));
+        auto client = websocket::stream< socket_type >(ioc.get_executor());
+        auto server = websocket::stream< counting_stream >(ioc.get_executor());
+        client.set_option(to_permessage_deflate(opts));
+        server.set_option(to_permessage_deflate(opts));
+
+        client.next_layer().connect(acceptor.local_endpoint());
+        acceptor.accept(server.next_layer().socket());
+        client.next_layer().set_option(net::ip::tcp::no_delay(true));
+        server.next_layer().socket().set_option(net::ip::tcp::no_delay(true));
+        auto accepted  = false;
+        auto handshake = false;
+        server.async_accept([&](error_code) { accepted = true; });
+        client.async_handshake("localhost", "/", [&](error_code) {
+            handshake = true;
+        });
+        while (not accepted or not handshake)
+            ioc.run_one();
+
+        auto seed     = std::uint32_t(42);
+        auto messages = std::vector< std::string >(64);
+        for (auto &m : messages)
+            m = make_json(size, seed);
+
+        auto &wire    = server.next_layer().rate_policy().read;
+        auto  before  = wire;
+        auto  payload = std::size_t(0);
+        auto  rxbuf   = beast::flat_buffer();
+        auto  i       = std::size_t(0);
+        for (auto _ : state)
+        {
+            auto const &m    = messages[i++ % messages.size()];
+            auto        done = 0;
+            client.async_write(net::buffer(m), [&](error_code, std::size_t) {
+                ++done;
+            });
+            server.async_read(rxbuf, [&](error_code ec, std::size_t) {
+                if (ec)
+                    state.SkipWithError("read failed");
+                ++done;
+            });
+            while (done < 2)
+                ioc.run_one();
+            rxbuf.consume(rxbuf.size());
+            payload += m.size();
+        }
+
+        state.SetBytesProcessed(std::int64_t(payload));
+        state.counters["wire_ratio"] =
+            payload ? double(wire - before) / double(payload) : 0.0;
+    }
+
+    void json_arguments(benchmark::internal::Benchmark *b)
+    {
+        for (auto size : { 512, 16 * 1024 })
+        {
+            for (auto level : { -1, 1, 6, 9 })
+                b->Args({ size, level, 1 });
+            b->Args({ size, 6, 0 });
+        }
+    }
+
+    BENCHMARK(websocket_compression_json)
+        ->Name("websocket_compression/json")
+        ->ArgNames({ "size", "level", "takeover" })
+        ->Apply(json_arguments)
+        ->UseRealTime();
+}   // namespace
@@ -0,0 +1,31 @@
+#include <notstd/util/websocket_compression.hpp>
+
+namespace notstd::util
+{
+    namespace
+    {
+        template < class Option >
+        auto set_threshold(Option &pmd, std::size_t threshold) -> void
+        {
+            if constexpr (requires { pmd.msg_size_threshold; })
+                pmd.msg_size_threshold = threshold;
+        }
+    }   // namespace
+
+    auto to_permessage_deflate(compression_options const &opts)
+        -> websocket::permessage_deflate
+    {
+        auto pmd                       = websocket::permessage_deflate();
+        pmd.client_enable              = opts.enable;
+        pmd.server_enable              = opts.enable;
+        pmd.client_max_window_bits     = opts.window_bits;
+        pmd.server_max_window_bits     = opts.window_bits;
+        pmd.client_no_context_takeover = not opts.context_takeover;
+        pmd.server_no_context_takeover = not opts.context_takeover;
+        pmd.compLevel                  = opts.level;
+        pmd.memLevel                   = opts.memory_level;
+        set_threshold(pmd, opts.threshold);
+        return pmd;
+    }
+
+}   // namespace notstd::util
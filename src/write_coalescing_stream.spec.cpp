@@ -0,0 +1,215 @@
+#include <catch2/catch.hpp>
+#include <notstd/util/write_coalescing_stream.hpp>
+#include <string>
+#include <vector>
+
+using namespace notstd::util;
+
+namespace
+{
+    // a next layer which records the data of each write it is given
+    struct recording_stream
+    {
+        using executor_type = net::io_context::executor_type;
+
+        recording_stream(executor_type exec)
+        : exec_(exec)
+        {
+        }
+
+        auto get_executor() -> executor_type { return exec_; }
+
+        template < class ConstBufferSequence, class WriteHandler >
+        auto async_write_some(ConstBufferSequence const &buffers,
+                              WriteHandler &&            handler)
+        {
+            auto data = std::string(net::buffer_size(buffers), '\0');
+            net::buffer_copy(net::buffer(data), buffers);
+            if (not fail)
+                writes.push_back(data);
+            net::post(exec_,
+                      beast::bind_front_handler(
+                          std::forward< WriteHandler >(handler),
+                          fail,
+                          fail ? 0 : data.size()));
+        }
+
+        executor_type              exec_;
+        std::vector< std::string > writes;
+
+        // when set, every write fails with it
+        error_code fail;
+    };
+}   // namespace
+
+TEST_CASE("notstd::util::write_coalescing_stream",
+          "[notstd::util::write_coalescing_stream]")
+{
+    auto ioc    = net::io_context(1);
+    auto stream = write_coalescing_stream< recording_stream >(
+        ioc.get_executor());
+    auto &writes = stream.next_layer().writes;
+
+    auto completions = std::vector< std::size_t >();
+    auto expected    = error_code();
+    auto write       = [&](std::string const &s) {
+        stream.async_write_some(net::buffer(s),
+                                [&](error_code ec, std::size_t n) {
+                                    CHECK(ec == expected);
+                                    completions.push_back(n);
+                                });
+        ioc.restart();
+        ioc.poll();
+    };
+
+    SECTION("uncorked writes pass straight through")
+    {
+        write("a");
+        write("bc");
+        CHECK(writes == std::vector< std::string > { "a", "bc" });
+        CHECK(completions == std::vector< std::size_t > { 1, 2 });
+    }
+
+    SECTION("corked writes are held until the first uncorked write")
+    {
+        stream.cork(1024);
+        write("a");
+        write("bc");
+        CHECK(writes.empty());
+        CHECK(completions == std::vector< std::size_t > { 1, 2 });
+
+        stream.uncork();
+        write("def");
+        CHECK(writes == std::vector< std::string > { "abcdef" });
+        CHECK(completions == std::vector< std::size_t > { 1, 2, 3 });
+
+        write("g");
+        CHECK(writes == std::vector< std::string > { "abcdef", "g" });
+    }
+
+    SECTION("a write which would exceed the limit sends the held bytes")
+    {
+        stream.cork(4);
+        write("ab");
+        write("cd");
+        write("ef");
+        CHECK(writes == std::vector< std::string > { "abcdef" });
+        CHECK(stream.corked());
+
+        write("gh");
+        CHECK(writes.size() == 1);
+    }
+
+    SECTION("a control frame is sent at once, behind the held bytes")
+    {
+        stream.cork(1024);
+        write("ab");
+        write("\x8a\x00");
+        CHECK(writes == std::vector< std::string > { "ab\x8a\x00" });
+        CHECK(stream.pending() == 0);
+        CHECK(stream.corked());
+
+        write("cd");
+        CHECK(writes.size() == 1);
+        CHECK(stream.pending() == 2);
+    }
+
+    SECTION("held bytes are kept when they fail to send")
+    {
+        stream.cork(1024);
+        write("ab");
+        stream.next_layer().fail = net::error::broken_pipe;
+        stream.uncork();
+        expected = net::error::broken_pipe;
+        write("cd");
+        CHECK(completions.back() == 0);
+        CHECK(stream.pending() == 2);
+
+        // the failure sticks, even once the next layer recovers
+        stream.next_layer().fail = {};
+        write("ef");
+        CHECK(completions.size() == 3);
+        CHECK(writes.empty());
+
+        stream.discard();
+        CHECK(stream.pending() == 0);
+    }
+}
+
+TEST_CASE("notstd::util::write_coalescing_stream preserves websocket messages",
+          "[notstd::util::write_coalescing_stream]")
+{
+    auto ioc      = net::io_context(1);
+    auto acceptor = net::ip::tcp::acceptor(
+        ioc, net::ip::tcp::endpoint(net::ip::address_v4::loopback(), 0));
+
+    auto client = websocket::stream<
+        write_coalescing_stream< net::ip::tcp::socket > >(ioc);
+    auto server = websocket::stream< net::ip::tcp::socket >(ioc);
+
+    beast::get_lowest_layer(client).connect(acceptor.local_endpoint());
+    acceptor.accept(server.next_layer());
+    server.async_accept([](error_code ec) { REQUIRE(not ec); });
+    client.async_handshake("localhost", "/", [](error_code ec) {
+        REQUIRE(not ec);
+    });
+    ioc.run();
+
+    auto const sent = std::vector< std::string > { "one", "two", "three" };
+
+    auto i = std::size_t(0);
+    auto send = [&](auto &self) -> void {
+        if (i == sent.size())
+            return;
+        if (i == 0)
+            client.next_layer().cork(1024);
+        if (i + 1 == sent.size())
+            client.next_layer().uncork();
+        client.async_write(net::buffer(sent[i]),
+                           [&](error_code ec, std::size_t) {
+                               REQUIRE(not ec);
+                               ++i;
+                               self(self);
+                           });
+    };
+    send(send);
+
+    auto received = std::vector< std::string >();
+    auto rxbuf    = beast::flat_buffer();
+    auto receive  = [&](auto &self) -> void {
+        server.async_read(rxbuf, [&](error_code ec, std::size_t) {
+            REQUIRE(not ec);
+            received.push_back(beast::buffers_to_string(rxbuf.data()));
+            rxbuf.consume(rxbuf.size());
+            if (received.size() < sent.size())
+                self(self);
+        });
+    };
+    receive(receive);
+
+    ioc.restart();
+    ioc.run();
+    CHECK(received == sent);
+
+    // a close written while corked is not held back with the message
+    // before it
+    client.next_layer().cork(1024);
+    client.async_write(net::buffer(sent[0]), [&](error_code ec, std::size_t) {
+        REQUIRE(not ec);
+        client.async_close(websocket::close_code::normal,
+                           [](error_code ec) { CHECK(not ec); });
+    });
+
+    auto closed = error_code();
+    server.async_read(rxbuf, [&](error_code ec, std::size_t) {
+        REQUIRE(not ec);
+        received.push_back(beast::buffers_to_string(rxbuf.data()));
+        server.async_read(rxbuf,
+                          [&](error_code ec, std::size_t) { closed = ec; });
+    });
+
+    ioc.restart();
+    ioc.run();
+    CHECK(received.back() == sent[0]);
+    CHECK(closed == websocket::error::closed);
+}